@@ -0,0 +1,161 @@
+#include "bench.hpp"
+
+#include "BuzHash.hpp"
+#include "ChunkingPolicy.hpp"
+#include "Delta.hpp"
+#include "MersenneRKFinger.hpp"
+#include "RK_finger.hpp"
+#include "RabinFinger.hpp"
+#include "Signature.hpp"
+#include "blake.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char* OLD_FILE = "bench_boundary_old";
+const char* NEW_FILE = "bench_boundary_new";
+const char* DELTA_FILE = "bench_boundary_delta";
+
+struct Corpus {
+	const char* name;
+	std::vector<uint8_t> old_data;
+	std::vector<uint8_t> new_data;
+};
+
+std::vector<uint8_t> random_bytes(size_t size, std::mt19937_64& rng)
+{
+	std::vector<uint8_t> data(size);
+	for (auto& b : data)
+		b = static_cast<uint8_t>(rng());
+	return data;
+}
+
+// Application log: lines differ only in timestamps, counters and a few fields.
+std::vector<uint8_t> log_data(size_t size, std::mt19937_64& rng)
+{
+	static const char* LEVELS[] = { "INFO ", "INFO ", "INFO ", "DEBUG", "WARN " };
+	std::string text;
+	text.reserve(size + 128);
+	for (uint64_t line = 0; text.size() < size; line++) {
+		char buffer[128];
+		const int length = std::snprintf(buffer, sizeof(buffer),
+			"2026-10-17 12:%02u:%02u.%03u %s worker-%u request %llu completed in %u ms\n",
+			unsigned(line / 60000 % 60), unsigned(line / 1000 % 60), unsigned(line % 1000),
+			LEVELS[rng() % 5], unsigned(rng() % 8), static_cast<unsigned long long>(100000 + line), unsigned(rng() % 200));
+		text.append(buffer, static_cast<size_t>(length));
+	}
+	text.resize(size);
+	return std::vector<uint8_t>(text.begin(), text.end());
+}
+
+// Sparse disk image: zero-filled with scattered 4 KiB blocks of data.
+std::vector<uint8_t> sparse_data(size_t size, std::mt19937_64& rng)
+{
+	std::vector<uint8_t> data(size, 0);
+	for (size_t block = 0; block + 4096 <= size; block += 4096) {
+		if (rng() % 4 == 0) {
+			for (size_t i = 0; i < 4096; i++)
+				data[block + i] = static_cast<uint8_t>(rng());
+		}
+	}
+	return data;
+}
+
+// New version: a few insertions, overwrites and deletions at random places.
+std::vector<uint8_t> edit(const std::vector<uint8_t>& data, std::mt19937_64& rng)
+{
+	std::vector<uint8_t> out = data;
+	for (int i = 0; i < 16 && !out.empty(); i++) {
+		const size_t pos = rng() % out.size();
+		const size_t length = 1 + rng() % 2000;
+		switch (i % 3) {
+			case 0: {
+				auto inserted = random_bytes(length, rng);
+				out.insert(out.begin() + pos, inserted.begin(), inserted.end());
+				break;
+			}
+			case 1:
+				for (size_t k = pos; k < std::min(out.size(), pos + length); k++)
+					out[k] = static_cast<uint8_t>(rng());
+				break;
+			default:
+				out.erase(out.begin() + pos, out.begin() + std::min(out.size(), pos + length));
+				break;
+		}
+	}
+	return out;
+}
+
+void write_file(const char* path, const std::vector<uint8_t>& data)
+{
+	std::ofstream f(path, std::ios::binary);
+	f.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+}
+
+// Prints one row; delta size is also given relative to the baseline (two-byte) delta.
+// Returns the delta size.
+template <class T, class P>
+size_t measure(const char* corpus, const char* mode, size_t baseline_bytes)
+{
+	Signature<T, BLAKE512, P> old_sig, new_sig;
+	old_sig.generate_signatures(OLD_FILE);
+	new_sig.generate_signatures(NEW_FILE);
+
+	Delta<T, BLAKE512, P> delta;
+	delta.set_super_chunk_threshold(0);						// match shifted chunks regardless of corpus size
+	const auto result = delta.generate_delta(old_sig, new_sig, OLD_FILE, NEW_FILE, DELTA_FILE);
+	const auto& stats = old_sig.get_stats();
+	const size_t bytes = result.success ? result.bytes_written : 0;
+	const size_t baseline = baseline_bytes ? baseline_bytes : bytes;
+
+	std::cout << std::left << std::setw(8) << corpus << std::setw(16) << mode << std::right << std::fixed
+	          << std::setprecision(1) << std::setw(12) << stats.throughput_mib_s()
+	          << std::setw(10) << stats.chunk_count << std::setw(10) << stats.average_chunk_size()
+	          << std::setw(10) << 100.0 * double(stats.forced_cuts) / double(std::max<size_t>(stats.chunk_count, 1))
+	          << std::setw(12) << bytes
+	          << std::setw(10) << 100.0 * double(bytes) / double(std::max<size_t>(baseline, 1))
+	          << std::setw(10) << 100.0 * result.stats.matched_ratio() << std::endl;
+	return bytes;
+}
+
+} // namespace
+
+void run_boundary_bench(size_t corpus_bytes)
+{
+	std::mt19937_64 rng(0xB0DA);
+	std::vector<Corpus> corpora;
+	corpora.push_back({ "random", random_bytes(corpus_bytes, rng), {} });
+	corpora.push_back({ "log", log_data(corpus_bytes, rng), {} });
+	corpora.push_back({ "sparse", sparse_data(corpus_bytes, rng), {} });
+	for (auto& corpus : corpora)
+		corpus.new_data = edit(corpus.old_data, rng);
+
+	std::cout << "Boundary modes: " << corpus_bytes << " bytes per corpus, 16 edits, default chunk size" << std::endl;
+	std::cout << "(fingerprint boundaries use the windowed hash itself, RKFinger a separate one; delta % is relative to two-byte)" << std::endl;
+	std::cout << std::left << std::setw(8) << "corpus" << std::setw(16) << "boundary" << std::right
+	          << std::setw(12) << "MiB/s" << std::setw(10) << "chunks" << std::setw(10) << "avg"
+	          << std::setw(10) << "forced %" << std::setw(12) << "delta B" << std::setw(10) << "delta %"
+	          << std::setw(10) << "matched %" << std::endl;
+
+	using FP = DefaultFingerprintChunkingPolicy;
+	for (const auto& corpus : corpora) {
+		write_file(OLD_FILE, corpus.old_data);
+		write_file(NEW_FILE, corpus.new_data);
+		const size_t baseline = measure<RKFinger, DefaultChunkingPolicy>(corpus.name, "two-byte", 0);
+		measure<RKFinger, FP>(corpus.name, "fp-rkfinger", baseline);
+		measure<MersenneRKFinger, FP>(corpus.name, "fp-mersenne", baseline);
+		measure<BuzHash, FP>(corpus.name, "fp-buzhash", baseline);
+		measure<RabinFinger, FP>(corpus.name, "fp-rabin", baseline);
+	}
+
+	for (const auto* path : { OLD_FILE, NEW_FILE, DELTA_FILE })
+		std::remove(path);
+}
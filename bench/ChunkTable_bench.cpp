@@ -0,0 +1,130 @@
+#include "bench.hpp"
+
+#include "ChunkTable.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+constexpr size_t HASH_SIZE = 64;
+
+using Table = ChunkTable<uint64_t, HASH_SIZE>;
+
+// Chunk list layout used before ChunkTable: one heap-allocated hash per chunk.
+struct LegacyChunk {
+	uint64_t signature;
+	std::vector<uint8_t> hash;
+	size_t start_offset;
+	size_t chunk_size;
+
+	bool operator==(const LegacyChunk& rhs) const {
+		return signature == rhs.signature && hash == rhs.hash && chunk_size == rhs.chunk_size;
+	}
+};
+
+struct LegacyChunkHash {
+	size_t operator()(const LegacyChunk& chunk) const {
+		size_t h2 = 0;
+		std::memcpy(&h2, chunk.hash.data(), sizeof(h2));
+		return std::hash<uint64_t>{}(chunk.signature) ^ (h2 << 1);
+	}
+};
+
+struct Row {
+	const char* name;
+	double list_bytes;
+	double list_allocations;
+	double map_bytes;
+	double build_ms;
+	double lookup_ms;
+};
+
+void print_row(const Row& row)
+{
+	std::cout << std::left << std::setw(14) << row.name << std::right << std::fixed << std::setprecision(1)
+	          << std::setw(12) << row.list_bytes << std::setw(12) << row.list_allocations
+	          << std::setw(12) << row.map_bytes << std::setw(12) << row.build_ms
+	          << std::setw(12) << row.lookup_ms << std::endl;
+}
+
+template <class List, class Map, class Fill, class Get>
+Row measure(const char* name, size_t chunk_count, Fill fill, Get get)
+{
+	Row row{ name, 0, 0, 0, 0, 0 };
+	const size_t bytes_before = bench_live_bytes();
+	const size_t allocations_before = bench_allocations();
+	List list;
+	fill(list);
+	row.list_bytes = double(bench_live_bytes() - bytes_before) / chunk_count;
+	row.list_allocations = double(bench_allocations() - allocations_before) / chunk_count;
+
+	const size_t map_before = bench_live_bytes();
+	Map map;
+	row.build_ms = bench_time_ms([&] {
+		map.reserve(chunk_count);
+		for (size_t i = 0; i < chunk_count; i++)
+			map.emplace(get(list, i), i);
+	});
+	row.map_bytes = double(bench_live_bytes() - map_before) / chunk_count;
+
+	size_t found = 0;
+	row.lookup_ms = bench_time_ms([&] {
+		for (size_t i = 0; i < chunk_count; i++)
+			found += map.find(get(list, (i * 7919) % chunk_count)) != map.end();
+	});
+	if (found != chunk_count)
+		std::cout << "lookup mismatch in " << name << std::endl;
+	return row;
+}
+
+} // namespace
+
+void run_chunk_table_bench(size_t chunk_count)
+{
+	// Same pseudo-random chunks for both layouts.
+	auto make_hash = [](size_t i, uint8_t* out) {
+		std::mt19937_64 rng(i);
+		for (size_t k = 0; k < HASH_SIZE; k += 8) {
+			const uint64_t v = rng();
+			std::memcpy(out + k, &v, 8);
+		}
+	};
+
+	auto legacy = measure<std::vector<LegacyChunk>, std::unordered_map<LegacyChunk, size_t, LegacyChunkHash>>(
+		"SignedChunk", chunk_count,
+		[&](std::vector<LegacyChunk>& list) {
+			list.reserve(chunk_count);
+			for (size_t i = 0; i < chunk_count; i++) {
+				LegacyChunk chunk{ i * 0x9E3779B97F4A7C15ull, std::vector<uint8_t>(HASH_SIZE), i * 8192, 8192 };
+				make_hash(i, chunk.hash.data());
+				list.push_back(std::move(chunk));
+			}
+		},
+		// Map keys are copies, as in Delta and Apply before ChunkTable.
+		[](const std::vector<LegacyChunk>& list, size_t i) -> const LegacyChunk& { return list[i]; });
+
+	auto table = measure<Table, std::unordered_map<Table::Ref, size_t, Table::RefHash>>(
+		"ChunkTable", chunk_count,
+		[&](Table& list) {
+			list.reserve(chunk_count);
+			Table::Hash hash;
+			for (size_t i = 0; i < chunk_count; i++) {
+				make_hash(i, hash.data());
+				list.push_back(i * 0x9E3779B97F4A7C15ull, hash, i * 8192, 8192);
+			}
+		},
+		[](const Table& list, size_t i) { return list[i]; });
+
+	std::cout << "Chunk table: " << chunk_count << " chunks, " << HASH_SIZE << "-byte hashes" << std::endl;
+	std::cout << std::left << std::setw(14) << "layout" << std::right << std::setw(12) << "B/chunk"
+	          << std::setw(12) << "allocs" << std::setw(12) << "map B/chunk" << std::setw(12) << "build ms"
+	          << std::setw(12) << "lookup ms" << std::endl;
+	print_row(legacy);
+	print_row(table);
+}
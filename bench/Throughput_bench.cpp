@@ -0,0 +1,243 @@
+#include "bench.hpp"
+
+#include "Apply.hpp"
+#include "BuzHash.hpp"
+#include "ByteCompare.hpp"
+#include "Delta.hpp"
+#include "GearHash.hpp"
+#include "MersenneRKFinger.hpp"
+#include "RK_finger.hpp"
+#include "RabinFinger.hpp"
+#include "Signature.hpp"
+#include "blake.h"
+#include "blake3.h"
+#include "xxh3.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char* OLD_FILE = "bench_throughput_old";
+const char* NEW_FILE = "bench_throughput_new";
+const char* DELTA_FILE = "bench_throughput_delta";
+const char* OUT_FILE = "bench_throughput_out";
+
+constexpr int REPEATS = 3;								// Best of REPEATS runs is reported
+
+struct Corpus {
+	const char* name;
+	std::vector<uint8_t> data;
+};
+
+std::vector<uint8_t> random_corpus(size_t size, std::mt19937_64& rng)
+{
+	std::vector<uint8_t> data(size);
+	for (auto& b : data)
+		b = static_cast<uint8_t>(rng());
+	return data;
+}
+
+// English-like text: words from a small vocabulary with Zipf-like frequencies.
+std::vector<uint8_t> text_corpus(size_t size, std::mt19937_64& rng)
+{
+	static const char* WORDS[] = { "the", "of", "and", "to", "in", "a", "is", "that", "for", "it",
+		"chunk", "delta", "signature", "rolling", "hash", "boundary", "file", "data", "window", "block" };
+	std::string text;
+	text.reserve(size + 16);
+	while (text.size() < size) {
+		const size_t word = std::min<size_t>(rng() % 8 * (rng() % 8) / 2, std::size(WORDS) - 1);
+		text += WORDS[word];
+		text += rng() % 12 ? ' ' : '\n';
+	}
+	text.resize(size);
+	return std::vector<uint8_t>(text.begin(), text.end());
+}
+
+// New version for delta benchmarks: one byte changed in every 4 KiB, so nearly every
+// chunk is stored as a diff against the old one.
+std::vector<uint8_t> modify(const std::vector<uint8_t>& data, std::mt19937_64& rng)
+{
+	std::vector<uint8_t> out = data;
+	for (size_t block = 0; block < out.size(); block += 4096)
+		out[block + rng() % std::min<size_t>(4096, out.size() - block)] ^= 0x5A;
+	return out;
+}
+
+void write_file(const char* path, const std::vector<uint8_t>& data)
+{
+	std::ofstream f(path, std::ios::binary);
+	f.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+}
+
+template <class F>
+double best_ms(F&& fn)
+{
+	double best = bench_time_ms(fn);
+	for (int i = 1; i < REPEATS; i++)
+		best = std::min(best, bench_time_ms(fn));
+	return best;
+}
+
+void print_row(const char* bench, const char* corpus, const std::string& variant, size_t bytes, double ms)
+{
+	std::cout << bench << ',' << corpus << ',' << variant << ',' << bytes << ',' << std::fixed << std::setprecision(3)
+	          << ms << ',' << (ms > 0 ? double(bytes) / 1e6 / ms : 0.0) << std::endl;
+}
+
+volatile uint64_t sink;
+
+template <class H>
+void rolling_row(const Corpus& corpus, const char* name, const H& prototype)
+{
+	const std::span<const uint8_t> data(corpus.data);
+	const unsigned int window = prototype.get_window_size();
+	const double ms = best_ms([&] {
+		H hash = prototype;
+		hash.initialize(data);
+		sink = hash.roll(data.subspan(window));
+	});
+	print_row("roll", corpus.name, name, data.size() - window, ms);
+}
+
+void rolling_rows(const Corpus& corpus)
+{
+	const std::span<const uint8_t> data(corpus.data);
+	const double ms = best_ms([&] {
+		RKFinger finger;
+		IRollingHash<uint64_t>& hash = finger;					// Per-byte virtual call, as before roll()
+		hash.initialize(data);
+		uint64_t value = 0;
+		for (size_t i = WINDOW_DEF_SIZE; i < data.size(); i++)
+			value = hash.compute_next(data[i]);
+		sink = value;
+	});
+	print_row("compute_next", corpus.name, "RKFinger", data.size() - WINDOW_DEF_SIZE, ms);
+
+	rolling_row(corpus, "RKFinger", RKFinger());
+	rolling_row(corpus, "StaticRKFinger", StaticRKFinger<>());
+	rolling_row(corpus, "MersenneRKFinger", MersenneRKFinger());
+	rolling_row(corpus, "BuzHash", BuzHash());
+	rolling_row(corpus, "RabinFinger", RabinFinger());
+	rolling_row(corpus, "GearHash", GearHash());
+}
+
+void blake_rows(const Corpus& corpus)
+{
+	for (size_t chunk : { size_t(64), size_t(1024), size_t(8192), size_t(65536), size_t(1024 * 1024) }) {
+		const size_t bytes = corpus.data.size() / chunk * chunk;
+		const double ms = best_ms([&] {
+			BLAKE512 blake;
+			std::array<uint8_t, BLAKE512::HASH_SIZE> out;
+			for (size_t offset = 0; offset < bytes; offset += chunk)
+				blake.hash(out, std::span<const uint8_t>(corpus.data).subspan(offset, chunk));
+			sink = out[0];
+		});
+		print_row("blake512", corpus.name, std::to_string(chunk), bytes, ms);
+	}
+
+	// Multi-buffer: chunks of equal size hashed BLAKE512::LANES at a time.
+	for (size_t chunk : { size_t(1024), size_t(8192), size_t(65536) }) {
+		const size_t count = corpus.data.size() / chunk;
+		std::vector<std::span<const uint8_t>> inputs;
+		for (size_t i = 0; i < count; i++)
+			inputs.push_back(std::span<const uint8_t>(corpus.data).subspan(i * chunk, chunk));
+		std::vector<std::array<uint8_t, BLAKE512::HASH_SIZE>> hashes(count);
+		const std::vector<std::span<uint8_t>> outputs(hashes.begin(), hashes.end());
+
+		const double ms = best_ms([&] {
+			BLAKE512 blake;
+			blake.hash_many(inputs, outputs);
+			sink = hashes[0][0];
+		});
+		print_row("blake512_many", corpus.name, std::to_string(chunk), count * chunk, ms);
+	}
+}
+
+template <class H>
+void strong_hash_rows(const Corpus& corpus)
+{
+	for (size_t chunk : { size_t(1024), size_t(8192), size_t(65536) }) {
+		const size_t bytes = corpus.data.size() / chunk * chunk;
+		const double ms = best_ms([&] {
+			H hash;
+			std::array<uint8_t, H::HASH_SIZE> out;
+			for (size_t offset = 0; offset < bytes; offset += chunk)
+				hash.hash(out, std::span<const uint8_t>(corpus.data).subspan(offset, chunk));
+			sink = out[0];
+		});
+		print_row(H::NAME, corpus.name, std::to_string(chunk), bytes, ms);
+	}
+}
+
+// Matching run search of the diff encoder, with every kernel the CPU supports.
+void compare_rows(const Corpus& corpus)
+{
+	const std::vector<uint8_t> copy = corpus.data;
+	for (int isa = 0; isa <= static_cast<int>(cpu_detected_isa()); isa++) {
+		const double ms = best_ms([&] {
+			sink = common_prefix_length(corpus.data, copy, static_cast<ByteCompareIsa>(isa));
+		});
+		print_row("prefix", corpus.name, cpu_isa_name(static_cast<CpuIsa>(isa)), corpus.data.size(), ms);
+	}
+}
+
+void pipeline_rows(const Corpus& corpus, std::mt19937_64& rng)
+{
+	const auto modified = modify(corpus.data, rng);
+	write_file(OLD_FILE, corpus.data);
+	write_file(NEW_FILE, modified);
+
+	Signature<RKFinger, BLAKE512> old_sig, new_sig;
+	double ms = best_ms([&] { old_sig.generate_signatures(OLD_FILE); });
+	print_row("signature", corpus.name, "RKFinger", corpus.data.size(), ms);
+	new_sig.generate_signatures(NEW_FILE);
+
+	// Delta of the modified corpus goes mostly through diff creation of modified chunks.
+	Delta<RKFinger, BLAKE512>::Result delta_result;
+	ms = best_ms([&] {
+		Delta<RKFinger, BLAKE512> delta;
+		delta_result = delta.generate_delta(old_sig, new_sig, OLD_FILE, NEW_FILE, DELTA_FILE);
+	});
+	print_row("delta", corpus.name, delta_result.success ? "modified" : "failed", modified.size(), ms);
+
+	Apply<RKFinger, BLAKE512>::Result apply_result;
+	ms = best_ms([&] {
+		Apply<RKFinger, BLAKE512> apply;
+		apply_result = apply.apply_delta(OLD_FILE, DELTA_FILE, OUT_FILE);
+	});
+	print_row("apply", corpus.name, apply_result.success ? "modified" : "failed", modified.size(), ms);
+}
+
+} // namespace
+
+void run_throughput_bench(size_t corpus_bytes)
+{
+	std::mt19937_64 rng(0x7A9E);
+	std::vector<Corpus> corpora;
+	corpora.push_back({ "random", random_corpus(corpus_bytes, rng) });
+	corpora.push_back({ "zeros", std::vector<uint8_t>(corpus_bytes, 0) });
+	corpora.push_back({ "text", text_corpus(corpus_bytes, rng) });
+
+	std::cout << "bench,corpus,variant,bytes,ms,gb_s" << std::endl;
+	for (const auto& corpus : corpora) {
+		rolling_rows(corpus);
+		blake_rows(corpus);
+		strong_hash_rows<BLAKE3>(corpus);
+		strong_hash_rows<XXH3_128>(corpus);
+		compare_rows(corpus);
+		pipeline_rows(corpus, rng);
+	}
+
+	for (const auto* path : { OLD_FILE, NEW_FILE, DELTA_FILE, OUT_FILE })
+		std::remove(path);
+}
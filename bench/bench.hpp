@@ -0,0 +1,53 @@
+#ifndef BENCH_HPP
+#define BENCH_HPP
+
+#include <chrono>
+#include <cstddef>
+
+/**
+* Get amount of heap bytes currently allocated through operator new.
+* @return Live heap bytes.
+*/
+size_t bench_live_bytes() noexcept;
+
+/**
+* Get amount of allocations done through operator new so far.
+* @return Allocation count.
+*/
+size_t bench_allocations() noexcept;
+
+/**
+* Measure wall time of the callable.
+* @param[in] fn callable to be measured
+* @return Elapsed time in milliseconds.
+*/
+template <class F>
+double bench_time_ms(F&& fn)
+{
+	const auto start = std::chrono::steady_clock::now();
+	fn();
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+* Compare memory and lookup cost of the old array-of-structs chunk list with ChunkTable.
+* @param[in] chunk_count amount of chunks
+*/
+void run_chunk_table_bench(size_t chunk_count);
+
+/**
+* Compare chunking speed, chunk size distribution and delta size of two-byte and
+* fingerprint boundaries on random, log-like and sparse corpora.
+* @param[in] corpus_bytes size of each corpus
+*/
+void run_boundary_bench(size_t corpus_bytes);
+
+/**
+* Measure throughput of rolling hashes, BLAKE-512 at several chunk sizes, signature
+* generation, delta generation and delta application on random, zero and text-like
+* corpora. Prints CSV rows: bench,corpus,variant,bytes,ms,gb_s (best of 3 runs).
+* @param[in] corpus_bytes size of each corpus
+*/
+void run_throughput_bench(size_t corpus_bytes);
+
+#endif
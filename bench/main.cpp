@@ -0,0 +1,95 @@
+#include "bench.hpp"
+
+#include <atomic>
+#include <charconv>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string_view>
+
+// Every allocation is prefixed with its size, so live heap bytes can be tracked.
+namespace {
+
+constexpr size_t ALLOC_HEADER = alignof(std::max_align_t);
+
+std::atomic<size_t> live_bytes{ 0 };
+std::atomic<size_t> allocations{ 0 };
+
+void* counted_alloc(size_t size)
+{
+	auto* block = static_cast<unsigned char*>(std::malloc(size + ALLOC_HEADER));
+	if (!block)
+		throw std::bad_alloc();
+	*reinterpret_cast<size_t*>(block) = size;
+	live_bytes.fetch_add(size, std::memory_order_relaxed);
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	return block + ALLOC_HEADER;
+}
+
+void counted_free(void* ptr) noexcept
+{
+	if (!ptr)
+		return;
+	auto* block = static_cast<unsigned char*>(ptr) - ALLOC_HEADER;
+	live_bytes.fetch_sub(*reinterpret_cast<size_t*>(block), std::memory_order_relaxed);
+	std::free(block);
+}
+
+} // namespace
+
+void* operator new(size_t size) { return counted_alloc(size); }
+void* operator new[](size_t size) { return counted_alloc(size); }
+void operator delete(void* ptr) noexcept { counted_free(ptr); }
+void operator delete[](void* ptr) noexcept { counted_free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { counted_free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { counted_free(ptr); }
+
+size_t bench_live_bytes() noexcept
+{
+	return live_bytes.load(std::memory_order_relaxed);
+}
+
+size_t bench_allocations() noexcept
+{
+	return allocations.load(std::memory_order_relaxed);
+}
+
+namespace {
+
+bool parse_count(const char* text, size_t& value)
+{
+	const std::string_view arg{text};
+	auto [ptr, ec] = std::from_chars(arg.data(), arg.data() + arg.size(), value);
+	return ec == std::errc() && ptr == arg.data() + arg.size() && value > 0;
+}
+
+} // namespace
+
+int main(int argc, const char** argv)
+{
+	size_t chunk_count = 1000000;
+	size_t corpus_mib = 16;
+
+	// Only the throughput rows, for tracking regressions with scripts.
+	if (argc > 1 && std::string_view(argv[1]) == "--csv") {
+		if (argc > 3 || (argc > 2 && !parse_count(argv[2], corpus_mib))) {
+			std::cout << "Usage: " << argv[0] << " --csv [corpus_mib]" << std::endl;
+			return 1;
+		}
+		run_throughput_bench(corpus_mib * 1024 * 1024);
+		return 0;
+	}
+
+	if ((argc > 1 && !parse_count(argv[1], chunk_count)) || (argc > 2 && !parse_count(argv[2], corpus_mib))) {
+		std::cout << "Usage: " << argv[0] << " [chunk_count] [corpus_mib]" << std::endl;
+		std::cout << "       " << argv[0] << " --csv [corpus_mib]" << std::endl;
+		return 1;
+	}
+
+	run_chunk_table_bench(chunk_count);
+	std::cout << std::endl;
+	run_boundary_bench(corpus_mib * 1024 * 1024);
+	std::cout << std::endl;
+	run_throughput_bench(corpus_mib * 1024 * 1024);
+	return 0;
+}
@@ -2,9 +2,13 @@
 #define APPLY_HPP
 
 #include "Delta.hpp"
+#include "DeltaHeader.hpp"
 #include "FileIO.hpp"
 #include "Signature.hpp"
+#include "StrongHash.hpp"
 
+#include <algorithm>
+#include <array>
 #include <bit>
 #include <cstdint>
 #include <cstring>
@@ -19,7 +23,10 @@
 * Class for applying a delta produced by Delta<T,U> against an old file to
 * reconstruct the new file.
 *
-* Format contract assumed by this applier (must stay in sync with Delta<T,U>):
+* Format contract assumed by this applier (must stay in sync with Delta<T,U,P>):
+*  - Delta starts with a DeltaHeader whose chunking policy must match P and whose
+*    strong hash must match U. Deltas without header (written before it was
+*    introduced) use the default policy and BLAKE-512.
 *  - Entries appear in target (new-file) chunk-position order. REMOVED entries
 *    (which produce no output) appear after all non-REMOVED entries.
 *  - For a MODIFIED entry at the i-th non-REMOVED position, the source old
@@ -28,7 +35,7 @@
 *    ever pairs MODIFIED with a different old chunk, this applier will need a
 *    format change to follow.
 */
-template<RollingHashAlgorithm T, StrongHashAlgorithm U>
+template<RollingHashAlgorithm T, StrongHashAlgorithm U, ChunkingPolicyType P = DefaultChunkingPolicy>
 class Apply {
 public:
 	struct Result {
@@ -36,12 +43,33 @@ public:
 		std::string error_message;
 		size_t entries_processed;
 		size_t bytes_written;
+		size_t peak_pending_bytes;		/*!< Most output data held back for batched verification */
 	};
 
+	static constexpr size_t VERIFY_BATCH = 8;					// Amount of output chunks verified at once by hash_many()
+	static constexpr size_t MAX_PENDING_BYTES = 1024 * 1024;	// Pending output flushed once it reaches this size
+
+	/**
+	* Set amount of threads used to regenerate the old file signature.
+	* @param[in] threads amount of threads (0 is treated as 1)
+	*/
+	void set_threads(unsigned int threads) noexcept {
+		threads_ = threads ? threads : 1;
+	}
+
+	/**
+	* Use precomputed signature file of the old file instead of regenerating the old
+	* file signature (see Signature::save_signatures()). Empty path disables it.
+	* @param[in] signature_file path to the signature file of the old file
+	*/
+	void set_old_signature_file(const std::filesystem::path& signature_file) {
+		old_signature_file_ = signature_file;
+	}
+
 	/**
 	* Apply a delta file against an old file to produce the reconstructed new file.
 	* @param[in] old_file_path path to the original file
-	* @param[in] delta_file_path path to the delta file produced by Delta<T,U>
+	* @param[in] delta_file_path path to the delta file produced by Delta<T,U,P>
 	* @param[in] output_file_path path where the reconstructed new file will be written
 	* @return Result with success flag and statistics
 	*/
@@ -49,7 +77,7 @@ public:
 	                   const std::filesystem::path& delta_file_path,
 	                   const std::filesystem::path& output_file_path)
 	{
-		Result result{false, "", 0, 0};
+		Result result{false, "", 0, 0, 0};
 
 		// Reject output paths that alias either input. Opening the output in
 		// FileMode::OUT truncates the target, which would destroy old or delta
@@ -80,25 +108,69 @@ public:
 			result.error_message = "Failed to open delta file: " + delta_file_path.string();
 			return result;
 		}
+		if (!readHeader(delta, result))
+			return result;
+
+		Signature<T, U, P> old_sig;
+		old_sig.set_threads(threads_);
+		if (old_signature_file_.empty()) {
+			old_sig.generate_signatures(old_file);
+		} else if (!old_sig.load_signatures(old_signature_file_, old_file_path)) {
+			result.error_message = "Signature file is invalid or does not match old file: " + old_signature_file_.string();
+			return result;
+		}
+
 		if (!output.open(output_file_path, FileMode::OUT)) {
 			result.error_message = "Failed to create output file: " + output_file_path.string();
 			return result;
 		}
 
-		Signature<T, U> old_sig;
-		old_sig.generate_signatures(old_file);
 		const auto& old_chunks = old_sig.get_chunks();
 
 		auto chunk_map = buildChunkMap(old_chunks);
 		std::vector<bool> original_used(old_chunks.size(), false);
 
 		U hash_func;
-		const size_t hash_size = hash_func.get_hash_size();
+		constexpr size_t hash_size = U::HASH_SIZE;
 		size_t new_idx = 0;
 
+		// Output chunks are written in batches so that hashes of ADDED and MODIFIED
+		// chunks are verified together by hash_many(). ORIGINAL chunks are held back
+		// only behind a chunk waiting for verification, and the batch is flushed early
+		// once it holds MAX_PENDING_BYTES, so memory stays bounded on mostly unchanged
+		// files.
+		std::vector<PendingWrite> pending;
+		pending.reserve(VERIFY_BATCH);
+		size_t pending_verify = 0;
+		size_t pending_bytes = 0;
+		auto queue_write = [&](std::vector<uint8_t>&& data, std::vector<uint8_t>&& expected, const char* mismatch_error) {
+			if (pending.empty() && mismatch_error == nullptr) {
+				if (!output.write_chunk(data)) {
+					result.error_message = "Failed to write output chunk";
+					return false;
+				}
+				result.bytes_written += data.size();
+				return true;
+			}
+
+			pending_verify += mismatch_error != nullptr;
+			pending_bytes += data.size();
+			result.peak_pending_bytes = std::max(result.peak_pending_bytes, pending_bytes);
+			pending.push_back(PendingWrite{ std::move(data), std::move(expected), mismatch_error });
+			if (pending_verify < VERIFY_BATCH && pending_bytes < MAX_PENDING_BYTES)
+				return true;
+			pending_verify = 0;
+			pending_bytes = 0;
+			return writePending(hash_func, pending, output, result);
+		};
+
 		while (true) {
 			int peek = delta.peek_byte();
-			if (peek == EOF) break;
+			if (peek == EOF) {
+				if (!writePending(hash_func, pending, output, result))
+					return result;
+				break;
+			}
 
 			uint64_t entry_type_raw;
 			if (!readU64Native(delta, entry_type_raw)) {
@@ -126,11 +198,7 @@ public:
 
 			switch (static_cast<EntryType>(entry_type_raw)) {
 				case EntryType::ORIGINAL_CHUNK: {
-					SignedChunk<typename T::RollingHashType> probe;
-					probe.signature = signature;
-					probe.hash = std::move(*hash_buf);
-					probe.chunk_size = chunk_size;
-					probe.start_offset = 0;
+					const Chunk probe{ signature, std::span<const uint8_t, hash_size>(hash_buf->data(), hash_size), 0, chunk_size };
 
 					size_t k;
 					if (!findUnusedMatch(old_chunks, original_used, chunk_map, probe, k)) {
@@ -144,12 +212,9 @@ public:
 						result.error_message = "Failed to read old chunk";
 						return result;
 					}
-					if (!output.write_chunk(*data)) {
-						result.error_message = "Failed to write output chunk";
+					if (!queue_write(std::move(*data), {}, nullptr))
 						return result;
-					}
 					original_used[k] = true;
-					result.bytes_written += data->size();
 					new_idx++;
 					break;
 				}
@@ -160,15 +225,8 @@ public:
 						result.error_message = "Truncated delta: short ADDED payload";
 						return result;
 					}
-					if (!verifyHash(hash_func, hash_size, *payload, *hash_buf)) {
-						result.error_message = "ADDED entry hash mismatch";
-						return result;
-					}
-					if (!output.write_chunk(*payload)) {
-						result.error_message = "Failed to write output chunk";
+					if (!queue_write(std::move(*payload), std::move(*hash_buf), "ADDED entry hash mismatch"))
 						return result;
-					}
-					result.bytes_written += payload->size();
 					new_idx++;
 					break;
 				}
@@ -189,16 +247,9 @@ public:
 					if (!applyDiff(delta, *old_data, chunk_size, reconstructed, result))
 						return result;
 
-					if (!verifyHash(hash_func, hash_size, reconstructed, *hash_buf)) {
-						result.error_message = "MODIFIED entry hash mismatch";
+					if (!queue_write(std::move(reconstructed), std::move(*hash_buf), "MODIFIED entry hash mismatch"))
 						return result;
-					}
-					if (!output.write_chunk(reconstructed)) {
-						result.error_message = "Failed to write output chunk";
-						return result;
-					}
 					original_used[new_idx] = true;
-					result.bytes_written += reconstructed.size();
 					new_idx++;
 					break;
 				}
@@ -207,11 +258,7 @@ public:
 					// REMOVED entries produce no output and don't advance new_idx,
 					// but each must consume a distinct unused old chunk so that
 					// duplicate or extraneous REMOVEDs are rejected.
-					SignedChunk<typename T::RollingHashType> probe;
-					probe.signature = signature;
-					probe.hash = std::move(*hash_buf);
-					probe.chunk_size = chunk_size;
-					probe.start_offset = 0;
+					const Chunk probe{ signature, std::span<const uint8_t, hash_size>(hash_buf->data(), hash_size), 0, chunk_size };
 
 					size_t k;
 					if (!findUnusedMatch(old_chunks, original_used, chunk_map, probe, k)) {
@@ -242,27 +289,20 @@ public:
 	}
 
 private:
-	struct ChunkHash {
-		size_t operator()(const SignedChunk<typename T::RollingHashType>& c) const {
-			size_t h1 = std::hash<typename T::RollingHashType>{}(c.signature);
-			size_t h2 = 0;
-			if (c.hash.size() >= sizeof(size_t))
-				std::memcpy(&h2, c.hash.data(), sizeof(size_t));
-			return h1 ^ (h2 << 1);
-		}
-	};
-
-	struct ChunkEqual {
-		bool operator()(const SignedChunk<typename T::RollingHashType>& a,
-		                const SignedChunk<typename T::RollingHashType>& b) const {
-			return a == b;
-		}
+	/**
+	* Output chunk waiting for hash verification and writing.
+	*/
+	struct PendingWrite {
+		std::vector<uint8_t> data;
+		std::vector<uint8_t> expected;						/*!< Hash from the delta */
+		const char* mismatch_error;						/*!< Error if the hash does not match, nullptr if not verified */
 	};
 
-	using ChunkMap = std::unordered_map<SignedChunk<typename T::RollingHashType>,
-	                                    size_t, ChunkHash, ChunkEqual>;
+	using Table = typename Signature<T, U, P>::Table;
+	using Chunk = typename Table::Ref;
+	using ChunkMap = std::unordered_map<Chunk, size_t, typename Table::RefHash>;
 
-	ChunkMap buildChunkMap(const std::vector<SignedChunk<typename T::RollingHashType>>& chunks) {
+	ChunkMap buildChunkMap(const Table& chunks) {
 		ChunkMap map;
 		map.reserve(chunks.size());
 		for (size_t i = 0; i < chunks.size(); ++i)
@@ -270,10 +310,10 @@ private:
 		return map;
 	}
 
-	bool findUnusedMatch(const std::vector<SignedChunk<typename T::RollingHashType>>& old_chunks,
+	bool findUnusedMatch(const Table& old_chunks,
 	                     const std::vector<bool>& original_used,
 	                     const ChunkMap& chunk_map,
-	                     const SignedChunk<typename T::RollingHashType>& probe,
+	                     const Chunk& probe,
 	                     size_t& out_index) {
 		auto it = chunk_map.find(probe);
 		if (it != chunk_map.end() && !original_used[it->second]) {
@@ -290,13 +330,76 @@ private:
 		return false;
 	}
 
-	bool verifyHash(U& hash_func, size_t hash_size,
-	                std::span<const uint8_t> chunk_data,
-	                const std::vector<uint8_t>& expected) {
-		if (expected.size() != hash_size) return false;
-		std::vector<uint8_t> computed(hash_size);
-		hash_func.hash(computed, chunk_data);
-		return computed == expected;
+	/**
+	* Verify hashes of the pending chunks (all at once by hash_many()) and write them
+	* to the output in order. Writing stops at the first chunk whose hash does not match.
+	* Pending list is cleared.
+	* @return True if all chunks were verified and written, otherwise false with error set.
+	*/
+	bool writePending(U& hash_func, std::vector<PendingWrite>& pending, FileIO& output, Result& result) {
+		std::array<std::span<const uint8_t>, VERIFY_BATCH> inputs;
+		std::array<typename Table::Hash, VERIFY_BATCH> computed;
+		std::array<std::span<uint8_t>, VERIFY_BATCH> outputs;
+		size_t count = 0;
+		for (const auto& write : pending) {
+			if (write.mismatch_error != nullptr) {
+				inputs[count] = write.data;
+				outputs[count] = computed[count];
+				count++;
+			}
+		}
+		hash_func.hash_many(std::span(inputs).first(count), std::span(outputs).first(count));
+
+		bool ok = true;
+		size_t verified = 0;
+		for (const auto& write : pending) {
+			if (write.mismatch_error != nullptr) {
+				const auto& hash = computed[verified++];
+				if (write.expected.size() != hash.size() || !std::equal(hash.begin(), hash.end(), write.expected.begin())) {
+					result.error_message = write.mismatch_error;
+					ok = false;
+					break;
+				}
+			}
+			if (!output.write_chunk(write.data)) {
+				result.error_message = "Failed to write output chunk";
+				ok = false;
+				break;
+			}
+			result.bytes_written += write.data.size();
+		}
+		pending.clear();
+		return ok;
+	}
+
+	/**
+	* Read delta header and check it against this applier's parameters. Legacy deltas
+	* without header are accepted if P is the default policy and U is BLAKE-512; the
+	* stream is then rewound to the first entry.
+	*/
+	bool readHeader(FileIO& delta, Result& result) {
+		DeltaHeader header;
+		auto buf = delta.read_chunk(DELTA_HEADER_SIZE);
+		if (!buf || !decode_delta_header(*buf, header)) {
+			legacy_delta_header(header);
+			delta.seek(0);
+		}
+
+		if (header.version > DELTA_FORMAT_VERSION) {
+			result.error_message = "Unsupported delta format version " + std::to_string(header.version);
+			return false;
+		}
+		if (header.chunking_policy != P::ID) {
+			result.error_message = std::string("Delta uses different chunking policy: ") +
+			                       chunking_policy_name(header.chunking_policy);
+			return false;
+		}
+		if (header.strong_hash != U::ID || header.hash_size != U::HASH_SIZE) {
+			result.error_message = std::string("Delta uses different strong hash: ") +
+			                       strong_hash_name(header.strong_hash);
+			return false;
+		}
+		return true;
 	}
 
 	bool readU64Native(FileIO& f, uint64_t& out) {
@@ -421,6 +524,9 @@ private:
 
 		return output.size() == target_size;
 	}
+
+	unsigned int threads_{ 1 };
+	std::filesystem::path old_signature_file_;
 };
 
 #endif // APPLY_HPP
@@ -0,0 +1,146 @@
+#include "BoundaryScan.hpp"
+
+#include <bit>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define RH_BOUNDARY_SCAN_X86
+#include <immintrin.h>
+#endif
+
+#if defined(RH_BOUNDARY_SCAN_X86) && (defined(__GNUC__) || defined(__clang__))
+#define RH_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define RH_TARGET_AVX2
+#endif
+
+namespace {
+
+size_t scan_scalar(const uint8_t* data, size_t size, size_t from, uint8_t byte_mask, uint8_t prev_mask,
+                   uint32_t* out, size_t capacity)
+{
+	size_t found = 0;
+	for (size_t i = from; i < size && found < capacity; i++)
+	{
+		if ((data[i] & byte_mask) == 0 && (data[i - 1] & prev_mask) == 0)
+			out[found++] = static_cast<uint32_t>(i);
+	}
+	return found;
+}
+
+#ifdef RH_BOUNDARY_SCAN_X86
+
+// Both kernels compare 16/32 bytes at once: the current bytes are loaded at i and the
+// previous ones with the same load shifted by one byte. Only set bits of the resulting
+// movemask need scalar work.
+
+size_t scan_sse2(const uint8_t* data, size_t size, size_t from, uint8_t byte_mask, uint8_t prev_mask,
+                 uint32_t* out, size_t capacity)
+{
+	const __m128i bmask = _mm_set1_epi8(static_cast<char>(byte_mask));
+	const __m128i pmask = _mm_set1_epi8(static_cast<char>(prev_mask));
+	const __m128i zero = _mm_setzero_si128();
+	size_t found = 0;
+	size_t i = from;
+
+	for (; i + 16 <= size; i += 16)
+	{
+		__m128i cur = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+		__m128i prev = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i - 1));
+		__m128i hit = _mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(cur, bmask), zero),
+		                            _mm_cmpeq_epi8(_mm_and_si128(prev, pmask), zero));
+		auto bits = static_cast<uint32_t>(_mm_movemask_epi8(hit));
+		while (bits)
+		{
+			if (found == capacity)
+				return found;
+			out[found++] = static_cast<uint32_t>(i + std::countr_zero(bits));
+			bits &= bits - 1;
+		}
+	}
+
+	return found + scan_scalar(data, size, i, byte_mask, prev_mask, out + found, capacity - found);
+}
+
+RH_TARGET_AVX2
+size_t scan_avx2(const uint8_t* data, size_t size, size_t from, uint8_t byte_mask, uint8_t prev_mask,
+                 uint32_t* out, size_t capacity)
+{
+	const __m256i bmask = _mm256_set1_epi8(static_cast<char>(byte_mask));
+	const __m256i pmask = _mm256_set1_epi8(static_cast<char>(prev_mask));
+	const __m256i zero = _mm256_setzero_si256();
+	size_t found = 0;
+	size_t i = from;
+
+	for (; i + 32 <= size; i += 32)
+	{
+		__m256i cur = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+		__m256i prev = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i - 1));
+		__m256i hit = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_and_si256(cur, bmask), zero),
+		                               _mm256_cmpeq_epi8(_mm256_and_si256(prev, pmask), zero));
+		auto bits = static_cast<uint32_t>(_mm256_movemask_epi8(hit));
+		while (bits)
+		{
+			if (found == capacity)
+				return found;
+			out[found++] = static_cast<uint32_t>(i + std::countr_zero(bits));
+			bits &= bits - 1;
+		}
+	}
+
+	return found + scan_sse2(data, size, i, byte_mask, prev_mask, out + found, capacity - found);
+}
+
+#endif // RH_BOUNDARY_SCAN_X86
+
+using ScanKernel = size_t (*)(const uint8_t* data, size_t size, size_t from, uint8_t byte_mask, uint8_t prev_mask,
+                              uint32_t* out, size_t capacity);
+
+constexpr IsaKernel<ScanKernel> SCAN_KERNELS[] = {
+#ifdef RH_BOUNDARY_SCAN_X86
+	{ CpuIsa::AVX2, scan_avx2 },
+	{ CpuIsa::SSE2, scan_sse2 },
+#endif
+	{ CpuIsa::SCALAR, scan_scalar },
+};
+
+const IsaKernel<ScanKernel>& best_scan_kernel() noexcept
+{
+	static const IsaKernel<ScanKernel>& best = select_kernel(SCAN_KERNELS, cpu_best_isa());
+	return best;
+}
+
+size_t scan(const uint8_t* data, size_t size, size_t from, uint16_t mask, uint32_t* out, size_t capacity,
+            ScanKernel kernel) noexcept
+{
+	if (from == 0)
+		from = 1;
+	if (from >= size || capacity == 0)
+		return 0;
+
+	return kernel(data, size, from, static_cast<uint8_t>(mask & 0xFF), static_cast<uint8_t>(mask >> 8), out, capacity);
+}
+
+} // namespace
+
+BoundaryScanIsa boundary_scan_best_isa() noexcept
+{
+	return best_scan_kernel().isa;
+}
+
+const char* boundary_scan_isa_name(BoundaryScanIsa isa) noexcept
+{
+	return cpu_isa_name(isa);
+}
+
+size_t find_boundary_candidates(std::span<const uint8_t> data, size_t from, uint16_t mask,
+                                std::span<uint32_t> positions) noexcept
+{
+	return scan(data.data(), data.size(), from, mask, positions.data(), positions.size(), best_scan_kernel().fn);
+}
+
+size_t find_boundary_candidates(std::span<const uint8_t> data, size_t from, uint16_t mask,
+                                std::span<uint32_t> positions, BoundaryScanIsa isa) noexcept
+{
+	return scan(data.data(), data.size(), from, mask, positions.data(), positions.size(),
+	            select_kernel(SCAN_KERNELS, isa).fn);
+}
@@ -0,0 +1,57 @@
+#ifndef BOUNDARYSCAN_HPP
+#define BOUNDARYSCAN_HPP
+
+#include "CpuDispatch.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+/**
+* Instruction set used by boundary candidate scanning kernel (scalar, SSE2 and AVX2
+* kernels exist, better ISAs use the AVX2 one).
+*/
+using BoundaryScanIsa = CpuIsa;
+
+/**
+* Get the best instruction set used for boundary scanning - the best kernel allowed
+* by cpu_best_isa().
+* @return Best usable ISA.
+*/
+BoundaryScanIsa boundary_scan_best_isa() noexcept;
+
+/**
+* Get the name of the ISA (for diagnostics).
+* @param[in] isa instruction set
+* @return Name of the instruction set.
+*/
+const char* boundary_scan_isa_name(BoundaryScanIsa isa) noexcept;
+
+/**
+* Find candidate chunk boundaries using the two-byte boundary test. Position i is
+* reported if ((data[i-1] << 8 | data[i]) & mask) == 0. Positions are reported in
+* increasing order, scanning stops when the output buffer is full.
+* Uses the best kernel supported by the CPU.
+* @param[in] data buffer to be scanned (less than 4 GiB)
+* @param[in] from first position to be checked (at least 1, as previous byte is needed)
+* @param[in] mask 16-bit boundary mask
+* @param[out] positions buffer for found positions
+* @return Amount of positions stored in the output buffer.
+*/
+size_t find_boundary_candidates(std::span<const uint8_t> data, size_t from, uint16_t mask,
+                                std::span<uint32_t> positions) noexcept;
+
+/**
+* Find candidate chunk boundaries using specified kernel. ISA must not be better than
+* the one returned by cpu_detected_isa().
+* @param[in] data buffer to be scanned (less than 4 GiB)
+* @param[in] from first position to be checked (at least 1, as previous byte is needed)
+* @param[in] mask 16-bit boundary mask
+* @param[out] positions buffer for found positions
+* @param[in] isa kernel to be used
+* @return Amount of positions stored in the output buffer.
+*/
+size_t find_boundary_candidates(std::span<const uint8_t> data, size_t from, uint16_t mask,
+                                std::span<uint32_t> positions, BoundaryScanIsa isa) noexcept;
+
+#endif
@@ -0,0 +1,105 @@
+#ifndef BOUNDEDQUEUE_HPP
+#define BOUNDEDQUEUE_HPP
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+
+/**
+* Bounded lock-free multi-producer multi-consumer queue (D. Vyukov's algorithm).
+* Every cell has a sequence number telling whether it is ready to be written or read
+* in the current lap, so producers and consumers only contend on their own position
+* counter. Capacity is rounded up to a power of two.
+* Template T must be default constructible and copy/move assignable.
+*/
+template <class T>
+class BoundedQueue {
+public:
+	/**
+	* Create queue.
+	* @param[in] capacity maximum amount of elements (at least 2)
+	*/
+	explicit BoundedQueue(size_t capacity)
+		: mask_(std::bit_ceil(capacity < 2 ? size_t(2) : capacity) - 1),
+		  cells_(std::make_unique<Cell[]>(mask_ + 1)) {
+		for (size_t i = 0; i <= mask_; i++)
+			cells_[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	BoundedQueue(const BoundedQueue&) = delete;
+	BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+	/**
+	* Try to add element to the queue.
+	* @param[in] value element to add
+	* @return True if element was added, false if the queue is full.
+	*/
+	bool try_push(T value) noexcept {
+		size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+		Cell* cell;
+		while (true) {
+			cell = &cells_[pos & mask_];
+			const size_t seq = cell->sequence.load(std::memory_order_acquire);
+			const auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+			if (diff == 0) {
+				if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			} else if (diff < 0) {
+				return false;
+			} else {
+				pos = enqueue_pos_.load(std::memory_order_relaxed);
+			}
+		}
+		cell->data = std::move(value);
+		cell->sequence.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	/**
+	* Try to take element from the queue.
+	* @param[out] value taken element
+	* @return True if element was taken, false if the queue is empty.
+	*/
+	bool try_pop(T& value) noexcept {
+		size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+		Cell* cell;
+		while (true) {
+			cell = &cells_[pos & mask_];
+			const size_t seq = cell->sequence.load(std::memory_order_acquire);
+			const auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+			if (diff == 0) {
+				if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			} else if (diff < 0) {
+				return false;
+			} else {
+				pos = dequeue_pos_.load(std::memory_order_relaxed);
+			}
+		}
+		value = std::move(cell->data);
+		cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+		return true;
+	}
+
+	/**
+	* Get queue capacity.
+	* @return Maximum amount of elements.
+	*/
+	size_t capacity() const noexcept {
+		return mask_ + 1;
+	}
+
+private:
+	struct Cell {
+		std::atomic<size_t> sequence;
+		T data;
+	};
+
+	const size_t mask_;
+	std::unique_ptr<Cell[]> cells_;
+	alignas(64) std::atomic<size_t> enqueue_pos_{ 0 };
+	alignas(64) std::atomic<size_t> dequeue_pos_{ 0 };
+};
+
+#endif
@@ -0,0 +1,163 @@
+#ifndef BUZHASH_HPP
+#define BUZHASH_HPP
+
+#include "GearHash.hpp"
+#include "IRollingHash.hpp"
+#include "RK_finger.hpp"
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/**
+* BuzHash is a cyclic polynomial rolling hash over a window of the last window_size
+* bytes. Every byte is mapped to a pseudo-random 64-bit value from a 256-entry table
+* and the hash is the xor of these values, each rotated left by its distance from
+* the end of the window:
+*  - adding a byte rotates the hash by one bit and xors the byte's value in,
+*  - the byte leaving the window is xored out with its value rotated by window_size,
+*    taken from a 256-entry table computed at construction.
+* There are no multiplications or divisions, so rolling is much cheaper than in RKFinger.
+* Leaving bytes are kept in a ring buffer, so the value depends only on the bytes in
+* the window. Rotation is modulo 64, so for windows longer than 64 bytes equal bytes
+* exactly 64 positions apart cancel out - keep the window at most 64 bytes long.
+*
+* Class has only value members so moving and copying can be done using default copy constructor and assignment operator.
+*/
+class BuzHash : public IRollingHash<uint64_t> {
+public:
+	static constexpr bool WINDOWED = true;			// Value depends only on the window (see WindowedRollingHash)
+
+	explicit BuzHash(unsigned int window_size = WINDOW_DEF_SIZE)
+		: window_size_(window_size ? window_size : 1), window_(window_size_, 0) {
+		for (size_t b = 0; b < out_table_.size(); b++)
+			out_table_[b] = std::rotl(BUZ_TABLE[b], static_cast<int>(window_size_ % 64));
+	}
+
+	BuzHash(const BuzHash& other) = default;
+	BuzHash(BuzHash&& other) = default;
+	BuzHash& operator=(const BuzHash& other) = default;
+	BuzHash& operator=(BuzHash&& other) = default;
+
+	/**
+	* Computes initial hash value.
+	* Can be used to clear current hash and initialize the object with new data.
+	* @param initial[in] initial data to be hashed - must be at least window_size length (but still only window_size bytes will be used).
+	* @return True if init was successful, otherwise false (if initial data is too short).
+	*/
+	bool initialize(std::span<const uint8_t> initial) noexcept override {
+		if (initial.size() < window_size_)
+			return false;
+
+		fingerprint_ = 0;
+		for (unsigned int i = 0; i < window_size_; i++) {
+			window_[i] = initial[i];
+			fingerprint_ = std::rotl(fingerprint_, 1) ^ BUZ_TABLE[initial[i]];
+		}
+		position_ = 0;
+		return true;
+	}
+
+	/**
+	* Compute the next hash value for the given data.
+	* @param[in] data the data byte to be hashed.
+	* @return the new rolling hash value.
+	*/
+	uint64_t compute_next(uint8_t byte) noexcept override {
+		const uint8_t leaving = window_[position_];
+		window_[position_] = byte;
+		if (++position_ == window_size_)
+			position_ = 0;
+
+		fingerprint_ = std::rotl(fingerprint_, 1) ^ out_table_[leaving] ^ BUZ_TABLE[byte];
+		return fingerprint_;
+	}
+
+	/**
+	* Roll the hash over all bytes of data (see IRollingHash::roll()) with the state
+	* kept in locals.
+	* @param[in] data bytes to be added to the rolling hash
+	* @param[in] predicate callable invoked as predicate(value), returning bool
+	* @param[out] positions cut points found in data
+	* @return Current rolling hash value (unchanged if data is empty).
+	*/
+	template <class Predicate>
+	uint64_t roll(std::span<const uint8_t> data, Predicate&& predicate, std::vector<size_t>& positions) {
+		uint8_t* window = window_.data();
+		unsigned int position = position_;
+		uint64_t fingerprint = fingerprint_;
+
+		for (size_t i = 0; i < data.size(); i++) {
+			const uint8_t byte = data[i];
+			fingerprint = std::rotl(fingerprint, 1) ^ out_table_[window[position]] ^ BUZ_TABLE[byte];
+			window[position] = byte;
+			if (++position == window_size_)
+				position = 0;
+
+			if (predicate(fingerprint))
+				positions.push_back(i + 1);
+		}
+
+		position_ = position;
+		fingerprint_ = fingerprint;
+		return fingerprint;
+	}
+
+	/**
+	* Roll the hash over all bytes of data.
+	* @param[in] data bytes to be added to the rolling hash
+	* @return Current rolling hash value (unchanged if data is empty).
+	*/
+	uint64_t roll(std::span<const uint8_t> data) {
+		std::vector<size_t> none;
+		return roll(data, [](uint64_t) { return false; }, none);
+	}
+
+	/**
+	* Get alphabet size.
+	* @return Alphabet size.
+	*/
+	unsigned int get_alphabet_size() const override {
+		return ALPHABET_DEF_SIZE;
+	}
+
+	/**
+	* Return rolling hash window size.
+	* @return Window size.
+	*/
+	unsigned int get_window_size() const override {
+		return window_size_;
+	}
+
+	/**
+	* Get current rolling hash value.
+	* @return Current rolling hash value.
+	*/
+	uint64_t get_current_fingerprint() const override {
+		return fingerprint_;
+	}
+
+	/**
+	* Get table value of the byte (for tests and reference implementations).
+	* @param[in] byte byte value
+	* @return Pseudo-random 64-bit value assigned to the byte.
+	*/
+	static constexpr uint64_t table_value(uint8_t byte) noexcept {
+		return BUZ_TABLE[byte];
+	}
+
+private:
+	static constexpr std::array<uint64_t, 256> BUZ_TABLE = make_gear_table(0x62757a6861736821ULL);
+
+	unsigned int window_size_;									/*!< Window size */
+	unsigned int position_{ 0 };								/*!< Ring buffer position of the oldest byte */
+	uint64_t fingerprint_{ 0 };									/*!< Current fingerprint */
+	std::vector<uint8_t> window_;								/*!< Bytes in the window (ring buffer) */
+	std::array<uint64_t, 256> out_table_{};						/*!< Table value rotated by window_size, xored out for the leaving byte */
+};
+
+
+#endif
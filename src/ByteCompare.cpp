@@ -0,0 +1,112 @@
+#include "ByteCompare.hpp"
+
+#include <algorithm>
+#include <bit>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define RH_BYTE_COMPARE_X86
+#include <immintrin.h>
+#endif
+
+#if defined(RH_BYTE_COMPARE_X86) && (defined(__GNUC__) || defined(__clang__))
+#define RH_TARGET_AVX2 __attribute__((target("avx2")))
+#define RH_TARGET_AVX512 __attribute__((target("avx512f,avx512bw")))
+#else
+#define RH_TARGET_AVX2
+#define RH_TARGET_AVX512
+#endif
+
+namespace {
+
+size_t prefix_scalar(const uint8_t* a, const uint8_t* b, size_t size)
+{
+	size_t i = 0;
+	while (i < size && a[i] == b[i])
+		i++;
+	return i;
+}
+
+#ifdef RH_BYTE_COMPARE_X86
+
+// Kernels compare 16/32/64 bytes at once; the first clear bit of the equality mask
+// is the first mismatch. The tail is left to the scalar kernel.
+
+size_t prefix_sse2(const uint8_t* a, const uint8_t* b, size_t size)
+{
+	size_t i = 0;
+	for (; i + 16 <= size; i += 16)
+	{
+		const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+		const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+		const auto diff = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb))) ^ 0xFFFFu;
+		if (diff)
+			return i + std::countr_zero(diff);
+	}
+	return i + prefix_scalar(a + i, b + i, size - i);
+}
+
+RH_TARGET_AVX2
+size_t prefix_avx2(const uint8_t* a, const uint8_t* b, size_t size)
+{
+	size_t i = 0;
+	for (; i + 32 <= size; i += 32)
+	{
+		const __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+		const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+		const auto diff = ~static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(va, vb)));
+		if (diff)
+			return i + std::countr_zero(diff);
+	}
+	return i + prefix_scalar(a + i, b + i, size - i);
+}
+
+RH_TARGET_AVX512
+size_t prefix_avx512(const uint8_t* a, const uint8_t* b, size_t size)
+{
+	size_t i = 0;
+	for (; i + 64 <= size; i += 64)
+	{
+		const __m512i va = _mm512_loadu_si512(a + i);
+		const __m512i vb = _mm512_loadu_si512(b + i);
+		const uint64_t diff = _mm512_cmpneq_epi8_mask(va, vb);
+		if (diff)
+			return i + std::countr_zero(diff);
+	}
+	return i + prefix_scalar(a + i, b + i, size - i);
+}
+
+#endif // RH_BYTE_COMPARE_X86
+
+using PrefixKernel = size_t (*)(const uint8_t* a, const uint8_t* b, size_t size);
+
+constexpr IsaKernel<PrefixKernel> PREFIX_KERNELS[] = {
+#ifdef RH_BYTE_COMPARE_X86
+	{ CpuIsa::AVX512, prefix_avx512 },
+	{ CpuIsa::AVX2, prefix_avx2 },
+	{ CpuIsa::SSE2, prefix_sse2 },
+#endif
+	{ CpuIsa::SCALAR, prefix_scalar },
+};
+
+const IsaKernel<PrefixKernel>& best_prefix_kernel() noexcept
+{
+	static const IsaKernel<PrefixKernel>& best = select_kernel(PREFIX_KERNELS, cpu_best_isa());
+	return best;
+}
+
+} // namespace
+
+ByteCompareIsa byte_compare_best_isa() noexcept
+{
+	return best_prefix_kernel().isa;
+}
+
+size_t common_prefix_length(std::span<const uint8_t> a, std::span<const uint8_t> b) noexcept
+{
+	return best_prefix_kernel().fn(a.data(), b.data(), std::min(a.size(), b.size()));
+}
+
+size_t common_prefix_length(std::span<const uint8_t> a, std::span<const uint8_t> b, ByteCompareIsa isa) noexcept
+{
+	return select_kernel(PREFIX_KERNELS, isa).fn(a.data(), b.data(), std::min(a.size(), b.size()));
+}
@@ -0,0 +1,42 @@
+#ifndef BYTECOMPARE_HPP
+#define BYTECOMPARE_HPP
+
+#include "CpuDispatch.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+/**
+* Instruction set used by byte comparison kernel (scalar, SSE2, AVX2 and AVX-512
+* kernels exist).
+*/
+using ByteCompareIsa = CpuIsa;
+
+/**
+* Get the best instruction set used for byte comparison - the best kernel allowed
+* by cpu_best_isa().
+* @return Best usable ISA.
+*/
+ByteCompareIsa byte_compare_best_isa() noexcept;
+
+/**
+* Get length of the common prefix of two buffers (memcmp-style mismatch search).
+* Uses the best kernel allowed by cpu_best_isa().
+* @param[in] a first buffer
+* @param[in] b second buffer
+* @return Amount of leading bytes which are equal in both buffers.
+*/
+size_t common_prefix_length(std::span<const uint8_t> a, std::span<const uint8_t> b) noexcept;
+
+/**
+* Get length of the common prefix of two buffers using specified kernel. ISA must
+* not be better than the one returned by cpu_detected_isa().
+* @param[in] a first buffer
+* @param[in] b second buffer
+* @param[in] isa kernel to be used
+* @return Amount of leading bytes which are equal in both buffers.
+*/
+size_t common_prefix_length(std::span<const uint8_t> a, std::span<const uint8_t> b, ByteCompareIsa isa) noexcept;
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef CHUNKSTATS_HPP
+#define CHUNKSTATS_HPP
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/**
+* Statistics of chunking a file: chunk size distribution, amount of cuts forced by
+* the maximum chunk size and time spent. Chunk sizes are counted in power of two
+* buckets - bucket b holds chunks of [2^b, 2^(b+1)) bytes.
+*/
+struct ChunkStats {
+	static constexpr size_t HISTOGRAM_BUCKETS = 32;
+
+	size_t chunk_count{ 0 };							/*!< Amount of chunks */
+	uint64_t total_bytes{ 0 };							/*!< Sum of chunk sizes */
+	size_t min_chunk_size{ 0 };							/*!< Size of the smallest chunk */
+	size_t max_chunk_size{ 0 };							/*!< Size of the largest chunk */
+	size_t forced_cuts{ 0 };							/*!< Chunks cut at the maximum chunk size */
+	double elapsed_ms{ 0 };								/*!< Wall time of chunking and hashing */
+	std::array<size_t, HISTOGRAM_BUCKETS> histogram{};	/*!< Chunk counts by size bucket */
+
+	/**
+	* Get histogram bucket of the chunk size.
+	* @param[in] size chunk size (non-zero)
+	* @return Bucket index.
+	*/
+	static constexpr size_t bucket_of(size_t size) noexcept {
+		return std::min<size_t>(std::bit_width(size) - 1, HISTOGRAM_BUCKETS - 1);
+	}
+
+	/**
+	* Count a chunk.
+	* @param[in] size chunk size
+	* @param[in] forced true if the chunk was cut at the maximum chunk size
+	*/
+	constexpr void add(size_t size, bool forced) noexcept {
+		if (size == 0)
+			return;
+		min_chunk_size = chunk_count ? std::min(min_chunk_size, size) : size;
+		max_chunk_size = std::max(max_chunk_size, size);
+		chunk_count++;
+		total_bytes += size;
+		forced_cuts += forced;
+		histogram[bucket_of(size)]++;
+	}
+
+	/**
+	* Get average chunk size.
+	* @return Average size in bytes, 0 if there are no chunks.
+	*/
+	constexpr double average_chunk_size() const noexcept {
+		return chunk_count ? double(total_bytes) / double(chunk_count) : 0.0;
+	}
+
+	/**
+	* Get chunking throughput.
+	* @return Throughput in MiB/s, 0 if no time was measured.
+	*/
+	constexpr double throughput_mib_s() const noexcept {
+		return elapsed_ms > 0 ? double(total_bytes) / (1024.0 * 1024.0) / (elapsed_ms / 1000.0) : 0.0;
+	}
+};
+
+/**
+* Statistics of delta generation: how much of the new file was matched in the old one
+* (ORIGINAL entries), stored as diff (MODIFIED) or as raw data (ADDED), how much of
+* the old file was dropped (REMOVED), and time spent.
+*/
+struct DeltaStats {
+	size_t original_chunks{ 0 };						/*!< Chunks of the new file found in the old one */
+	size_t modified_chunks{ 0 };						/*!< Chunks stored as diff against the old chunk */
+	size_t added_chunks{ 0 };							/*!< Chunks stored as raw data */
+	size_t removed_chunks{ 0 };							/*!< Chunks of the old file not used */
+	uint64_t original_bytes{ 0 };						/*!< New file bytes matched in the old file */
+	uint64_t modified_bytes{ 0 };						/*!< New file bytes stored as diff */
+	uint64_t added_bytes{ 0 };							/*!< New file bytes stored as raw data */
+	uint64_t removed_bytes{ 0 };						/*!< Old file bytes not used */
+	uint64_t payload_bytes{ 0 };						/*!< Diff and raw data written to the delta */
+	size_t matched_super_chunks{ 0 };					/*!< Super-chunks matched as a whole */
+	size_t indexed_chunks{ 0 };							/*!< Old chunks indexed for chunk-level matching */
+	double elapsed_ms{ 0 };								/*!< Wall time of matching and writing the delta */
+
+	/**
+	* Get size of the new file covered by the delta.
+	* @return Size in bytes.
+	*/
+	constexpr uint64_t new_bytes() const noexcept {
+		return original_bytes + modified_bytes + added_bytes;
+	}
+
+	/**
+	* Get fraction of the new file matched in the old one (deduplication ratio).
+	* @return Ratio in [0, 1], 1 for an empty new file.
+	*/
+	constexpr double matched_ratio() const noexcept {
+		return new_bytes() ? double(original_bytes) / double(new_bytes()) : 1.0;
+	}
+};
+
+/**
+* Get milliseconds elapsed since the given time point.
+* @param[in] start start of the measured interval
+* @return Elapsed time in milliseconds.
+*/
+inline double elapsed_ms_since(std::chrono::steady_clock::time_point start) noexcept {
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+#endif
@@ -0,0 +1,206 @@
+#ifndef CHUNKTABLE_HPP
+#define CHUNKTABLE_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <span>
+#include <vector>
+
+/**
+* Table of signed chunks stored as structure of arrays: rolling hash signatures,
+* start offsets, sizes and strong hashes are kept in separate contiguous arrays.
+* Strong hash width is fixed at compile time, so hashes are stored inline and
+* a chunk costs sizeof(T) + 12 + HashSize bytes without any per-chunk allocation.
+* Chunks are accessed by value through lightweight Ref views.
+* Template T is the rolling hash type, HashSize is the strong hash size in bytes.
+*/
+template <class T, size_t HashSize>
+class ChunkTable {
+public:
+	using Hash = std::array<uint8_t, HashSize>;
+
+	static constexpr size_t HASH_SIZE = HashSize;
+	static constexpr size_t BYTES_PER_CHUNK = sizeof(T) + sizeof(uint64_t) + sizeof(uint32_t) + HashSize;
+
+	/**
+	* View of a single signed chunk. Hash points into the table (or to the caller's
+	* buffer) and is valid as long as the table is not modified.
+	*/
+	struct Ref {
+		T signature;								/*!< Rolling hash signature */
+		std::span<const uint8_t, HashSize> hash;	/*!< Hash (strong) of data */
+		size_t start_offset;						/*!< Start offset of data in file */
+		size_t chunk_size;							/*!< Size of the chunk */
+
+		bool operator==(const Ref& rhs) const {		// Check if two chunks are equal (don't check start offset)
+			return signature == rhs.signature && chunk_size == rhs.chunk_size &&
+			       std::equal(hash.begin(), hash.end(), rhs.hash.begin());
+		}
+	};
+
+	/**
+	* Hash functor for using Ref as a key of unordered containers. Combines the
+	* signature with the first bytes of the strong hash.
+	*/
+	struct RefHash {
+		size_t operator()(const Ref& chunk) const noexcept {
+			size_t h2 = 0;
+			std::memcpy(&h2, chunk.hash.data(), std::min(sizeof(h2), HashSize));
+			return std::hash<T>{}(chunk.signature) ^ (h2 << 1);
+		}
+	};
+
+	/**
+	* Get amount of chunks.
+	* @return Amount of chunks.
+	*/
+	size_t size() const noexcept {
+		return signatures_.size();
+	}
+
+	/**
+	* Check if the table is empty.
+	* @return True if there are no chunks.
+	*/
+	bool empty() const noexcept {
+		return signatures_.empty();
+	}
+
+	/**
+	* Reserve space for given amount of chunks. Hash storage of existing chunks is not
+	* moved by push_back() until the reserved amount is exceeded.
+	* @param[in] count amount of chunks
+	*/
+	void reserve(size_t count) {
+		signatures_.reserve(count);
+		offsets_.reserve(count);
+		sizes_.reserve(count);
+		hashes_.reserve(count);
+	}
+
+	/**
+	* Remove all chunks.
+	*/
+	void clear() noexcept {
+		signatures_.clear();
+		offsets_.clear();
+		sizes_.clear();
+		hashes_.clear();
+	}
+
+	/**
+	* Get chunk at given index.
+	* @param[in] index chunk index
+	* @return View of the chunk.
+	*/
+	Ref operator[](size_t index) const noexcept {
+		return Ref{ signatures_[index], hashes_[index], offsets_[index], sizes_[index] };
+	}
+
+	/**
+	* Get the last chunk.
+	* @return View of the last chunk.
+	*/
+	Ref back() const noexcept {
+		return (*this)[size() - 1];
+	}
+
+	/**
+	* Get offset just past the last chunk.
+	* @return End offset of the last chunk, 0 if the table is empty.
+	*/
+	size_t end_offset() const noexcept {
+		return empty() ? 0 : offsets_.back() + sizes_.back();
+	}
+
+	/**
+	* Append chunk.
+	* @param[in] signature rolling hash signature
+	* @param[in] hash strong hash (HashSize bytes)
+	* @param[in] start_offset start offset of the chunk
+	* @param[in] chunk_size size of the chunk (less than 4 GiB)
+	*/
+	void push_back(T signature, std::span<const uint8_t, HashSize> hash, size_t start_offset, size_t chunk_size) {
+		signatures_.push_back(signature);
+		offsets_.push_back(start_offset);
+		sizes_.push_back(static_cast<uint32_t>(chunk_size));
+		std::copy(hash.begin(), hash.end(), hashes_.emplace_back().begin());
+	}
+
+	/**
+	* Append chunk.
+	* @param[in] chunk chunk to be copied
+	*/
+	void push_back(const Ref& chunk) {
+		push_back(chunk.signature, chunk.hash, chunk.start_offset, chunk.chunk_size);
+	}
+
+	/**
+	* Append chunks [first, other.size()) of another table.
+	* @param[in] other table to copy chunks from
+	* @param[in] first index of the first chunk to be copied
+	*/
+	void append(const ChunkTable& other, size_t first) {
+		signatures_.insert(signatures_.end(), other.signatures_.begin() + first, other.signatures_.end());
+		offsets_.insert(offsets_.end(), other.offsets_.begin() + first, other.offsets_.end());
+		sizes_.insert(sizes_.end(), other.sizes_.begin() + first, other.sizes_.end());
+		hashes_.insert(hashes_.end(), other.hashes_.begin() + first, other.hashes_.end());
+	}
+
+	/**
+	* Get writable hash storage of the chunk (for hashing in place).
+	* @param[in] index chunk index
+	* @return Hash bytes of the chunk.
+	*/
+	std::span<uint8_t, HashSize> hash_at(size_t index) noexcept {
+		return hashes_[index];
+	}
+
+	/**
+	* Set rolling hash signature of the chunk.
+	* @param[in] index chunk index
+	* @param[in] signature new signature
+	*/
+	void set_signature(size_t index, T signature) noexcept {
+		signatures_[index] = signature;
+	}
+
+	/**
+	* Get start offsets of all chunks (increasing for chunk lists of a file).
+	* @return Contiguous array of start offsets.
+	*/
+	std::span<const uint64_t> offsets() const noexcept {
+		return offsets_;
+	}
+
+	/**
+	* Find the first chunk starting at or after given offset.
+	* @param[in] offset file offset
+	* @param[in] from index to start searching at
+	* @return Index of the chunk, size() if there is none.
+	*/
+	size_t lower_bound(size_t offset, size_t from = 0) const noexcept {
+		return static_cast<size_t>(std::lower_bound(offsets_.begin() + from, offsets_.end(), offset) - offsets_.begin());
+	}
+
+	/**
+	* Get amount of heap memory reserved by the table.
+	* @return Size in bytes.
+	*/
+	size_t memory_usage() const noexcept {
+		return signatures_.capacity() * sizeof(T) + offsets_.capacity() * sizeof(uint64_t) +
+		       sizes_.capacity() * sizeof(uint32_t) + hashes_.capacity() * sizeof(Hash);
+	}
+
+private:
+	std::vector<T> signatures_;
+	std::vector<uint64_t> offsets_;
+	std::vector<uint32_t> sizes_;
+	std::vector<Hash> hashes_;
+};
+
+#endif
@@ -0,0 +1,110 @@
+#ifndef CHUNKINGPOLICY_HPP
+#define CHUNKINGPOLICY_HPP
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/**
+* Boundary test used to place content-defined chunk boundaries.
+*/
+enum class BoundaryMode : uint8_t {
+	TWO_BYTE = 0,			/*!< ((last << 8 | byte) & mask) == 0 - cheap, vectorized, looks at two bytes only */
+	FINGERPRINT = 1			/*!< (rolling fingerprint & mask) == 0 - looks at the whole rolling hash window */
+};
+
+constexpr uint8_t FINGERPRINT_POLICY_FLAG = 0x80;		// Policy ID bit marking fingerprint boundaries
+
+/**
+* Chunking policy - chunk size limits and boundary mask schedule used by Signature.
+* Everything is derived at compile time from the target (average) chunk size:
+*  - chunks are between Target/16 and 2*Target bytes long,
+*  - boundary test uses mask Target/16-1 below Target/4 bytes, Target/4-1 below
+*    Target/2 bytes and Target-1 above (three-step schedule).
+* The mask is applied either to the last two bytes or to the rolling fingerprint
+* (Mode). Two-byte boundaries degrade on low-entropy data with short periods, where
+* two bytes repeat, while the fingerprint covers the whole rolling hash window.
+* Policy ID is log2(Target), with FINGERPRINT_POLICY_FLAG set for fingerprint
+* boundaries; it is stored in the delta so that Apply can regenerate the old file
+* signature with the same policy.
+*/
+template <size_t Target, BoundaryMode Mode = BoundaryMode::TWO_BYTE>
+struct ChunkingPolicy {
+	static_assert(std::has_single_bit(Target), "Target chunk size must be a power of two");
+	static_assert(Target >= 1024 && Target <= 65536, "Two-byte boundary test supports 1 KiB - 64 KiB targets");
+
+	static constexpr uint8_t ID = static_cast<uint8_t>(std::countr_zero(Target)) |
+		(Mode == BoundaryMode::FINGERPRINT ? FINGERPRINT_POLICY_FLAG : 0);
+	static constexpr BoundaryMode BOUNDARY = Mode;
+
+	static constexpr size_t TARGET_CHUNK_SIZE = Target;				// Target average chunk size
+	static constexpr size_t MIN_CHUNK_SIZE = Target / 16;			// Minimum chunk size in bytes
+	static constexpr size_t MAX_CHUNK_SIZE = Target * 2;			// Maximum chunk size in bytes
+
+	static constexpr size_t SMALL_CHUNK_LIMIT = Target / 4;			// Chunks below this size use SMALL_MASK
+	static constexpr size_t MEDIUM_CHUNK_LIMIT = Target / 2;		// Chunks below this size use MEDIUM_MASK
+	static constexpr uint32_t SMALL_MASK = Target / 16 - 1;			// 16/Target probability for small chunks
+	static constexpr uint32_t MEDIUM_MASK = Target / 4 - 1;			// 4/Target probability for medium chunks
+	static constexpr uint32_t LARGE_MASK = Target - 1;				// 1/Target probability for large chunks
+
+	/**
+	* Get boundary mask for the chunk of given size.
+	* @param[in] size current chunk size
+	* @return Mask for the boundary test.
+	*/
+	static constexpr uint32_t mask_for(size_t size) noexcept {
+		return size < SMALL_CHUNK_LIMIT ? SMALL_MASK : size < MEDIUM_CHUNK_LIMIT ? MEDIUM_MASK : LARGE_MASK;
+	}
+};
+
+using SmallChunkingPolicy = ChunkingPolicy<1024>;			// config files and other small blobs
+using DefaultChunkingPolicy = ChunkingPolicy<8192>;			// general purpose
+using LargeChunkingPolicy = ChunkingPolicy<65536>;			// disk images - keeps chunk tables small
+
+using SmallFingerprintChunkingPolicy = ChunkingPolicy<1024, BoundaryMode::FINGERPRINT>;
+using DefaultFingerprintChunkingPolicy = ChunkingPolicy<8192, BoundaryMode::FINGERPRINT>;
+using LargeFingerprintChunkingPolicy = ChunkingPolicy<65536, BoundaryMode::FINGERPRINT>;
+
+/**
+* Get chunking policy ID by its command line name.
+* @param[in] name policy name (small, default, large; with -fp suffix for fingerprint boundaries)
+* @param[out] id policy ID
+* @return True if the name is known.
+*/
+constexpr bool chunking_policy_from_name(std::string_view name, uint8_t& id) noexcept {
+	if (name == "small")
+		id = SmallChunkingPolicy::ID;
+	else if (name == "default")
+		id = DefaultChunkingPolicy::ID;
+	else if (name == "large")
+		id = LargeChunkingPolicy::ID;
+	else if (name == "small-fp")
+		id = SmallFingerprintChunkingPolicy::ID;
+	else if (name == "default-fp")
+		id = DefaultFingerprintChunkingPolicy::ID;
+	else if (name == "large-fp")
+		id = LargeFingerprintChunkingPolicy::ID;
+	else
+		return false;
+	return true;
+}
+
+/**
+* Get chunking policy name by its ID.
+* @param[in] id policy ID
+* @return Policy name or "unknown".
+*/
+constexpr const char* chunking_policy_name(uint8_t id) noexcept {
+	switch (id) {
+		case SmallChunkingPolicy::ID:   return "small";
+		case DefaultChunkingPolicy::ID: return "default";
+		case LargeChunkingPolicy::ID:   return "large";
+		case SmallFingerprintChunkingPolicy::ID:   return "small-fp";
+		case DefaultFingerprintChunkingPolicy::ID: return "default-fp";
+		case LargeFingerprintChunkingPolicy::ID:   return "large-fp";
+		default:                        return "unknown";
+	}
+}
+
+#endif
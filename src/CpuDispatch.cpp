@@ -0,0 +1,97 @@
+#include "CpuDispatch.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define RH_CPU_X86
+#if defined(_MSC_VER)
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+#endif
+
+namespace {
+
+CpuIsa probe_isa() noexcept
+{
+#if !defined(RH_CPU_X86)
+	return CpuIsa::SCALAR;
+#elif defined(_MSC_VER)
+	int regs[4];
+	__cpuid(regs, 0);
+	if (regs[0] < 7)
+		return CpuIsa::SSE2;
+	__cpuid(regs, 1);
+	const bool osxsave = (regs[2] & (1 << 27)) != 0;
+	const bool avx = (regs[2] & (1 << 28)) != 0;
+	if (!osxsave || !avx)
+		return CpuIsa::SSE2;
+	const unsigned long long xcr0 = _xgetbv(0);
+	if ((xcr0 & 0x6) != 0x6)								// OS must save YMM registers
+		return CpuIsa::SSE2;
+	__cpuidex(regs, 7, 0);
+	if ((regs[1] & (1 << 5)) == 0)
+		return CpuIsa::SSE2;
+	const bool avx512 = (regs[1] & (1 << 16)) != 0 && (regs[1] & (1 << 30)) != 0;
+	if (avx512 && (xcr0 & 0xE6) == 0xE6)					// ... and opmask and ZMM registers
+		return CpuIsa::AVX512;
+	return CpuIsa::AVX2;
+#else
+	// Checks OS support of the extended registers as well.
+	__builtin_cpu_init();
+	if (!__builtin_cpu_supports("avx2"))
+		return CpuIsa::SSE2;
+	if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw"))
+		return CpuIsa::AVX512;
+	return CpuIsa::AVX2;
+#endif
+}
+
+CpuIsa forced_isa(CpuIsa detected) noexcept
+{
+#if defined(_MSC_VER)
+#pragma warning(suppress: 4996)
+#endif
+	const char* value = std::getenv(FORCE_ISA_ENV);
+	CpuIsa isa;
+	if (value == nullptr || !cpu_isa_from_name(value, isa))
+		return detected;
+	return std::min(isa, detected);
+}
+
+} // namespace
+
+CpuIsa cpu_detected_isa() noexcept
+{
+	static const CpuIsa detected = probe_isa();
+	return detected;
+}
+
+CpuIsa cpu_best_isa() noexcept
+{
+	static const CpuIsa best = forced_isa(cpu_detected_isa());
+	return best;
+}
+
+const char* cpu_isa_name(CpuIsa isa) noexcept
+{
+	switch (isa) {
+		case CpuIsa::SCALAR: return "scalar";
+		case CpuIsa::SSE2:   return "sse2";
+		case CpuIsa::AVX2:   return "avx2";
+		case CpuIsa::AVX512: return "avx512";
+		default:             return "unknown";
+	}
+}
+
+bool cpu_isa_from_name(std::string_view name, CpuIsa& isa) noexcept
+{
+	for (CpuIsa candidate : { CpuIsa::SCALAR, CpuIsa::SSE2, CpuIsa::AVX2, CpuIsa::AVX512 }) {
+		if (name == cpu_isa_name(candidate)) {
+			isa = candidate;
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,78 @@
+#ifndef CPUDISPATCH_HPP
+#define CPUDISPATCH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/**
+* Instruction set level of SIMD kernels. Values are ordered - every ISA includes the
+* previous ones, so a kernel for ISA X can run on every CPU whose level is >= X.
+*/
+enum class CpuIsa : uint8_t {
+	SCALAR,
+	SSE2,
+	AVX2,
+	AVX512					/*!< AVX-512 F and BW */
+};
+
+/**
+* Environment variable capping the ISA used by kernels (scalar, sse2, avx2, avx512),
+* e.g. RH_FORCE_ISA=scalar runs everything through the portable kernels.
+*/
+constexpr const char* FORCE_ISA_ENV = "RH_FORCE_ISA";
+
+/**
+* Get the best ISA supported by the CPU and the OS. Probed once, on the first call.
+* @return Detected ISA.
+*/
+CpuIsa cpu_detected_isa() noexcept;
+
+/**
+* Get the ISA kernels are selected for: the detected one, capped by FORCE_ISA_ENV
+* if it is set. Evaluated once, on the first call.
+* @return ISA to be used by kernels.
+*/
+CpuIsa cpu_best_isa() noexcept;
+
+/**
+* Get the name of the ISA (for diagnostics).
+* @param[in] isa instruction set
+* @return Name of the instruction set.
+*/
+const char* cpu_isa_name(CpuIsa isa) noexcept;
+
+/**
+* Get ISA by its name.
+* @param[in] name ISA name (scalar, sse2, avx2, avx512)
+* @param[out] isa instruction set
+* @return True if the name is known.
+*/
+bool cpu_isa_from_name(std::string_view name, CpuIsa& isa) noexcept;
+
+/**
+* Implementation of a kernel for the given ISA - entry of a kernel table.
+*/
+template <class Fn>
+struct IsaKernel {
+	CpuIsa isa;				/*!< Minimum ISA required by the implementation */
+	Fn fn;					/*!< Implementation */
+};
+
+/**
+* Select the best kernel implementation runnable at the given ISA level.
+* @param[in] table implementations ordered from the best ISA down to a SCALAR one
+* @param[in] isa ISA level
+* @return Selected kernel table entry.
+*/
+template <class Fn, size_t N>
+constexpr const IsaKernel<Fn>& select_kernel(const IsaKernel<Fn> (&table)[N], CpuIsa isa) noexcept {
+	static_assert(N > 0, "Kernel table must not be empty");
+	for (size_t i = 0; i + 1 < N; i++) {
+		if (table[i].isa <= isa)
+			return table[i];
+	}
+	return table[N - 1];
+}
+
+#endif
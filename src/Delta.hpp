@@ -2,6 +2,9 @@
 #define DELTA_HPP
 
 #include "Signature.hpp"
+#include "ByteCompare.hpp"
+#include "ChunkStats.hpp"
+#include "DeltaHeader.hpp"
 #include "FileIO.hpp"
 
 #include <string>
@@ -9,9 +12,11 @@
 #include <unordered_map>
 #include <algorithm>
 #include <bit>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <filesystem>
+#include <memory>
 #include <optional>
 #include <span>
 #include <utility>
@@ -30,10 +35,10 @@ enum class EntryType : uint8_t {
 /**
 * Structure representing single delta record.
 */
-template <class T>
+template <class T, size_t HashSize>
 struct DeltaEntry {
     EntryType type;									/*!< Entry type (original, added etc) */
-    SignedChunk<T> chunk_data;						/*!< Signed chunk structure connected to the delta */
+    typename ChunkTable<T, HashSize>::Ref chunk_data;	/*!< Signed chunk connected to the delta */
     std::vector<uint8_t> chunk_data_raw;			/*!< Raw chunk data (only for added and modified) */
 };
 
@@ -46,8 +51,10 @@ struct DeltaEntry {
 * - Proper error handling with Result structure
 * - Modular design with clear phases
 */
-template<RollingHashAlgorithm T, StrongHashAlgorithm U>
+template<RollingHashAlgorithm T, StrongHashAlgorithm U, ChunkingPolicyType P = DefaultChunkingPolicy>
 class Delta {
+    static constexpr size_t SUPER_CHUNK_THRESHOLD = 65536;  // Old chunk count from which super-chunks are matched first
+
 public:
     /**
     * Result of delta generation with error handling
@@ -57,8 +64,21 @@ public:
         std::string error_message;
         size_t chunks_processed;
         size_t bytes_written;
+        DeltaStats stats;           // Matched, modified, added and removed bytes
     };
 
+    /**
+    * Set amount of old file chunks from which generate_delta() matches super-chunks
+    * (see Signature::build_super_chunks()) before single chunks. Chunks of matched
+    * super-chunks are emitted as ORIGINAL without lookups, and only chunks of old
+    * super-chunks left unmatched are indexed for chunk-level matching - for mostly
+    * unchanged large files this keeps the chunk index small.
+    * @param[in] chunks minimum amount of old file chunks (0 - always)
+    */
+    void set_super_chunk_threshold(size_t chunks) noexcept {
+        super_chunk_threshold_ = chunks;
+    }
+
     /**
     * Generates delta between two files with optimized algorithm.
     * @param[in] original original file signatures
@@ -68,13 +88,14 @@ public:
     * @param[in] delta_file delta file path
     * @return Result structure with success status, error message, and statistics
     */
-    Result generate_delta(const Signature<T, U>& original,
-                         const Signature<T, U>& newfile,
+    Result generate_delta(const Signature<T, U, P>& original,
+                         const Signature<T, U, P>& newfile,
                          const std::filesystem::path& oldfile,
                          const std::filesystem::path& file_to_check,
                          const std::filesystem::path& delta_file)
     {
-        Result result{false, "", 0, 0};
+        const auto start = std::chrono::steady_clock::now();
+        Result result{false, "", 0, 0, {}};
 
         // Open files with error checking
         FileIO old, file, delta;
@@ -82,58 +103,116 @@ public:
             return result;
         }
 
+        writeDeltaHeader(delta, result);
+
         const auto& original_chunks = original.get_chunks();
         const auto& new_chunks = newfile.get_chunks();
 
-        // Build hash map for O(1) chunk lookups
-        auto chunk_map = buildChunkMap(original_chunks);
-
         // Process chunks with optimized algorithm
         if (original_chunks.size() == 1 && new_chunks.size() == 1) {
             processSingleChunkFiles(original_chunks[0], new_chunks[0], old, file, delta, result);
+        } else if (original_chunks.size() >= super_chunk_threshold_) {
+            processSuperChunks(original, newfile, old, file, delta, result);
         } else {
-            processMultipleChunks(original_chunks, new_chunks, chunk_map, old, file, delta, result);
+            // Build hash map for O(1) chunk lookups
+            std::vector<bool> original_used(original_chunks.size(), false);
+            auto chunk_map = buildChunkMap(original_chunks, original_used, result);
+            processMultipleChunks(original_chunks, new_chunks, chunk_map, original_used, old, file, delta, result);
         }
 
         old.close();
         file.close();
         delta.close();
 
+        result.stats.elapsed_ms = elapsed_ms_since(start);
         result.success = true;
         return result;
     }
 
-private:
-    // Hash function for chunk lookup
-    struct ChunkHash {
-        size_t operator()(const SignedChunk<typename T::RollingHashType>& chunk) const {
-            // Combine signature and first few hash bytes for unique key
-            size_t h1 = std::hash<typename T::RollingHashType>{}(chunk.signature);
-            size_t h2 = chunk.hash.size() >= 8 ?
-                       *reinterpret_cast<const size_t*>(chunk.hash.data()) : 0;
-            return h1 ^ (h2 << 1);
+    /**
+    * Generates delta against the new file read once, sequentially, from the given input,
+    * which may be a non-seekable stream (pipe, standard input). The new file is chunked
+    * by the given signature object and every chunk's entry is written as soon as the
+    * chunk is found, so neither the new file nor its chunk list is kept in memory. The
+    * delta is the same as generate_delta() produces for the same files. Chunking of the
+    * new file overlaps with writing, so stats.elapsed_ms covers both.
+    * @param[in] original original file signatures
+    * @param[in] chunker signature object used to chunk the new file (its threads setting applies)
+    * @param[in] new_input open new file input, read from its current position
+    * @param[in] oldfile old file path
+    * @param[in] delta_file delta file path
+    * @return Result structure with success status, error message, and statistics
+    */
+    Result generate_delta_stream(const Signature<T, U, P>& original,
+                                 Signature<T, U, P>& chunker,
+                                 FileIO& new_input,
+                                 const std::filesystem::path& oldfile,
+                                 const std::filesystem::path& delta_file)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        Result result{false, "", 0, 0, {}};
+
+        FileIO old, delta;
+        if (!new_input.is_open()) {
+            result.error_message = "New file input is not open";
+            return result;
         }
-    };
+        if (!old.open(oldfile, FileMode::IN)) {
+            result.error_message = "Failed to open old file: " + oldfile.string();
+            return result;
+        }
+        if (!delta.open(delta_file, FileMode::OUT)) {
+            result.error_message = "Failed to create delta file: " + delta_file.string();
+            return result;
+        }
+
+        writeDeltaHeader(delta, result);
 
-    struct ChunkEqual {
-        bool operator()(const SignedChunk<typename T::RollingHashType>& a,
-                       const SignedChunk<typename T::RollingHashType>& b) const {
-            return a == b;
+        const auto& original_chunks = original.get_chunks();
+        std::vector<bool> original_used(original_chunks.size(), false);
+        auto chunk_map = buildChunkMap(original_chunks, original_used, result);
+        size_t i = 0;
+
+        chunker.visit_chunks(new_input, [&](const Chunk& new_chunk, std::span<const uint8_t> data) {
+            processNewChunk(i++, new_chunk,
+                            [data] { return std::make_unique<std::vector<uint8_t>>(data.begin(), data.end()); },
+                            original_chunks, chunk_map, original_used, old, delta, result);
+        });
+
+        processRemovedChunks(original_chunks, original_used, delta, result);
+
+        old.close();
+        if (!delta.close()) {
+            result.error_message = "Failed to write delta file: " + delta_file.string();
+            return result;
         }
-    };
 
-    using ChunkMap = std::unordered_map<SignedChunk<typename T::RollingHashType>,
-                                        size_t, ChunkHash, ChunkEqual>;
+        result.stats.elapsed_ms = elapsed_ms_since(start);
+        result.success = true;
+        return result;
+    }
+
+private:
+    using Table = typename Signature<T, U, P>::Table;
+    using Chunk = typename Table::Ref;
+    using Entry = DeltaEntry<typename T::RollingHashType, U::HASH_SIZE>;
+    using SuperTable = typename Signature<T, U, P>::SuperTable;
+
+    // Chunks are keyed by signature combined with the first hash bytes
+    using ChunkMap = std::unordered_map<Chunk, size_t, typename Table::RefHash>;
+    using SuperChunkMap = std::unordered_map<typename SuperTable::Ref, size_t, typename SuperTable::RefHash>;
 
     /**
-    * Build hash map of chunks for O(1) lookups
+    * Build hash map of chunks not used yet for O(1) lookups
     */
-    ChunkMap buildChunkMap(const std::vector<SignedChunk<typename T::RollingHashType>>& chunks) {
+    ChunkMap buildChunkMap(const Table& chunks, const std::vector<bool>& used, Result& result) {
         ChunkMap map;
         map.reserve(chunks.size());
         for (size_t i = 0; i < chunks.size(); ++i) {
-            map[chunks[i]] = i;
+            if (!used[i])
+                map[chunks[i]] = i;
         }
+        result.stats.indexed_chunks = map.size();
         return map;
     }
 
@@ -161,15 +240,11 @@ private:
     /**
     * Process single chunk files
     */
-    void processSingleChunkFiles(const SignedChunk<typename T::RollingHashType>& old_chunk,
-                                 const SignedChunk<typename T::RollingHashType>& new_chunk,
+    void processSingleChunkFiles(const Chunk& old_chunk, const Chunk& new_chunk,
                                  FileIO& old, FileIO& file, FileIO& delta, Result& result) {
-        DeltaEntry<typename T::RollingHashType> entry;
+        Entry entry{ EntryType::ORIGINAL_CHUNK, old_chunk, {} };
 
-        if (old_chunk == new_chunk) {
-            entry.type = EntryType::ORIGINAL_CHUNK;
-            entry.chunk_data = old_chunk;
-        } else {
+        if (!(old_chunk == new_chunk)) {
             entry.type = EntryType::MODIFIED_CHUNK;
             entry.chunk_data = new_chunk;
 
@@ -190,76 +265,154 @@ private:
     * for any unmatched old chunks. This ordering lets the applier append each
     * entry directly to the output without reordering.
     */
-    void processMultipleChunks(const std::vector<SignedChunk<typename T::RollingHashType>>& original_chunks,
-                               const std::vector<SignedChunk<typename T::RollingHashType>>& new_chunks,
-                               const ChunkMap& chunk_map,
+    void processMultipleChunks(const Table& original_chunks, const Table& new_chunks,
+                               const ChunkMap& chunk_map, std::vector<bool>& original_used,
                                FileIO& old, FileIO& file, FileIO& delta, Result& result) {
-        std::vector<bool> original_used(original_chunks.size(), false);
-
         for (size_t i = 0; i < new_chunks.size(); ++i) {
-            DeltaEntry<typename T::RollingHashType> entry;
+            const auto new_chunk = new_chunks[i];
+            processNewChunk(i, new_chunk,
+                            [&] { return file.read_chunk(new_chunk.chunk_size, new_chunk.start_offset); },
+                            original_chunks, chunk_map, original_used, old, delta, result);
+        }
 
-            // Identical chunk at same position.
-            if (i < original_chunks.size() && !original_used[i] &&
-                original_chunks[i] == new_chunks[i]) {
-                entry.type = EntryType::ORIGINAL_CHUNK;
-                entry.chunk_data = original_chunks[i];
-                original_used[i] = true;
-                writeDeltaEntry(delta, entry, result);
-                result.chunks_processed++;
-                continue;
+        processRemovedChunks(original_chunks, original_used, delta, result);
+    }
+
+    /**
+    * Emit delta entries in target order matching super-chunks first. New super-chunks
+    * are matched to unused old ones (same position preferred), and the chunks of
+    * matched old super-chunks are reserved. Only the remaining old chunks are indexed;
+    * chunks of unmatched new super-chunks go through the per-chunk logic against them.
+    */
+    void processSuperChunks(const Signature<T, U, P>& original, const Signature<T, U, P>& newfile,
+                            FileIO& old, FileIO& file, FileIO& delta, Result& result) {
+        const auto& original_chunks = original.get_chunks();
+        const auto& new_chunks = newfile.get_chunks();
+        const SuperTable original_supers = original.build_super_chunks();
+        const SuperTable new_supers = newfile.build_super_chunks();
+
+        SuperChunkMap super_map;
+        super_map.reserve(original_supers.size());
+        for (size_t k = 0; k < original_supers.size(); ++k)
+            super_map[original_supers[k]] = k;
+
+        // Match super-chunks, reserve chunks of matched old ones.
+        constexpr size_t NO_MATCH = SIZE_MAX;
+        std::vector<size_t> matched(new_supers.size(), NO_MATCH);
+        std::vector<bool> super_used(original_supers.size(), false);
+        std::vector<bool> original_used(original_chunks.size(), false);
+
+        for (size_t k = 0; k < new_supers.size(); ++k) {
+            size_t m = NO_MATCH;
+            if (k < original_supers.size() && !super_used[k] && original_supers[k] == new_supers[k]) {
+                m = k;
+            } else if (auto it = super_map.find(new_supers[k]); it != super_map.end() && !super_used[it->second]) {
+                m = it->second;
             }
+            if (m == NO_MATCH)
+                continue;
 
-            // Moved match: same content located elsewhere in old.
-            auto it = chunk_map.find(new_chunks[i]);
-            if (it != chunk_map.end() && !original_used[it->second]) {
-                entry.type = EntryType::ORIGINAL_CHUNK;
-                entry.chunk_data = new_chunks[i];
-                original_used[it->second] = true;
-                writeDeltaEntry(delta, entry, result);
-                result.chunks_processed++;
+            matched[k] = m;
+            super_used[m] = true;
+            const size_t first = original_chunks.lower_bound(original_supers[m].start_offset);
+            std::fill_n(original_used.begin() + first, original_supers[m].signature, true);
+            result.stats.matched_super_chunks++;
+        }
+
+        auto chunk_map = buildChunkMap(original_chunks, original_used, result);
+
+        size_t i = 0;
+        for (size_t k = 0; k < new_supers.size(); ++k) {
+            const size_t count = new_supers[k].signature;
+
+            if (matched[k] != NO_MATCH) {
+                const size_t first = original_chunks.lower_bound(original_supers[matched[k]].start_offset);
+                for (size_t c = 0; c < count; ++c) {
+                    Entry entry{ EntryType::ORIGINAL_CHUNK, original_chunks[first + c], {} };
+                    writeDeltaEntry(delta, entry, result);
+                    result.chunks_processed++;
+                }
+                i += count;
                 continue;
             }
 
-            // Modification of the same-position old chunk, otherwise an addition.
-            bool is_modification = false;
-            if (i < original_chunks.size() && !original_used[i]) {
-                entry.type = EntryType::MODIFIED_CHUNK;
-                entry.chunk_data = new_chunks[i];
-
-                auto old_data = old.read_chunk(original_chunks[i].chunk_size,
-                                              original_chunks[i].start_offset);
-                auto new_data = file.read_chunk(new_chunks[i].chunk_size,
-                                               new_chunks[i].start_offset);
-
-                if (old_data && new_data) {
-                    entry.chunk_data_raw = createOptimizedDiff(*old_data, *new_data);
-                    is_modification = true;
-                    original_used[i] = true;
-                }
+            for (size_t c = 0; c < count; ++c, ++i) {
+                const auto new_chunk = new_chunks[i];
+                processNewChunk(i, new_chunk,
+                                [&] { return file.read_chunk(new_chunk.chunk_size, new_chunk.start_offset); },
+                                original_chunks, chunk_map, original_used, old, delta, result);
             }
+        }
 
-            if (!is_modification) {
-                entry.type = EntryType::ADDED_CHUNK;
-                entry.chunk_data = new_chunks[i];
+        processRemovedChunks(original_chunks, original_used, delta, result);
+    }
 
-                auto chunk_data = file.read_chunk(entry.chunk_data.chunk_size,
-                                                 entry.chunk_data.start_offset);
-                if (chunk_data) {
-                    entry.chunk_data_raw = std::move(*chunk_data);
-                }
-            }
+    /**
+    * Emit the delta entry for the i-th chunk of the new file. Data of the new chunk
+    * is requested through read_new only for ADDED and MODIFIED entries.
+    */
+    template <class ReadNew>
+    void processNewChunk(size_t i, const Chunk& new_chunk, ReadNew&& read_new,
+                         const Table& original_chunks, const ChunkMap& chunk_map,
+                         std::vector<bool>& original_used, FileIO& old, FileIO& delta, Result& result) {
+        Entry entry{ EntryType::ORIGINAL_CHUNK, new_chunk, {} };
+
+        // Identical chunk at same position.
+        if (i < original_chunks.size() && !original_used[i] &&
+            original_chunks[i] == new_chunk) {
+            entry.type = EntryType::ORIGINAL_CHUNK;
+            entry.chunk_data = original_chunks[i];
+            original_used[i] = true;
+            writeDeltaEntry(delta, entry, result);
+            result.chunks_processed++;
+            return;
+        }
 
+        // Moved match: same content located elsewhere in old.
+        auto it = chunk_map.find(new_chunk);
+        if (it != chunk_map.end() && !original_used[it->second]) {
+            entry.type = EntryType::ORIGINAL_CHUNK;
+            original_used[it->second] = true;
             writeDeltaEntry(delta, entry, result);
             result.chunks_processed++;
+            return;
         }
 
-        // Removed chunks: any old chunk not consumed above.
+        // Modification of the same-position old chunk, otherwise an addition.
+        auto new_data = read_new();
+        bool is_modification = false;
+        if (i < original_chunks.size() && !original_used[i]) {
+            entry.type = EntryType::MODIFIED_CHUNK;
+
+            auto old_data = old.read_chunk(original_chunks[i].chunk_size,
+                                          original_chunks[i].start_offset);
+
+            if (old_data && new_data) {
+                entry.chunk_data_raw = createOptimizedDiff(*old_data, *new_data);
+                is_modification = true;
+                original_used[i] = true;
+            }
+        }
+
+        if (!is_modification) {
+            entry.type = EntryType::ADDED_CHUNK;
+            if (new_data) {
+                entry.chunk_data_raw = std::move(*new_data);
+            }
+        }
+
+        writeDeltaEntry(delta, entry, result);
+        result.chunks_processed++;
+    }
+
+    /**
+    * Emit REMOVED entries for old chunks not consumed by any new chunk.
+    */
+    void processRemovedChunks(const Table& original_chunks, const std::vector<bool>& original_used,
+                              FileIO& delta, Result& result) {
         for (size_t i = 0; i < original_chunks.size(); ++i) {
             if (!original_used[i]) {
-                DeltaEntry<typename T::RollingHashType> entry;
-                entry.type = EntryType::REMOVED_CHUNK;
-                entry.chunk_data = original_chunks[i];
+                Entry entry{ EntryType::REMOVED_CHUNK, original_chunks[i], {} };
                 writeDeltaEntry(delta, entry, result);
                 result.chunks_processed++;
             }
@@ -282,11 +435,10 @@ private:
 
         while (i < old_data.size() && j < new_data.size()) {
             // Find runs of matching bytes
-            while (i < old_data.size() && j < new_data.size() &&
-                   old_data[i] == new_data[j]) {
-                i++;
-                j++;
-            }
+            const size_t same = common_prefix_length(std::span<const uint8_t>(old_data).subspan(i),
+                                                     std::span<const uint8_t>(new_data).subspan(j));
+            i += same;
+            j += same;
 
             // Find runs of differences
             size_t diff_start = i;
@@ -345,11 +497,39 @@ private:
         }
     }
 
+    /**
+    * Write delta file header recording the chunking policy and the strong hash
+    */
+    void writeDeltaHeader(FileIO& delta, Result& result) {
+        DeltaHeader header;
+        header.chunking_policy = P::ID;
+        header.strong_hash = U::ID;
+        header.hash_size = static_cast<uint8_t>(U::HASH_SIZE);
+        auto encoded = encode_delta_header(header);
+        result.bytes_written += encoded.size();
+        delta.write_chunk(encoded);
+    }
+
+    /**
+    * Account delta entry in the statistics
+    */
+    void countDeltaEntry(const Entry& entry, DeltaStats& stats) {
+        const size_t size = entry.chunk_data.chunk_size;
+        switch (entry.type) {
+            case EntryType::ORIGINAL_CHUNK: stats.original_chunks++; stats.original_bytes += size; break;
+            case EntryType::MODIFIED_CHUNK: stats.modified_chunks++; stats.modified_bytes += size; break;
+            case EntryType::ADDED_CHUNK:    stats.added_chunks++;    stats.added_bytes += size;    break;
+            case EntryType::REMOVED_CHUNK:  stats.removed_chunks++;  stats.removed_bytes += size;  break;
+        }
+        stats.payload_bytes += entry.chunk_data_raw.size();
+    }
+
     /**
     * Write delta entry to file
     */
-    void writeDeltaEntry(FileIO& delta, const DeltaEntry<typename T::RollingHashType>& entry,
-                        Result& result) {
+    void writeDeltaEntry(FileIO& delta, const Entry& entry, Result& result) {
+        countDeltaEntry(entry, result.stats);
+
         result.bytes_written += sizeof(uint64_t); // Entry type
         delta.write_chunk(static_cast<uint64_t>(std::to_underlying(entry.type)));
 
@@ -367,6 +547,8 @@ private:
             delta.write_chunk(entry.chunk_data_raw);
         }
     }
+
+    size_t super_chunk_threshold_{ SUPER_CHUNK_THRESHOLD };
 };
 
 #endif // DELTA_HPP
@@ -0,0 +1,62 @@
+#include "DeltaHeader.hpp"
+
+#include "ChunkingPolicy.hpp"
+#include "StrongHash.hpp"
+
+#include <algorithm>
+#include <fstream>
+
+namespace {
+
+constexpr std::array<uint8_t, 4> DELTA_MAGIC = { 'R', 'H', 'D', 'T' };
+
+} // namespace
+
+void legacy_delta_header(DeltaHeader& header) noexcept
+{
+	header.version = 0;
+	header.chunking_policy = DefaultChunkingPolicy::ID;
+	header.strong_hash = DefaultStrongHash::ID;
+	header.hash_size = DefaultStrongHash::HASH_SIZE;
+}
+
+std::array<uint8_t, DELTA_HEADER_SIZE> encode_delta_header(const DeltaHeader& header) noexcept
+{
+	std::array<uint8_t, DELTA_HEADER_SIZE> out{};
+	std::copy(DELTA_MAGIC.begin(), DELTA_MAGIC.end(), out.begin());
+	out[4] = header.version;
+	out[5] = header.chunking_policy;
+	out[6] = header.strong_hash;
+	out[7] = header.hash_size;
+	return out;
+}
+
+bool decode_delta_header(std::span<const uint8_t> data, DeltaHeader& header) noexcept
+{
+	if (data.size() < DELTA_HEADER_SIZE || !std::equal(DELTA_MAGIC.begin(), DELTA_MAGIC.end(), data.begin()))
+		return false;
+
+	header.version = data[4];
+	header.chunking_policy = data[5];
+	if (header.version < 2) {
+		header.strong_hash = DefaultStrongHash::ID;
+		header.hash_size = DefaultStrongHash::HASH_SIZE;
+	} else {
+		header.strong_hash = data[6];
+		header.hash_size = data[7];
+	}
+	return true;
+}
+
+bool read_delta_header(const std::filesystem::path& delta_file, DeltaHeader& header)
+{
+	std::ifstream file(delta_file, std::ios::binary);
+	if (!file)
+		return false;
+
+	std::array<uint8_t, DELTA_HEADER_SIZE> data{};
+	file.read(reinterpret_cast<char*>(data.data()), data.size());
+	if (!decode_delta_header(std::span<const uint8_t>(data.data(), static_cast<size_t>(file.gcount())), header))
+		legacy_delta_header(header);
+	return true;
+}
@@ -0,0 +1,62 @@
+#ifndef DELTAHEADER_HPP
+#define DELTAHEADER_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+
+constexpr size_t DELTA_HEADER_SIZE = 8;
+constexpr uint8_t DELTA_FORMAT_VERSION = 2;
+
+/**
+* Header written at the beginning of every delta file. It records parameters which
+* Apply needs to regenerate the old file signature the same way Delta did.
+*
+* Layout (8 bytes): 'R' 'H' 'D' 'T' | version:u8 | chunking_policy:u8 | strong_hash:u8 | hash_size:u8
+*
+* Version 1 deltas have the last two bytes zero and always use BLAKE-512. Deltas
+* written before the header was introduced start directly with the first entry,
+* whose native u64 entry type can never match the magic. Such deltas are treated
+* as version 0 with the default chunking policy and BLAKE-512.
+*/
+struct DeltaHeader {
+	uint8_t version{ DELTA_FORMAT_VERSION };		/*!< Delta format version */
+	uint8_t chunking_policy{ 0 };					/*!< Chunking policy ID (see ChunkingPolicy) */
+	uint8_t strong_hash{ 0 };						/*!< Strong hash ID (see StrongHash) */
+	uint8_t hash_size{ 0 };							/*!< Strong hash size in bytes */
+};
+
+/**
+* Set header fields of a legacy delta (version 0, default chunking policy, BLAKE-512).
+* @param[out] header header to set
+*/
+void legacy_delta_header(DeltaHeader& header) noexcept;
+
+/**
+* Encode delta header.
+* @param[in] header header to encode
+* @return Encoded header bytes.
+*/
+std::array<uint8_t, DELTA_HEADER_SIZE> encode_delta_header(const DeltaHeader& header) noexcept;
+
+/**
+* Decode delta header.
+* @param[in] data first bytes of the delta file
+* @param[out] header decoded header
+* Version 1 headers get BLAKE-512 as the strong hash.
+* @return True if data starts with a delta header, false otherwise (legacy delta or too short).
+*/
+bool decode_delta_header(std::span<const uint8_t> data, DeltaHeader& header) noexcept;
+
+/**
+* Read header of the given delta file. For deltas without header, the header of a
+* legacy delta is returned (see legacy_delta_header).
+* @param[in] delta_file path to the delta file
+* @param[out] header read header
+* @return True if the file could be opened, false otherwise.
+*/
+bool read_delta_header(const std::filesystem::path& delta_file, DeltaHeader& header);
+
+#endif
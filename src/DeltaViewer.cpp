@@ -1,11 +1,17 @@
 #include "DeltaViewer.hpp"
 
+#include "ChunkingPolicy.hpp"
+#include "DeltaHeader.hpp"
+#include "StrongHash.hpp"
+
+#include <array>
 #include <cctype>
 #include <cstdint>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <limits>
+#include <span>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -164,9 +170,26 @@ int view_delta(const std::filesystem::path& delta_file) {
 	}
 
 	std::cout << "Delta File Viewer - Analyzing: " << delta_file << std::endl;
-	std::cout << "========================================" << std::endl << std::endl;
+	std::cout << "========================================" << std::endl;
+
+	std::array<uint8_t, DELTA_HEADER_SIZE> headerBytes{};
+	file.read(reinterpret_cast<char*>(headerBytes.data()), headerBytes.size());
+	DeltaHeader header;
+	if (decode_delta_header(std::span<const uint8_t>(headerBytes.data(), static_cast<size_t>(file.gcount())), header)) {
+		std::cout << "Format Version: " << static_cast<int>(header.version) << std::endl;
+		std::cout << "Chunking Policy: " << chunking_policy_name(header.chunking_policy)
+		          << " (" << static_cast<int>(header.chunking_policy) << ")" << std::endl;
+	} else {
+		legacy_delta_header(header);
+		std::cout << "Format Version: legacy (no header)" << std::endl;
+		file.clear();
+		file.seekg(0);
+	}
+	std::cout << "Strong Hash: " << strong_hash_name(header.strong_hash)
+	          << " (" << static_cast<int>(header.hash_size) << " bytes)" << std::endl;
+	std::cout << std::endl;
 
-	constexpr size_t hashSize = 64; // BLAKE-512
+	const size_t hashSize = header.hash_size;
 	int chunkNum = 0;
 	while (true) {
 		if (file.peek() == EOF) break;
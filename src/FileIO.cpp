@@ -25,6 +25,15 @@ bool FileIO::open(const std::filesystem::path& file_path, FileMode mode)
 	return f_.good();
 }
 
+bool FileIO::open_stdin()
+{
+#if defined(_WIN32)
+	return false;
+#else
+	return open("/dev/stdin", FileMode::IN);
+#endif
+}
+
 bool FileIO::close()
 {
 	f_.close();
@@ -72,6 +81,31 @@ std::unique_ptr<std::vector<uint8_t>> FileIO::read_chunk(size_t chunk_size, size
 	return read_chunk(chunk_size);
 }
 
+size_t FileIO::read_block(std::span<uint8_t> buffer)
+{
+	if (!f_.is_open() || buffer.empty())
+		return 0;
+
+	f_.read(reinterpret_cast<char*>(buffer.data()), buffer.size());
+	return static_cast<size_t>(f_.gcount());
+}
+
+size_t FileIO::read_block(std::span<uint8_t> buffer, size_t position)
+{
+	// Non-seekable streams (pipes) have no position - they are read sequentially.
+	f_.clear();
+	if (f_.tellg() != std::streampos(-1))
+		f_.seekg(position);
+	return read_block(buffer);
+}
+
+bool FileIO::seek(size_t position)
+{
+	f_.clear();
+	f_.seekg(position);
+	return f_.good();
+}
+
 bool FileIO::write_chunk(std::unique_ptr<std::vector<uint8_t>> buffer)
 {
 	return write_chunk(*buffer);
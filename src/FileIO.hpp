@@ -40,6 +40,13 @@ public:
 	*/
 	bool open(const std::filesystem::path& file_path, FileMode mode);
 
+	/**
+	* Open standard input for reading (not supported on Windows). Standard input is
+	* usually not seekable, so it can be only read sequentially.
+	* @return True if standard input was opened successfully, false otherwise.
+	*/
+	bool open_stdin();
+
 	/**
 	* Close previously opened file.
 	* @return True if the file closed cleanly (any pending writes flushed),
@@ -81,6 +88,23 @@ public:
 	* @return Pointer to vector of bytes read from stream.
 	*/
 	std::unique_ptr<std::vector<uint8_t>> read_chunk(size_t chunk_size, size_t position);
+
+	/**
+	* Read multiple bytes from stream directly into caller-provided buffer.
+	* @param[out] buffer destination buffer, up to buffer.size() bytes are read
+	* @return Amount of bytes read. Less than buffer.size() only if EOF was reached.
+	*/
+	size_t read_block(std::span<uint8_t> buffer);
+
+	/**
+	* Read multiple bytes from stream starting from specified position directly into
+	* caller-provided buffer. Non-seekable streams ignore the position and continue
+	* reading sequentially.
+	* @param[out] buffer destination buffer, up to buffer.size() bytes are read
+	* @param[in] position starting position
+	* @return Amount of bytes read. Less than buffer.size() only if EOF was reached.
+	*/
+	size_t read_block(std::span<uint8_t> buffer, size_t position);
 	
 	/**
 	* Write multiple bytes to stream.
@@ -111,6 +135,13 @@ public:
 	*/
 	bool write_chunk(const uint8_t* chunk, size_t chunk_size);
 
+	/**
+	* Set read position in the stream. Clears EOF state.
+	* @param[in] position new read position
+	* @return True if position was set successfully, false otherwise.
+	*/
+	bool seek(size_t position);
+
 	/**
 	* Check if file is open.
 	* @return True if file is opened, otherwise false.
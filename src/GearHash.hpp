@@ -0,0 +1,185 @@
+#ifndef GEARHASH_HPP
+#define GEARHASH_HPP
+
+#include "IRollingHash.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+constexpr unsigned int GEAR_WINDOW_SIZE = 64;
+
+/**
+* Generate Gear table - 256 pseudo-random 64-bit values (splitmix64 sequence).
+* Table is generated at compile time so that every build uses the same values.
+*/
+constexpr std::array<uint64_t, 256> make_gear_table(uint64_t seed) {
+	std::array<uint64_t, 256> table{};
+	for (auto& entry : table) {
+		seed += 0x9E3779B97F4A7C15ULL;
+		uint64_t z = seed;
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		entry = z ^ (z >> 31);
+	}
+	return table;
+}
+
+/**
+* GearHash is a class that implements the Gear rolling hash used by FastCDC.
+* Every byte costs one shift, one add and one table lookup. As the hash is shifted
+* left with every byte, only the last 64 bytes influence it, so the window size is fixed.
+*
+* Besides the byte-at-a-time interface the class provides find_cut_point() which is
+* used by Signature to place chunk boundaries the FastCDC way: first min_size bytes
+* are skipped, then a stricter mask is used below target_size and a looser one above
+* it (normalized chunking), which keeps chunk sizes close to the target.
+*
+* Class has only primitive types so moving and copying can be done using default copy constructor and assignment operator.
+*/
+class GearHash : public IRollingHash<uint64_t> {
+public:
+	GearHash() = default;
+
+	GearHash(const GearHash& other) = default;
+	GearHash(GearHash&& other) = default;
+	GearHash& operator=(const GearHash& other) = default;
+	GearHash& operator=(GearHash&& other) = default;
+
+	/**
+	* Computes initial hash value.
+	* @param initial[in] initial data to be hashed - must be at least window_size length (but still only window_size bytes will be used).
+	* @return True if init was successful, otherwise false (if initial data is too short).
+	*/
+	bool initialize(std::span<const uint8_t> initial) noexcept override {
+		if (initial.size() < GEAR_WINDOW_SIZE)
+			return false;
+
+		fingerprint_ = 0;
+		for (unsigned int i = 0; i < GEAR_WINDOW_SIZE; i++)
+			fingerprint_ = (fingerprint_ << 1) + GEAR_TABLE[initial[i]];
+		return true;
+	}
+
+	/**
+	* Compute the next hash value for the given data.
+	* @param[in] data the data byte to be hashed.
+	* @return the new rolling hash value.
+	*/
+	uint64_t compute_next(uint8_t byte) noexcept override {
+		fingerprint_ = (fingerprint_ << 1) + GEAR_TABLE[byte];
+		return fingerprint_;
+	}
+
+	/**
+	* Roll the hash over all bytes of data (see IRollingHash::roll()) with the state
+	* kept in a local.
+	* @param[in] data bytes to be added to the rolling hash
+	* @param[in] predicate callable invoked as predicate(value), returning bool
+	* @param[out] positions cut points found in data
+	* @return Current rolling hash value (unchanged if data is empty).
+	*/
+	template <class Predicate>
+	uint64_t roll(std::span<const uint8_t> data, Predicate&& predicate, std::vector<size_t>& positions) {
+		uint64_t fingerprint = fingerprint_;
+		for (size_t i = 0; i < data.size(); i++) {
+			fingerprint = (fingerprint << 1) + GEAR_TABLE[data[i]];
+			if (predicate(fingerprint))
+				positions.push_back(i + 1);
+		}
+		fingerprint_ = fingerprint;
+		return fingerprint;
+	}
+
+	/**
+	* Roll the hash over all bytes of data.
+	* @param[in] data bytes to be added to the rolling hash
+	* @return Current rolling hash value (unchanged if data is empty).
+	*/
+	uint64_t roll(std::span<const uint8_t> data) {
+		std::vector<size_t> none;
+		return roll(data, [](uint64_t) { return false; }, none);
+	}
+
+	/**
+	* Find FastCDC cut point in the data starting at chunk start.
+	* After the call, current fingerprint is the hash of the last window before the cut.
+	* @param[in] data data starting at chunk start
+	* @param[in] min_size minimum chunk size, cut points below it are not checked
+	* @param[in] target_size desired average chunk size (power of two)
+	* @param[in] max_size maximum chunk size
+	* @return Chunk length - at most max_size, or data size if no cut point was found.
+	*/
+	size_t find_cut_point(std::span<const uint8_t> data, size_t min_size, size_t target_size, size_t max_size) noexcept {
+		const size_t size = std::min(data.size(), max_size);
+		const size_t skip = std::min(size, min_size);
+		const size_t normal = std::clamp(target_size, skip, size);
+		const unsigned int bits = std::bit_width(target_size) - 1;
+		const uint64_t mask_small = top_bits(bits + 2);
+		const uint64_t mask_large = top_bits(bits > 2 ? bits - 2 : 1);
+
+		// Skipped bytes cannot be cut points, but the last window of them has to be hashed.
+		size_t i = skip > GEAR_WINDOW_SIZE ? skip - GEAR_WINDOW_SIZE : 0;
+		fingerprint_ = 0;
+		for (; i < skip; i++)
+			fingerprint_ = (fingerprint_ << 1) + GEAR_TABLE[data[i]];
+
+		for (; i < normal; i++) {
+			fingerprint_ = (fingerprint_ << 1) + GEAR_TABLE[data[i]];
+			if (!(fingerprint_ & mask_small))
+				return i + 1;
+		}
+
+		for (; i < size; i++) {
+			fingerprint_ = (fingerprint_ << 1) + GEAR_TABLE[data[i]];
+			if (!(fingerprint_ & mask_large))
+				return i + 1;
+		}
+
+		return size;
+	}
+
+	/**
+	* Get alphabet size.
+	* @return Alphabet size.
+	*/
+	unsigned int get_alphabet_size() const override {
+		return 256;
+	}
+
+	/**
+	* Return rolling hash window size.
+	* @return Window size.
+	*/
+	unsigned int get_window_size() const override {
+		return GEAR_WINDOW_SIZE;
+	}
+
+	/**
+	* Get current rolling hash value.
+	* @return Current rolling hash value.
+	*/
+	uint64_t get_current_fingerprint() const override {
+		return fingerprint_;
+	}
+
+private:
+	/**
+	* Mask selecting the given amount of the most significant bits. High bits are
+	* used as they depend on the whole window, low bits only on the last few bytes.
+	*/
+	static constexpr uint64_t top_bits(unsigned int bits) noexcept {
+		return bits >= 64 ? ~0ULL : ~(~0ULL >> bits);
+	}
+
+	static constexpr std::array<uint64_t, 256> GEAR_TABLE = make_gear_table(0x6765617268617368ULL);
+
+	uint64_t fingerprint_{ 0 };									/*!< Current fingerprint */
+};
+
+
+#endif
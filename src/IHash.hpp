@@ -1,6 +1,7 @@
 #ifndef IHASH_HPP
 #define IHASH_HPP
 
+#include <algorithm>
 #include <cstdint>
 #include <cstddef>
 #include <span>
@@ -27,6 +28,41 @@ public:
 	* @param in[in] input to be hashed
 	*/
 	virtual void hash(std::span<uint8_t> out, std::span<const uint8_t> in) = 0;
+
+	/**
+	* Computes hashes of several independent inputs - hash of inputs[i] is stored in
+	* outputs[i] (extra entries of the longer span are ignored). The result is the same
+	* as of hash() called for every input; implementations may hash several inputs
+	* at once. Default implementation hashes them one by one.
+	* @param inputs[in] inputs to be hashed
+	* @param outputs[out] buffers to store hashes
+	*/
+	virtual void hash_many(std::span<const std::span<const uint8_t>> inputs,
+	                       std::span<const std::span<uint8_t>> outputs) {
+		const size_t count = std::min(inputs.size(), outputs.size());
+		for (size_t i = 0; i < count; i++)
+			hash(outputs[i], inputs[i]);
+	}
+
+	/**
+	* Start incremental hashing. Input is then passed by any amount of update() calls
+	* and the hash is obtained by final(). The result is the same as of hash() called
+	* with all passed input concatenated. Incremental state is independent of hash().
+	*/
+	virtual void init() = 0;
+
+	/**
+	* Pass next part of the input to the incremental hash.
+	* @param in[in] input to be hashed (may be empty)
+	*/
+	virtual void update(std::span<const uint8_t> in) = 0;
+
+	/**
+	* Finish incremental hashing and store the hash in the given buffer. init() has
+	* to be called before the object is used for incremental hashing again.
+	* @param out[out] buffer to store hash.
+	*/
+	virtual void final(std::span<uint8_t> out) = 0;
 };
 
 
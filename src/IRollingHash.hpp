@@ -2,6 +2,7 @@
 #define IROLLINGHASH_HPP
 
 #include <vector>
+#include <cstddef>
 #include <cstdint>
 #include <span>
 
@@ -52,7 +53,41 @@ public:
 	* @return Current rolling hash value.
 	*/
 	virtual T get_current_fingerprint() const = 0;
-	
+
+	/**
+	* Roll the hash over all bytes of data. predicate(value) is called with the rolling hash
+	* value after every byte; positions of bytes for which it returns true are appended
+	* to positions as offsets just past the byte (index + 1), i.e. candidate cut points.
+	*
+	* This generic version calls compute_next() for every byte. Implementations hide it
+	* with their own non-virtual roll() working on local copies of the state in a tight
+	* loop; callers using the concrete type (like Signature) get that one. The result
+	* must be the same as of compute_next() called for every byte.
+	* @param[in] data bytes to be added to the rolling hash
+	* @param[in] predicate callable invoked as predicate(value), returning bool
+	* @param[out] positions cut points found in data
+	* @return Current rolling hash value (unchanged if data is empty).
+	*/
+	template <class Predicate>
+	T roll(std::span<const uint8_t> data, Predicate&& predicate, std::vector<size_t>& positions) {
+		T value = get_current_fingerprint();
+		for (size_t i = 0; i < data.size(); i++) {
+			value = compute_next(data[i]);
+			if (predicate(value))
+				positions.push_back(i + 1);
+		}
+		return value;
+	}
+
+	/**
+	* Roll the hash over all bytes of data.
+	* @param[in] data bytes to be added to the rolling hash
+	* @return Current rolling hash value (unchanged if data is empty).
+	*/
+	T roll(std::span<const uint8_t> data) {
+		std::vector<size_t> none;
+		return roll(data, [](const T&) { return false; }, none);
+	}
 };
 
 
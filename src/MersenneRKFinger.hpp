@@ -0,0 +1,184 @@
+#ifndef MERSENNERKFINGER_HPP
+#define MERSENNERKFINGER_HPP
+
+#include "IRollingHash.hpp"
+#include "RK_finger.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+constexpr uint64_t MERSENNE61_MODULUS = (1ULL << 61) - 1;
+
+/**
+* Reduce value modulo 2^61-1 without division: 2^61 = 1 (mod 2^61-1), so the bits above
+* bit 60 are folded back onto the low bits.
+* @param[in] value value to be reduced
+* @return Value modulo 2^61-1.
+*/
+constexpr uint64_t reduce_mersenne61(uint64_t value) noexcept {
+	value = (value & MERSENNE61_MODULUS) + (value >> 61);
+	return value >= MERSENNE61_MODULUS ? value - MERSENNE61_MODULUS : value;
+}
+
+/**
+* MersenneRKFinger is a Rabin-Karp rolling hash over a window of the last window_size
+* bytes with base 256 and modulus 2^61-1. Compared to RKFinger it is division free:
+*  - multiplication by the base is a shift, folded back by reduce_mersenne61(),
+*  - contribution of the byte leaving the window (byte * 256^(window_size-1)) is taken
+*    from a 256-entry table computed at construction,
+* and its values carry 61 bits instead of 31. Leaving bytes are kept in a ring buffer,
+* so the value depends only on the bytes in the window.
+*
+* Class has only value members so moving and copying can be done using default copy constructor and assignment operator.
+*/
+class MersenneRKFinger : public IRollingHash<uint64_t> {
+public:
+	static constexpr bool WINDOWED = true;			// Value depends only on the window (see WindowedRollingHash)
+
+	explicit MersenneRKFinger(unsigned int window_size = WINDOW_DEF_SIZE)
+		: window_size_(window_size ? window_size : 1), window_(window_size_, 0) {
+		uint64_t factor = 1;										// 256^(window_size-1) mod 2^61-1
+		for (unsigned int i = 1; i < window_size_; i++)
+			factor = multiply_by_base(factor);
+		for (size_t b = 1; b < out_table_.size(); b++)
+			out_table_[b] = reduce_mersenne61(out_table_[b - 1] + factor);
+	}
+
+	MersenneRKFinger(const MersenneRKFinger& other) = default;
+	MersenneRKFinger(MersenneRKFinger&& other) = default;
+	MersenneRKFinger& operator=(const MersenneRKFinger& other) = default;
+	MersenneRKFinger& operator=(MersenneRKFinger&& other) = default;
+
+	/**
+	* Computes initial hash value.
+	* Can be used to clear current hash and initialize the object with new data.
+	* @param initial[in] initial data to be hashed - must be at least window_size length (but still only window_size bytes will be used).
+	* @return True if init was successful, otherwise false (if initial data is too short).
+	*/
+	bool initialize(std::span<const uint8_t> initial) noexcept override {
+		if (initial.size() < window_size_)
+			return false;
+
+		fingerprint_ = 0;
+		for (unsigned int i = 0; i < window_size_; i++) {
+			window_[i] = initial[i];
+			fingerprint_ = reduce_mersenne61(multiply_by_base(fingerprint_) + initial[i]);
+		}
+		position_ = 0;
+		return true;
+	}
+
+	/**
+	* Compute the next hash value for the given data.
+	* @param[in] data the data byte to be hashed.
+	* @return the new rolling hash value.
+	*/
+	uint64_t compute_next(uint8_t byte) noexcept override {
+		const uint8_t leaving = window_[position_];
+		window_[position_] = byte;
+		if (++position_ == window_size_)
+			position_ = 0;
+
+		// removed < 2^62, so the folded product stays below 2 * (2^61-1) and one subtraction reduces it.
+		const uint64_t removed = fingerprint_ + MERSENNE61_MODULUS - out_table_[leaving];
+		const uint64_t next = ((removed << 8) & MERSENNE61_MODULUS) + (removed >> 53) + byte;
+		fingerprint_ = next >= MERSENNE61_MODULUS ? next - MERSENNE61_MODULUS : next;
+		return fingerprint_;
+	}
+
+	/**
+	* Roll the hash over all bytes of data (see IRollingHash::roll()) with the state
+	* kept in locals.
+	* @param[in] data bytes to be added to the rolling hash
+	* @param[in] predicate callable invoked as predicate(value), returning bool
+	* @param[out] positions cut points found in data
+	* @return Current rolling hash value (unchanged if data is empty).
+	*/
+	template <class Predicate>
+	uint64_t roll(std::span<const uint8_t> data, Predicate&& predicate, std::vector<size_t>& positions) {
+		uint8_t* window = window_.data();
+		unsigned int position = position_;
+		uint64_t fingerprint = fingerprint_;
+
+		for (size_t i = 0; i < data.size(); i++) {
+			const uint8_t byte = data[i];
+			const uint64_t removed = fingerprint + MERSENNE61_MODULUS - out_table_[window[position]];
+			window[position] = byte;
+			if (++position == window_size_)
+				position = 0;
+
+			const uint64_t next = ((removed << 8) & MERSENNE61_MODULUS) + (removed >> 53) + byte;
+			fingerprint = next >= MERSENNE61_MODULUS ? next - MERSENNE61_MODULUS : next;
+			if (predicate(fingerprint))
+				positions.push_back(i + 1);
+		}
+
+		position_ = position;
+		fingerprint_ = fingerprint;
+		return fingerprint;
+	}
+
+	/**
+	* Roll the hash over all bytes of data.
+	* @param[in] data bytes to be added to the rolling hash
+	* @return Current rolling hash value (unchanged if data is empty).
+	*/
+	uint64_t roll(std::span<const uint8_t> data) {
+		std::vector<size_t> none;
+		return roll(data, [](uint64_t) { return false; }, none);
+	}
+
+	/**
+	* Get alphabet size.
+	* @return Alphabet size.
+	*/
+	unsigned int get_alphabet_size() const override {
+		return ALPHABET_DEF_SIZE;
+	}
+
+	/**
+	* Return rolling hash window size.
+	* @return Window size.
+	*/
+	unsigned int get_window_size() const override {
+		return window_size_;
+	}
+
+	/**
+	* Return modulus.
+	* @return Modulus.
+	*/
+	uint64_t get_modulus() const {
+		return MERSENNE61_MODULUS;
+	}
+
+	/**
+	* Get current rolling hash value.
+	* @return Current rolling hash value.
+	*/
+	uint64_t get_current_fingerprint() const override {
+		return fingerprint_;
+	}
+
+private:
+	/**
+	* Multiply reduced value by the base 256 modulo 2^61-1 (shift and fold).
+	* @param[in] value value below 2^61
+	* @return value * 256 mod 2^61-1.
+	*/
+	static constexpr uint64_t multiply_by_base(uint64_t value) noexcept {
+		return reduce_mersenne61(((value << 8) & MERSENNE61_MODULUS) + (value >> 53));
+	}
+
+	unsigned int window_size_;									/*!< Window size */
+	unsigned int position_{ 0 };								/*!< Ring buffer position of the oldest byte */
+	uint64_t fingerprint_{ 0 };									/*!< Current fingerprint */
+	std::vector<uint8_t> window_;								/*!< Bytes in the window (ring buffer) */
+	std::array<uint64_t, 256> out_table_{};						/*!< byte * 256^(window_size-1) mod 2^61-1 */
+};
+
+
+#endif
@@ -3,7 +3,10 @@
 
 #include "IRollingHash.hpp"
 
+#include <array>
+#include <bit>
 #include <vector>
+#include <cstddef>
 #include <cstdint>
 #include <climits>
 #include <span>
@@ -25,6 +28,8 @@ public:
 		: alphabet_size_(alphabet_size), window_size_(window_size), modulus_(modulus) {
 		for (unsigned int i = 0; i < window_size_ - 1; i++)
 			h_ = (h_ * alphabet_size_) % modulus_;
+		for (unsigned int b = 0; b < out_table_.size(); b++)
+			out_table_[b] = (b * h_) % modulus_;
 	}
 	
 	RKFinger(const RKFinger& other) = default;
@@ -57,11 +62,42 @@ public:
 	*/
 	uint64_t compute_next(uint8_t byte) noexcept override {
 		// Add modulus before subtraction to prevent underflow
-		fingerprint_ = (alphabet_size_ * ((fingerprint_ + modulus_) - (last_byte * h_) % modulus_) + byte) % modulus_;
+		fingerprint_ = (alphabet_size_ * ((fingerprint_ + modulus_) - out_table_[last_byte]) + byte) % modulus_;
 		last_byte = byte;
 		return fingerprint_;
 	}
 
+	/**
+	* Roll the hash over all bytes of data (see IRollingHash::roll()). State is kept in
+	* locals and, for the default modulus 2^31-1, the modulo is replaced by folding.
+	* @param[in] data bytes to be added to the rolling hash
+	* @param[in] predicate callable invoked as predicate(value), returning bool
+	* @param[out] positions cut points found in data
+	* @return Current rolling hash value (unchanged if data is empty).
+	*/
+	template <class Predicate>
+	uint64_t roll(std::span<const uint8_t> data, Predicate&& predicate, std::vector<size_t>& positions) {
+		if (modulus_ == MERSENNE31)
+			return roll_with(data, predicate, positions, [](uint64_t value) {
+				value = (value & MERSENNE31) + (value >> 31);
+				value = (value & MERSENNE31) + (value >> 31);
+				return value >= MERSENNE31 ? value - MERSENNE31 : value;
+			});
+
+		const uint64_t modulus = modulus_;
+		return roll_with(data, predicate, positions, [modulus](uint64_t value) { return value % modulus; });
+	}
+
+	/**
+	* Roll the hash over all bytes of data.
+	* @param[in] data bytes to be added to the rolling hash
+	* @return Current rolling hash value (unchanged if data is empty).
+	*/
+	uint64_t roll(std::span<const uint8_t> data) {
+		std::vector<size_t> none;
+		return roll(data, [](uint64_t) { return false; }, none);
+	}
+
 	/**
 	* Get alphabet size.
 	* @return Alphabet size.
@@ -95,12 +131,214 @@ public:
 	}
 	
 private:
+	static constexpr uint64_t MERSENNE31 = INT_MAX;				// 2^31-1 - default modulus
+
+	/**
+	* Roll loop with the given modulo reduction.
+	*/
+	template <class Predicate, class Reduce>
+	uint64_t roll_with(std::span<const uint8_t> data, Predicate& predicate, std::vector<size_t>& positions, Reduce reduce) {
+		const uint64_t alphabet_size = alphabet_size_;
+		const uint64_t modulus = modulus_;
+		uint64_t fingerprint = fingerprint_;
+		uint8_t last = last_byte;
+
+		for (size_t i = 0; i < data.size(); i++) {
+			fingerprint = reduce(alphabet_size * ((fingerprint + modulus) - out_table_[last]) + data[i]);
+			last = data[i];
+			if (predicate(fingerprint))
+				positions.push_back(i + 1);
+		}
+
+		fingerprint_ = fingerprint;
+		last_byte = last;
+		return fingerprint;
+	}
+
 	unsigned int alphabet_size_ { ALPHABET_DEF_SIZE };			/*!< Possible alphabet size */
 	unsigned int window_size_ { WINDOW_DEF_SIZE };				/*!< Window size */
 	uint64_t modulus_ {INT_MAX};								/*!< Modulus (this rolling hash is using modulus */
 	uint64_t fingerprint_ {0};									/*!< Current fingerprint */
 	uint64_t h_{ 0 };											/*!< Hash function coefficient */
 	uint8_t last_byte{ 0 };										/*!< Last byte of the window remembered for compute_next operation */
+	std::array<uint64_t, 256> out_table_{};						/*!< (byte * h_) % modulus_ for every byte value */
+};
+
+/**
+* StaticRKFinger is RKFinger with alphabet size, window size and modulus given as
+* template parameters. Hash function coefficient and the out-byte table are computed
+* at compile time and reduction modulo the constant modulus is done without division
+* (see reduce()), which compilers do not do on their own when optimizing for size.
+*
+* Coefficient is computed with the same recurrence as in RKFinger constructor, so
+* StaticRKFinger<Window, Base, Modulus> gives exactly the same fingerprints as
+* RKFinger(Base, Window, Modulus) and signature files of both are interchangeable.
+*
+* Class has only primitive types so moving and copying can be done using default copy constructor and assignment operator.
+*/
+template <unsigned int Window = WINDOW_DEF_SIZE, unsigned int Base = ALPHABET_DEF_SIZE, uint64_t Modulus = INT_MAX>
+class StaticRKFinger : public IRollingHash<uint64_t> {
+	static_assert(Window > 0, "Window must not be empty");
+	static_assert(Base > 0 && Modulus > 0, "Base and modulus must be positive");
+	static_assert(Modulus <= (UINT64_MAX - 255) / Base / 2, "Base * 2 * Modulus must fit in 64 bits");
+
+public:
+	static constexpr uint64_t H = [] {
+		uint64_t h = 0;
+		for (unsigned int i = 0; i < Window - 1; i++)
+			h = (h * Base) % Modulus;
+		return h;
+	}();
+
+	static constexpr std::array<uint64_t, 256> OUT_TABLE = [] {
+		std::array<uint64_t, 256> table{};
+		for (unsigned int b = 0; b < table.size(); b++)
+			table[b] = (b * H) % Modulus;
+		return table;
+	}();
+
+	StaticRKFinger() = default;
+
+	StaticRKFinger(const StaticRKFinger& other) = default;
+	StaticRKFinger(StaticRKFinger&& other) = default;
+	StaticRKFinger& operator=(const StaticRKFinger& other) = default;
+	StaticRKFinger& operator=(StaticRKFinger&& other) = default;
+
+	/**
+	* Computes initial hash value.
+	* Can be used to clear current hash and initialize the object with new data.
+	* @param initial[in] initial data to be hashed - must be at least Window length (but still only Window bytes will be used).
+	* @return True if init was successful, otherwise false (if initial data is too short).
+	*/
+	bool initialize(std::span<const uint8_t> initial) noexcept override {
+		if (initial.size() < Window)
+			return false;
+
+		fingerprint_ = 0;
+		last_byte_ = initial[Window - 1];
+		for (unsigned int i = 0; i < Window; i++)
+			fingerprint_ = (Base * fingerprint_ + initial[i]) % Modulus;
+		return true;
+	}
+
+	/**
+	* Compute the next hash value for the given data.
+	* @param[in] data the data byte to be hashed.
+	* @return the new rolling hash value.
+	*/
+	uint64_t compute_next(uint8_t byte) noexcept override {
+		fingerprint_ = next(fingerprint_, last_byte_, byte);
+		last_byte_ = byte;
+		return fingerprint_;
+	}
+
+	/**
+	* Roll the hash over all bytes of data (see IRollingHash::roll()) with the state
+	* kept in locals.
+	* @param[in] data bytes to be added to the rolling hash
+	* @param[in] predicate callable invoked as predicate(value), returning bool
+	* @param[out] positions cut points found in data
+	* @return Current rolling hash value (unchanged if data is empty).
+	*/
+	template <class Predicate>
+	uint64_t roll(std::span<const uint8_t> data, Predicate&& predicate, std::vector<size_t>& positions) {
+		uint64_t fingerprint = fingerprint_;
+		uint8_t last = last_byte_;
+
+		for (size_t i = 0; i < data.size(); i++) {
+			fingerprint = next(fingerprint, last, data[i]);
+			last = data[i];
+			if (predicate(fingerprint))
+				positions.push_back(i + 1);
+		}
+
+		fingerprint_ = fingerprint;
+		last_byte_ = last;
+		return fingerprint;
+	}
+
+	/**
+	* Roll the hash over all bytes of data.
+	* @param[in] data bytes to be added to the rolling hash
+	* @return Current rolling hash value (unchanged if data is empty).
+	*/
+	uint64_t roll(std::span<const uint8_t> data) {
+		std::vector<size_t> none;
+		return roll(data, [](uint64_t) { return false; }, none);
+	}
+
+	/**
+	* Get alphabet size.
+	* @return Alphabet size.
+	*/
+	unsigned int get_alphabet_size() const override {
+		return Base;
+	}
+
+	/**
+	* Return rolling hash window size.
+	* @return Window size.
+	*/
+	unsigned int get_window_size() const override {
+		return Window;
+	}
+
+	/**
+	* Return modulus.
+	* @return Modulus.
+	*/
+	uint64_t get_modulus() const {
+		return Modulus;
+	}
+
+	/**
+	* Get current rolling hash value.
+	* @return Current rolling hash value.
+	*/
+	uint64_t get_current_fingerprint() const override {
+		return fingerprint_;
+	}
+
+	/**
+	* Reduce value modulo Modulus without division. Mersenne moduli 2^k-1 (k >= 22, like
+	* the default 2^31-1) fold the bits above bit k-1 back onto the low bits, other moduli
+	* use Barrett reduction with a precomputed reciprocal where 128-bit multiplication
+	* is available.
+	* @param[in] value value to be reduced
+	* @return Value modulo Modulus.
+	*/
+	static constexpr uint64_t reduce(uint64_t value) noexcept {
+		if constexpr (MERSENNE_BITS >= 22) {
+			value = (value & Modulus) + (value >> MERSENNE_BITS);
+			value = (value & Modulus) + (value >> MERSENNE_BITS);
+			return value >= Modulus ? value - Modulus : value;
+		} else {
+#ifdef __SIZEOF_INT128__
+			// Quotient estimate is at most 2 below the exact one.
+			const uint64_t quotient = static_cast<uint64_t>((static_cast<unsigned __int128>(value) * RECIPROCAL) >> 64);
+			value -= quotient * Modulus;
+			value = value >= Modulus ? value - Modulus : value;
+			return value >= Modulus ? value - Modulus : value;
+#else
+			return value % Modulus;
+#endif
+		}
+	}
+
+private:
+	static constexpr unsigned int MERSENNE_BITS = (Modulus & (Modulus + 1)) == 0 ? std::bit_width(Modulus) : 0;	// k if Modulus is 2^k-1
+	static constexpr uint64_t RECIPROCAL = UINT64_MAX / Modulus;							// floor((2^64-1) / Modulus)
+
+	/**
+	* Single rolling step, the same as RKFinger::compute_next() with constant parameters.
+	*/
+	static constexpr uint64_t next(uint64_t fingerprint, uint8_t last, uint8_t byte) noexcept {
+		// Add modulus before subtraction to prevent underflow
+		return reduce(Base * ((fingerprint + Modulus) - OUT_TABLE[last]) + byte);
+	}
+
+	uint64_t fingerprint_{ 0 };									/*!< Current fingerprint */
+	uint8_t last_byte_{ 0 };									/*!< Last byte of the window remembered for compute_next operation */
 };
 
 
@@ -0,0 +1,261 @@
+#ifndef RABINFINGER_HPP
+#define RABINFINGER_HPP
+
+#include "IRollingHash.hpp"
+#include "RK_finger.hpp"
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+/**
+* Default polynomial of RabinFinger: x^53 + ... + 1, irreducible over GF(2).
+*/
+constexpr uint64_t RABIN_DEF_POLYNOMIAL = 0x3DA3358B4DC173ULL;
+
+/**
+* Polynomials over GF(2) are stored as bit masks - bit i is the coefficient of x^i.
+* Get degree of the polynomial.
+* @param[in] value polynomial
+* @return Degree, -1 for the zero polynomial.
+*/
+constexpr int gf2_degree(uint64_t value) noexcept {
+	return static_cast<int>(std::bit_width(value)) - 1;
+}
+
+/**
+* Reduce polynomial modulo another one over GF(2).
+* @param[in] value polynomial to be reduced
+* @param[in] modulus non-zero polynomial
+* @return Remainder of value divided by modulus.
+*/
+constexpr uint64_t gf2_mod(uint64_t value, uint64_t modulus) noexcept {
+	const int degree = gf2_degree(modulus);
+	while (gf2_degree(value) >= degree)
+		value ^= modulus << (gf2_degree(value) - degree);
+	return value;
+}
+
+/**
+* Multiply two polynomials modulo another one over GF(2).
+* @param[in] a first factor
+* @param[in] b second factor
+* @param[in] modulus polynomial of degree 1 to 63
+* @return a * b mod modulus.
+*/
+constexpr uint64_t gf2_mulmod(uint64_t a, uint64_t b, uint64_t modulus) noexcept {
+	const int degree = gf2_degree(modulus);
+	uint64_t result = 0;
+	a = gf2_mod(a, modulus);
+	for (; b; b >>= 1) {
+		if (b & 1)
+			result ^= a;
+		a <<= 1;
+		if (a >> degree)
+			a ^= modulus;
+	}
+	return gf2_mod(result, modulus);
+}
+
+/**
+* Check if the polynomial is irreducible over GF(2) (Ben-Or's test): polynomial P of
+* degree d is irreducible if gcd(P, x^(2^i) - x) = 1 for every i from 1 to d/2.
+* @param[in] polynomial polynomial of degree 1 to 63
+* @return True if the polynomial is irreducible.
+*/
+constexpr bool gf2_irreducible(uint64_t polynomial) noexcept {
+	const int degree = gf2_degree(polynomial);
+	if (degree < 1 || degree > 63)
+		return false;
+
+	uint64_t power = 2;												// x^(2^i) mod polynomial
+	for (int i = 1; i <= degree / 2; i++) {
+		power = gf2_mulmod(power, power, polynomial);
+		uint64_t a = polynomial, b = power ^ 2;
+		while (b) {
+			a = gf2_mod(a, b);
+			std::swap(a, b);
+		}
+		if (a != 1)
+			return false;
+	}
+	return true;
+}
+
+/**
+* RabinFinger is a Rabin fingerprint: the last window_size bytes of data are read as
+* a polynomial over GF(2) and reduced modulo an irreducible polynomial P of degree d.
+* Unlike RKFinger (integer polynomial hash) it uses only xors, shifts and table lookups:
+*  - pushing a byte shifts the fingerprint by 8 bits and reduces the 8 bits shifted
+*    above x^(d-1) with a 256-entry table of (b * x^d mod P) | (b << d),
+*  - the byte leaving the window is removed by xoring b * x^(8*(window_size-1)) mod P
+*    from a second 256-entry table,
+* as in LBFS and restic. For random data with irreducible P, fingerprint values are
+* uniformly distributed, which gives predictable chunk boundary distribution.
+* Leaving bytes are kept in a ring buffer, so the value depends only on the bytes in
+* the window.
+*
+* Polynomial degree has to be from 9 to 56 (fingerprint shifted by 8 bits must fit in
+* 64 bits), otherwise the default polynomial is used. Irreducibility is not checked on
+* construction - see gf2_irreducible().
+*
+* Class has only value members so moving and copying can be done using default copy constructor and assignment operator.
+*/
+class RabinFinger : public IRollingHash<uint64_t> {
+public:
+	static constexpr bool WINDOWED = true;			// Value depends only on the window (see WindowedRollingHash)
+
+	explicit RabinFinger(unsigned int window_size = WINDOW_DEF_SIZE, uint64_t polynomial = RABIN_DEF_POLYNOMIAL)
+		: window_size_(window_size ? window_size : 1),
+		  polynomial_(gf2_degree(polynomial) >= 9 && gf2_degree(polynomial) <= 56 ? polynomial : RABIN_DEF_POLYNOMIAL),
+		  shift_(static_cast<unsigned int>(gf2_degree(polynomial_)) - 8), window_(window_size_, 0) {
+		const unsigned int degree = shift_ + 8;
+		for (uint64_t b = 0; b < mod_table_.size(); b++)
+			mod_table_[b] = gf2_mod(b << degree, polynomial_) | (b << degree);
+
+		for (uint64_t b = 0; b < out_table_.size(); b++) {
+			uint64_t value = push(0, static_cast<uint8_t>(b));
+			for (unsigned int i = 1; i < window_size_; i++)
+				value = push(value, 0);
+			out_table_[b] = value;
+		}
+	}
+
+	RabinFinger(const RabinFinger& other) = default;
+	RabinFinger(RabinFinger&& other) = default;
+	RabinFinger& operator=(const RabinFinger& other) = default;
+	RabinFinger& operator=(RabinFinger&& other) = default;
+
+	/**
+	* Computes initial hash value.
+	* Can be used to clear current hash and initialize the object with new data.
+	* @param initial[in] initial data to be hashed - must be at least window_size length (but still only window_size bytes will be used).
+	* @return True if init was successful, otherwise false (if initial data is too short).
+	*/
+	bool initialize(std::span<const uint8_t> initial) noexcept override {
+		if (initial.size() < window_size_)
+			return false;
+
+		fingerprint_ = 0;
+		for (unsigned int i = 0; i < window_size_; i++) {
+			window_[i] = initial[i];
+			fingerprint_ = push(fingerprint_, initial[i]);
+		}
+		position_ = 0;
+		return true;
+	}
+
+	/**
+	* Compute the next hash value for the given data.
+	* @param[in] data the data byte to be hashed.
+	* @return the new rolling hash value.
+	*/
+	uint64_t compute_next(uint8_t byte) noexcept override {
+		const uint8_t leaving = window_[position_];
+		window_[position_] = byte;
+		if (++position_ == window_size_)
+			position_ = 0;
+
+		fingerprint_ = push(fingerprint_ ^ out_table_[leaving], byte);
+		return fingerprint_;
+	}
+
+	/**
+	* Roll the hash over all bytes of data (see IRollingHash::roll()) with the state
+	* kept in locals.
+	* @param[in] data bytes to be added to the rolling hash
+	* @param[in] predicate callable invoked as predicate(value), returning bool
+	* @param[out] positions cut points found in data
+	* @return Current rolling hash value (unchanged if data is empty).
+	*/
+	template <class Predicate>
+	uint64_t roll(std::span<const uint8_t> data, Predicate&& predicate, std::vector<size_t>& positions) {
+		uint8_t* window = window_.data();
+		unsigned int position = position_;
+		uint64_t fingerprint = fingerprint_;
+
+		for (size_t i = 0; i < data.size(); i++) {
+			const uint8_t byte = data[i];
+			fingerprint = push(fingerprint ^ out_table_[window[position]], byte);
+			window[position] = byte;
+			if (++position == window_size_)
+				position = 0;
+
+			if (predicate(fingerprint))
+				positions.push_back(i + 1);
+		}
+
+		position_ = position;
+		fingerprint_ = fingerprint;
+		return fingerprint;
+	}
+
+	/**
+	* Roll the hash over all bytes of data.
+	* @param[in] data bytes to be added to the rolling hash
+	* @return Current rolling hash value (unchanged if data is empty).
+	*/
+	uint64_t roll(std::span<const uint8_t> data) {
+		std::vector<size_t> none;
+		return roll(data, [](uint64_t) { return false; }, none);
+	}
+
+	/**
+	* Get alphabet size.
+	* @return Alphabet size.
+	*/
+	unsigned int get_alphabet_size() const override {
+		return ALPHABET_DEF_SIZE;
+	}
+
+	/**
+	* Return rolling hash window size.
+	* @return Window size.
+	*/
+	unsigned int get_window_size() const override {
+		return window_size_;
+	}
+
+	/**
+	* Return polynomial the fingerprint is computed modulo.
+	* @return Polynomial (bit i is the coefficient of x^i).
+	*/
+	uint64_t get_polynomial() const {
+		return polynomial_;
+	}
+
+	/**
+	* Get current rolling hash value.
+	* @return Current rolling hash value.
+	*/
+	uint64_t get_current_fingerprint() const override {
+		return fingerprint_;
+	}
+
+private:
+	/**
+	* Append byte to the fingerprint: value * x^8 + byte mod polynomial.
+	* @param[in] value fingerprint (degree below polynomial degree)
+	* @param[in] byte byte to be appended
+	* @return New fingerprint.
+	*/
+	uint64_t push(uint64_t value, uint8_t byte) const noexcept {
+		return ((value << 8) | byte) ^ mod_table_[value >> shift_];
+	}
+
+	unsigned int window_size_;									/*!< Window size */
+	uint64_t polynomial_;										/*!< Irreducible polynomial */
+	unsigned int shift_;										/*!< Polynomial degree - 8 */
+	unsigned int position_{ 0 };								/*!< Ring buffer position of the oldest byte */
+	uint64_t fingerprint_{ 0 };									/*!< Current fingerprint */
+	std::vector<uint8_t> window_;								/*!< Bytes in the window (ring buffer) */
+	std::array<uint64_t, 256> mod_table_{};						/*!< b * x^degree mod polynomial, with b * x^degree itself to clear the top byte */
+	std::array<uint64_t, 256> out_table_{};						/*!< b * x^(8 * (window_size - 1)) mod polynomial */
+};
+
+
+#endif
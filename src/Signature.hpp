@@ -4,162 +4,1076 @@
 #include "IHash.hpp"
 #include "IRollingHash.hpp"
 #include "FileIO.hpp"
+#include "BoundaryScan.hpp"
+#include "BoundedQueue.hpp"
+#include "ChunkingPolicy.hpp"
+#include "ChunkStats.hpp"
+#include "ChunkTable.hpp"
+#include "SignatureFile.hpp"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <filesystem>
+#include <optional>
 #include <vector>
 #include <concepts>
+#include <cstdint>
+#include <span>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
 
 template <class T>
 concept RollingHashAlgorithm =
 	requires { typename T::RollingHashType; } &&
 	std::derived_from<T, IRollingHash<typename T::RollingHashType>>;
 
-template <class U>
-concept StrongHashAlgorithm = std::derived_from<U, IHash>;
+/**
+* Rolling hash which places chunk boundaries on its own (e.g. GearHash). Such hash gets
+* the whole window together with chunk size limits instead of being fed byte by byte.
+*/
+template <class T>
+concept CutPointRollingHash = RollingHashAlgorithm<T> &&
+	requires(T& t, std::span<const uint8_t> data, size_t size) {
+		{ t.find_cut_point(data, size, size, size) } -> std::same_as<size_t>;
+	};
 
 /**
-* Structure representing signed chunk of data.
+* Rolling hash whose value depends only on the last window_size bytes (e.g. MersenneRKFinger,
+* BuzHash, RabinFinger). Such hash can be initialized anywhere in the data, and its own
+* value is used for fingerprint boundaries.
 */
 template <class T>
-struct SignedChunk {
-	T signature;						/*!< Rolling hash signature */
-	std::vector<uint8_t> hash;			/*!< Hash (strong) of data */
-	size_t start_offset;				/*!< Start offset of data in file */
-	size_t chunk_size;					/*!< Size of the chunk */
+concept WindowedRollingHash = RollingHashAlgorithm<T> &&
+	requires { { T::WINDOWED } -> std::convertible_to<bool>; } && T::WINDOWED;
 
-	bool operator==(const SignedChunk<T>& rhs) const {						// Check if two chunks are equal (don't check start offset)
-		return signature == rhs.signature && hash == rhs.hash && chunk_size == rhs.chunk_size;
-	}
+/**
+* Strong hash with hash size known at compile time (HASH_SIZE), so that hashes can be
+* stored inline in ChunkTable, and with ID recorded in the delta header (see StrongHash.hpp).
+*/
+template <class U>
+concept StrongHashAlgorithm = std::derived_from<U, IHash> &&
+	requires {
+		{ U::HASH_SIZE } -> std::convertible_to<size_t>;
+		{ U::ID } -> std::convertible_to<uint8_t>;
+	} && (U::HASH_SIZE > 0);
+
+template <class P>
+concept ChunkingPolicyType =
+	requires(size_t size) {
+		{ P::ID } -> std::convertible_to<uint8_t>;
+		{ P::BOUNDARY } -> std::convertible_to<BoundaryMode>;
+		{ P::MIN_CHUNK_SIZE } -> std::convertible_to<size_t>;
+		{ P::MAX_CHUNK_SIZE } -> std::convertible_to<size_t>;
+		{ P::TARGET_CHUNK_SIZE } -> std::convertible_to<size_t>;
+		{ P::SMALL_MASK } -> std::convertible_to<uint32_t>;
+		{ P::mask_for(size) } -> std::convertible_to<uint32_t>;
+	} && P::MIN_CHUNK_SIZE < P::MAX_CHUNK_SIZE;
+
+/**
+* Callable receiving chunks as they are found: visitor(chunk, data), where data is the
+* content of the chunk. Data span is valid only during the call.
+*/
+template <class F, class C>
+concept ChunkVisitor = std::invocable<F&, const C&, std::span<const uint8_t>>;
+
+/**
+* Range of bytes in a file.
+*/
+struct ByteRange {
+	size_t offset;						/*!< Offset of the first byte */
+	size_t size;						/*!< Amount of bytes */
 };
 
 /**
 * Signature class allowing generating signatures for specified file.
-* Class is template with two template parameters: the rolling hash algorithm and the hash algorithm.
+* Class is template with three template parameters: the rolling hash algorithm, the hash algorithm
+* and the chunking policy (chunk size limits and boundary mask schedule).
 */
-template <RollingHashAlgorithm T, StrongHashAlgorithm U>
+template <RollingHashAlgorithm T, StrongHashAlgorithm U, ChunkingPolicyType P = DefaultChunkingPolicy>
 class Signature {
-	static constexpr size_t MIN_CHUNK_SIZE = 512;     // Minimum chunk size in bytes
-	static constexpr size_t MAX_CHUNK_SIZE = 16384;   // Maximum chunk size in bytes (16KB)
-	static constexpr size_t TARGET_CHUNK_SIZE = 8192;  // Target average chunk size
+	static constexpr size_t MIN_CHUNK_SIZE = P::MIN_CHUNK_SIZE;	// Minimum chunk size in bytes
+	static constexpr size_t MAX_CHUNK_SIZE = P::MAX_CHUNK_SIZE;	// Maximum chunk size in bytes
+	static constexpr size_t TARGET_CHUNK_SIZE = P::TARGET_CHUNK_SIZE;	// Target average chunk size
+	static constexpr size_t READ_BLOCK_SIZE = 4 * 1024 * 1024;	// Size of a single read from the input file
+	static constexpr size_t MIN_SEGMENT_SIZE = 16 * 1024 * 1024;	// Minimum size of a segment chunked by single thread
+	static constexpr size_t HASH_QUEUE_SIZE = 1024;				// Amount of chunks waiting for strong hash in pipelined mode
+	static constexpr size_t HASH_BATCH = 8;						// Amount of chunks passed to the strong hash at once (hash_many)
+	static constexpr size_t SIGNATURE_FILE_BATCH = 4096;			// Amount of records read/written at once in signature file
+	static constexpr uint32_t SUPER_CHUNK_MASK = 64 - 1;			// Super-chunk ends after ~1/64 of chunks (by hash)
+	static constexpr size_t MAX_SUPER_CHUNK_CHUNKS = 256;			// Maximum amount of chunks in a super-chunk
+	static constexpr size_t BOUNDARY_WINDOW = 48;					// Window of the hash placing fingerprint boundaries (RKFinger)
+	static constexpr size_t BOUNDARY_ROLL_STEP = 1024;				// Bytes rolled at once while searching a fingerprint boundary
+
+	static_assert(BOUNDARY_WINDOW <= MIN_CHUNK_SIZE);
 
 public:
+	using Table = ChunkTable<typename T::RollingHashType, U::HASH_SIZE>;
+	using Chunk = typename Table::Ref;
+	using Policy = P;
+
+	/**
+	* Table of super-chunks - runs of consecutive chunks. Signature of a super-chunk is the
+	* amount of chunks in it, hash is the strong hash of the chunk hashes and sizes.
+	*/
+	using SuperTable = ChunkTable<uint32_t, U::HASH_SIZE>;
+
+	/**
+	* Set amount of threads used for signature generation. With more than one thread,
+	* files given by path large enough are split into segments chunked concurrently.
+	* Otherwise the scanning thread only finds chunk boundaries while remaining threads
+	* compute strong hashes of found chunks. In both modes the result is identical to
+	* the sequential one.
+	* @param[in] threads amount of threads (0 is treated as 1)
+	*/
+	void set_threads(unsigned int threads) noexcept {
+		threads_ = threads ? threads : 1;
+	}
+
+	/**
+	* Get amount of threads used for signature generation.
+	* @return Amount of threads.
+	*/
+	unsigned int get_threads() const noexcept {
+		return threads_;
+	}
+
+	/**
+	* Enable computing the strong hash of the whole file while chunking. Chunk data is
+	* fed to the incremental hash as it passes the scan buffer, so the file is not read
+	* a second time. Files given by path are then not split into concurrently chunked
+	* segments (pipelined hashing is still used with more than one thread).
+	* @param[in] enabled true to compute the file digest
+	*/
+	void set_file_digest(bool enabled) noexcept {
+		file_digest_enabled_ = enabled;
+	}
+
+	/**
+	* Get strong hash of the whole file computed by the last generate_signatures() or
+	* visit_chunks() call.
+	* @return File digest, empty if it was not enabled or the file was not scanned.
+	*/
+	const std::optional<typename Table::Hash>& get_file_digest() const noexcept {
+		return file_digest_;
+	}
+
 	/**
 	* Generate signatures by opening the given path and processing its contents.
+	* Chunks of a previous call are replaced.
 	* @param[in] datafile file with data for signatures to be generated
 	*/
 	void generate_signatures(const std::filesystem::path& datafile) {
-		FileIO file;
-		if (!file.open(datafile, FileMode::IN))
-			return;
-		generate_signatures(file);
+		const auto start = std::chrono::steady_clock::now();
+		chunks.clear();
+		file_digest_.reset();
+		std::error_code ec;
+		const auto file_size = std::filesystem::file_size(datafile, ec);
+		if (!ec && threads_ > 1 && file_size >= 2 * MIN_SEGMENT_SIZE && !file_digest_enabled_) {
+			generate_parallel(datafile, static_cast<size_t>(file_size));
+		} else {
+			FileIO file;
+			auto collect = collect_into(chunks);
+			if (file.open(datafile, FileMode::IN))
+				scan_file(file, collect);
+		}
+		record_stats(start);
 	}
 
 	/**
 	* Generate signatures by reading from an already-open FileIO. Data is read
 	* from offset 0; the file position at return is unspecified. The FileIO is
 	* not closed by this call.
+	*
+	* Input is read in READ_BLOCK_SIZE blocks. Chunks are always scanned over a
+	* contiguous span of the block buffer and handed to the strong hash without
+	* copying; only the unfinished tail of a block (less than MAX_CHUNK_SIZE) is
+	* moved to the front of the buffer before the next block is read.
 	* @param[in] file open FileIO to read from
 	*/
 	void generate_signatures(FileIO& file) {
-		if (!file.is_open())
-			return;
+		const auto start = std::chrono::steady_clock::now();
+		chunks.clear();
+		auto collect = collect_into(chunks);
+		scan_file(file, collect);
+		record_stats(start);
+	}
+
+	/**
+	* Chunk the file given by path and pass every chunk to the visitor as soon as it is
+	* signed, in file order. Chunks are not stored in the object, so memory use does not
+	* depend on the file size. With more than one thread, strong hashes are computed in
+	* pipelined mode (segment mode needs the whole chunk list and is not used).
+	* @param[in] datafile file with data for signatures to be generated
+	* @param[in] visitor callable invoked as visitor(chunk, data)
+	* @return True if the file was opened.
+	*/
+	template <ChunkVisitor<typename ChunkTable<typename T::RollingHashType, U::HASH_SIZE>::Ref> F>
+	bool visit_chunks(const std::filesystem::path& datafile, F&& visitor) {
+		FileIO file;
+		if (!file.open(datafile, FileMode::IN))
+			return false;
+		visit_chunks(file, std::forward<F>(visitor));
+		return true;
+	}
+
+	/**
+	* Chunk already-open FileIO from offset 0 and pass every chunk to the visitor as soon
+	* as it is signed, in file order. Non-seekable input (pipe) is read once, from its
+	* current position. The FileIO is not closed by this call. Statistics of visited
+	* chunks are available from get_stats() afterwards (time includes the visitor).
+	* @param[in] file open FileIO to read from
+	* @param[in] visitor callable invoked as visitor(chunk, data)
+	*/
+	template <ChunkVisitor<typename ChunkTable<typename T::RollingHashType, U::HASH_SIZE>::Ref> F>
+	void visit_chunks(FileIO& file, F&& visitor) {
+		const auto start = std::chrono::steady_clock::now();
+		stats_ = ChunkStats{};
+		auto counted = [&](const Chunk& chunk, std::span<const uint8_t> data) {
+			stats_.add(chunk.chunk_size, chunk.chunk_size == MAX_CHUNK_SIZE);
+			visitor(chunk, data);
+		};
+		scan_file(file, counted);
+		stats_.elapsed_ms = elapsed_ms_since(start);
+	}
+
+	/**
+	* Get chunk list.
+	* @return Table of signed chunks.
+	*/
+	const Table& get_chunks() const noexcept {
+		return chunks;
+	}
+
+	/**
+	* Get statistics of the chunk list produced by the last generate_signatures(),
+	* load_signatures() or refresh_signatures() call, or of the chunks passed by the
+	* last visit_chunks() call. Chunks of exactly MAX_CHUNK_SIZE bytes are counted as
+	* forced cuts; time is the duration of the whole call.
+	* @return Chunking statistics.
+	*/
+	const ChunkStats& get_stats() const noexcept {
+		return stats_;
+	}
+
+	/**
+	* Group the chunk list into content-defined super-chunks. A super-chunk ends after
+	* a chunk whose strong hash has the low SUPER_CHUNK_MASK bits clear (or after
+	* MAX_SUPER_CHUNK_CHUNKS chunks), so like chunk boundaries, super-chunk boundaries
+	* depend only on content and resynchronize after a change. Equal super-chunks
+	* consist of equal chunks, so whole runs can be matched without per-chunk lookups.
+	* The chunk data is not read again.
+	* @return Table of super-chunks covering the chunk list in order.
+	*/
+	SuperTable build_super_chunks() const {
+		SuperTable supers;
+		U hash_func;
+		typename SuperTable::Hash hash;
+		std::vector<uint8_t> run;
+		run.reserve(MAX_SUPER_CHUNK_CHUNKS * (U::HASH_SIZE + sizeof(uint32_t)));
+		size_t first = 0;
+
+		for (size_t i = 0; i < chunks.size(); i++) {
+			const auto chunk = chunks[i];
+			const size_t pos = run.size();
+			run.resize(pos + U::HASH_SIZE + sizeof(uint32_t));
+			std::copy(chunk.hash.begin(), chunk.hash.end(), run.begin() + pos);
+			store_le(run.data() + pos + U::HASH_SIZE, static_cast<uint32_t>(chunk.chunk_size));
+
+			uint32_t cut = 0;
+			for (size_t b = 0; b < std::min<size_t>(sizeof(cut), U::HASH_SIZE); b++)
+				cut |= static_cast<uint32_t>(chunk.hash[b]) << (8 * b);
+
+			if ((cut & SUPER_CHUNK_MASK) == 0 || i + 1 - first == MAX_SUPER_CHUNK_CHUNKS || i + 1 == chunks.size()) {
+				hash_func.hash(hash, run);
+				supers.push_back(static_cast<uint32_t>(i + 1 - first), hash, chunks[first].start_offset,
+				                 chunk.start_offset + chunk.chunk_size - chunks[first].start_offset);
+				run.clear();
+				first = i + 1;
+			}
+		}
+		return supers;
+	}
+
+	/**
+	* Save chunk list to the signature file (see SignatureFileHeader for the format).
+	* Size and modification time of the data file are recorded, so the signature file
+	* is rejected by load_signatures() once the data file changes.
+	* @param[in] signature_file path of the signature file to be written
+	* @param[in] datafile file the chunk list was generated for
+	* @return True if the signature file was written.
+	*/
+	bool save_signatures(const std::filesystem::path& signature_file, const std::filesystem::path& datafile) const
+		requires std::unsigned_integral<typename T::RollingHashType> {
+		SignatureFileHeader header;
+		header.chunking_policy = P::ID;
+		header.signature_size = sizeof(typename T::RollingHashType);
+		header.hash_size = static_cast<uint8_t>(U::HASH_SIZE);
+		header.chunk_count = chunks.size();
+		if (!stamp_signature_file_header(datafile, header))
+			return false;
+
+		FileIO file;
+		if (!file.open(signature_file, FileMode::OUT))
+			return false;
+		bool ok = file.write_chunk(encode_signature_file_header(header));
+
+		const size_t record_size = header.record_size();
+		std::vector<uint8_t> records;
+		records.reserve(SIGNATURE_FILE_BATCH * record_size);
+		for (size_t i = 0; i < chunks.size() && ok; i++) {
+			const auto& chunk = chunks[i];
+			const size_t pos = records.size();
+			records.resize(pos + record_size);
+			uint8_t* record = records.data() + pos;
+			store_le(record, chunk.signature);
+			store_le(record + header.signature_size, static_cast<uint64_t>(chunk.start_offset));
+			store_le(record + header.signature_size + 8, static_cast<uint64_t>(chunk.chunk_size));
+			std::copy(chunk.hash.begin(), chunk.hash.end(), record + header.signature_size + 16);
+
+			if (records.size() == records.capacity() || i + 1 == chunks.size()) {
+				ok = file.write_chunk(records);
+				records.clear();
+			}
+		}
+
+		return file.close() && ok;
+	}
+
+	/**
+	* Load chunk list from the signature file instead of generating it. The signature
+	* file must have been written with the same chunking policy, rolling and strong hash
+	* sizes, and the data file must still have the recorded size and modification time.
+	* @param[in] signature_file path of the signature file
+	* @param[in] datafile file the chunk list is loaded for
+	* @return True if the chunk list was loaded, false if the signature file is missing,
+	*         malformed, generated with different parameters or stale.
+	*/
+	bool load_signatures(const std::filesystem::path& signature_file, const std::filesystem::path& datafile)
+		requires std::unsigned_integral<typename T::RollingHashType> {
+		const auto start = std::chrono::steady_clock::now();
+		file_digest_.reset();
+		SignatureFileHeader expected, header;
+		Table loaded;
+		if (!stamp_signature_file_header(datafile, expected) || !read_signature_file(signature_file, header, loaded))
+			return false;
+		if (header.file_size != expected.file_size || header.file_mtime != expected.file_mtime)
+			return false;
+
+		chunks = std::move(loaded);
+		record_stats(start);
+		return true;
+	}
+
+	/**
+	* Generate signatures of a modified file reusing the signature file of its previous
+	* version (in-place updates, appends and truncation). Previous chunks outside of the
+	* changed ranges are read and their strong hash verified, which is much cheaper than
+	* chunking them; a chunk whose hash matches is reused. The file is rechunked from the
+	* start of a changed chunk - given in ranges or found by verification - until a
+	* boundary resynchronizes with the start of a reused chunk. As a chunk depends only
+	* on its own bytes, the result is identical to generate_signatures() (up to strong
+	* hash collisions).
+	*
+	* If the file size differs from the recorded one, the range between both sizes is
+	* treated as changed. Ranges are only a hint: they save reading chunks which are
+	* known to be changed, unreported changes are found by verification.
+	* @param[in] signature_file path of the signature file of the previous version
+	* @param[in] datafile modified file
+	* @param[in] changed ranges of the file changed since signature_file was written
+	* @return True if the previous signature was reused, false if signatures were
+	*         generated from scratch (signature file unusable or read error).
+	*/
+	bool refresh_signatures(const std::filesystem::path& signature_file, const std::filesystem::path& datafile,
+	                        std::span<const ByteRange> changed = {})
+		requires std::unsigned_integral<typename T::RollingHashType> {
+		const auto start = std::chrono::steady_clock::now();
+		file_digest_.reset();
+		SignatureFileHeader header;
+		Table previous;
+		std::error_code ec;
+		const auto file_size = std::filesystem::file_size(datafile, ec);
+
+		FileIO file;
+		if (ec || !file.open(datafile, FileMode::IN))
+			return false;
+
+		if (read_signature_file(signature_file, header, previous) &&
+		    refresh_from(file, previous, header.file_size, static_cast<size_t>(file_size), changed)) {
+			record_stats(start);
+			return true;
+		}
+
+		chunks.clear();
+		generate_signatures(file);
+		record_stats(start);
+		return false;
+	}
+
+private:
+	/**
+	* Read chunk list from the signature file and check that it matches the template
+	* parameters and tiles the recorded file size.
+	* @param[in] signature_file path of the signature file
+	* @param[out] header read header
+	* @param[out] out read chunk list
+	* @return True if the signature file is valid.
+	*/
+	static bool read_signature_file(const std::filesystem::path& signature_file, SignatureFileHeader& header,
+	                                Table& out) {
+		FileIO file;
+		if (!file.open(signature_file, FileMode::IN))
+			return false;
+
+		std::array<uint8_t, SIGNATURE_FILE_HEADER_SIZE> raw{};
+		if (file.read_block(raw) != raw.size() || !decode_signature_file_header(raw, header))
+			return false;
+		if (header.version != SIGNATURE_FILE_VERSION || header.chunking_policy != P::ID ||
+		    header.signature_size != sizeof(typename T::RollingHashType) ||
+		    header.hash_size != U::HASH_SIZE)
+			return false;
+
+		const size_t record_size = header.record_size();
+		std::vector<uint8_t> records(SIGNATURE_FILE_BATCH * record_size);
+		size_t next_offset = 0;
+		for (uint64_t left = header.chunk_count; left > 0; ) {
+			const size_t count = static_cast<size_t>(std::min<uint64_t>(left, SIGNATURE_FILE_BATCH));
+			auto batch = std::span<uint8_t>(records).first(count * record_size);
+			if (file.read_block(batch) != batch.size())
+				return false;
+
+			for (size_t i = 0; i < count; i++) {
+				const uint8_t* record = batch.data() + i * record_size;
+				const auto start_offset = load_le<uint64_t>(record + header.signature_size);
+				const auto chunk_size = load_le<uint64_t>(record + header.signature_size + 8);
+				if (start_offset != next_offset || chunk_size == 0 || chunk_size > UINT32_MAX)	// chunks must tile the file
+					return false;
+
+				out.push_back(load_le<typename T::RollingHashType>(record),
+				              std::span<const uint8_t, U::HASH_SIZE>(record + header.signature_size + 16, U::HASH_SIZE),
+				              static_cast<size_t>(start_offset), static_cast<size_t>(chunk_size));
+				next_offset += static_cast<size_t>(chunk_size);
+			}
+			left -= count;
+		}
+		return next_offset == header.file_size;
+	}
+
+	/**
+	* Build chunk list of the modified file from the previous one (see refresh_signatures()).
+	* A chunk depends only on its own bytes unless it was cut by the end of file, so
+	* previous chunk is reused if it starts where the current chunk starts, contains no
+	* changed byte, its strong hash matches the current data and - for the last previous
+	* chunk - the file size did not change.
+	* @param[in] file open modified file
+	* @param[in] previous chunk list of the previous version
+	* @param[in] previous_size size of the previous version
+	* @param[in] file_size size of the modified file
+	* @param[in] changed changed ranges of the file
+	* @return True if the chunk list was built, false on read error.
+	*/
+	bool refresh_from(FileIO& file, const Table& previous, size_t previous_size, size_t file_size,
+	                  std::span<const ByteRange> changed) {
+		// Changed ranges as sorted, merged [begin, end) intervals.
+		std::vector<std::pair<size_t, size_t>> dirty;
+		for (const auto& range : changed) {
+			if (range.size > 0)
+				dirty.emplace_back(range.offset, range.offset + range.size);
+		}
+		if (previous_size != file_size)
+			dirty.emplace_back(std::min(previous_size, file_size), std::max(previous_size, file_size));
+		std::sort(dirty.begin(), dirty.end());
+		size_t merged = 0;
+		for (const auto& range : dirty) {
+			if (merged > 0 && range.first <= dirty[merged - 1].second)
+				dirty[merged - 1].second = std::max(dirty[merged - 1].second, range.second);
+			else
+				dirty[merged++] = range;
+		}
+		dirty.resize(merged);
+
+		auto reusable = [&](const Chunk& chunk) {
+			const size_t end = chunk.start_offset + chunk.chunk_size;
+			if (end > file_size || (end == previous_size && previous_size != file_size))
+				return false;
+			auto it = std::upper_bound(dirty.begin(), dirty.end(), chunk.start_offset,
+				[](size_t offset, const std::pair<size_t, size_t>& range) { return offset < range.second; });
+			return it == dirty.end() || it->first >= end;
+		};
 
-		T fingerprint;
 		U hash_func;
-		size_t bytes_read = 0;
+		typename Table::Hash hash;
+		Table out;
+		size_t index = 0;
+
+		for (size_t pos = 0; pos < file_size; pos = out.end_offset()) {
+			index = previous.lower_bound(pos, index);
+
+			if (index < previous.size() && previous[index].start_offset == pos && reusable(previous[index])) {
+				const auto chunk = previous[index];
+				auto data = file.read_chunk(chunk.chunk_size, chunk.start_offset);
+				if (!data || data->size() != chunk.chunk_size)
+					return false;
+				hash_func.hash(hash, *data);
+				if (std::equal(hash.begin(), hash.end(), chunk.hash.begin())) {
+					out.push_back(chunk);
+					continue;
+				}
+				// Changed outside of the given ranges - rechunk.
+			}
+
+			if (!scan_one(file, pos, out))								// file shrank meanwhile
+				return false;
+		}
+
+		chunks = std::move(out);
+		fix_residual_signature();
+		return true;
+	}
 
-		auto res = file.read_chunk(fingerprint.get_window_size(), 0);
-		if (res->empty())
+	/**
+	* Chunk too short to compute the fingerprint (possible only at EOF) carries the
+	* signature of the previous chunk. Restore that if the list was assembled from
+	* independently scanned parts.
+	*/
+	void fix_residual_signature() {
+		if constexpr (!CutPointRollingHash<T>) {
+			if (!chunks.empty() && chunks.back().chunk_size <= T{}.get_window_size())
+				chunks.set_signature(chunks.size() - 1, chunks.size() > 1 ? chunks[chunks.size() - 2].signature : typename T::RollingHashType{});
+		}
+	}
+
+	/**
+	* Recompute statistics from the chunk list.
+	* @param[in] start time the chunk list generation started at
+	*/
+	void record_stats(std::chrono::steady_clock::time_point start) {
+		stats_ = ChunkStats{};
+		for (size_t i = 0; i < chunks.size(); i++)
+			stats_.add(chunks[i].chunk_size, chunks[i].chunk_size == MAX_CHUNK_SIZE);
+		stats_.elapsed_ms = elapsed_ms_since(start);
+	}
+
+	/**
+	* Get visitor appending chunks to the table.
+	* @param[out] out chunk table to append to
+	* @return Visitor copying passed chunks.
+	*/
+	static auto collect_into(Table& out) {
+		return [&out](const Chunk& chunk, std::span<const uint8_t>) { out.push_back(chunk); };
+	}
+
+	/**
+	* Chunk the whole file, pipelined if more than one thread is used.
+	* @param[in] file open file
+	* @param[in] visitor callable invoked as visitor(chunk, data)
+	*/
+	template <class F>
+	void scan_file(FileIO& file, F& visitor) {
+		file_digest_.reset();
+		if (!file.is_open())
 			return;
 
-		fingerprint.initialize(*res);
-		bytes_read += res->size();
+		if (!file_digest_enabled_) {
+			scan_chunks(file, visitor);
+			return;
+		}
+
+		// Chunks are visited in file order and cover the whole file.
+		U digest;
+		digest.init();
+		auto digesting = [&](const Chunk& chunk, std::span<const uint8_t> data) {
+			digest.update(data);
+			visitor(chunk, data);
+		};
+		scan_chunks(file, digesting);
+		digest.final(file_digest_.emplace());
+	}
+
+	/**
+	* Chunk the whole open file, pipelined if more than one thread is used.
+	* @param[in] file open file
+	* @param[in] visitor callable invoked as visitor(chunk, data)
+	*/
+	template <class F>
+	void scan_chunks(FileIO& file, F& visitor) {
+		if (threads_ > 1)
+			scan_pipelined(file, visitor);
+		else
+			scan_range(file, 0, SIZE_MAX, visitor);
+	}
 
-		std::vector<uint8_t> chunk(*res);
-		res.reset();
+	/**
+	* Chunk the file starting from given offset, which is treated as a chunk start.
+	* Chunks starting before stop offset are passed to the visitor (the last one may
+	* extend past stop). Found chunks are strong hashed HASH_BATCH at a time by
+	* hash_many() and visited in order before the buffer is refilled. A visitor returning
+	* bool stops the scan by returning false.
+	* @param[in] file open file
+	* @param[in] from offset of the first chunk
+	* @param[in] stop offset at which no more chunks are started
+	* @param[in] visitor callable invoked as visitor(chunk, data)
+	*/
+	template <class F>
+	void scan_range(FileIO& file, size_t from, size_t stop, F& visitor) {
+		struct Found {
+			typename T::RollingHashType fingerprint;
+			size_t offset;
+		};
+
+		T fingerprint;
+		U hash_func;
 		typename T::RollingHashType current_fingerprint{};
 
-		bool init = false;
+		std::array<Found, HASH_BATCH> found;
+		std::array<std::span<const uint8_t>, HASH_BATCH> inputs;		// data of found chunks, in buffer
+		std::array<typename Table::Hash, HASH_BATCH> hashes;
+		std::array<std::span<uint8_t>, HASH_BATCH> outputs;
+		std::copy(hashes.begin(), hashes.end(), outputs.begin());
+		size_t found_count = 0;
+		bool stopped = false;
 
-		while (true)
+		auto flush = [&] {
+			hash_func.hash_many(std::span(inputs).first(found_count), outputs);
+			for (size_t i = 0; i < found_count && !stopped; i++) {
+				const Chunk chunk{ found[i].fingerprint, hashes[i], found[i].offset, inputs[i].size() };
+				if constexpr (std::is_same_v<std::invoke_result_t<F&, const Chunk&, std::span<const uint8_t>>, bool>)
+					stopped = !visitor(chunk, inputs[i]);
+				else
+					visitor(chunk, inputs[i]);
+			}
+			found_count = 0;
+		};
+
+		std::vector<uint8_t> buffer(READ_BLOCK_SIZE + MAX_CHUNK_SIZE);
+		size_t buffer_offset = from;									// file offset of buffer[0]
+		size_t begin = 0;												// start of current chunk in buffer
+		size_t end = file.read_block(std::span<uint8_t>(buffer).first(READ_BLOCK_SIZE), from);
+		bool eof = end < READ_BLOCK_SIZE;
+
+		while (!stopped && buffer_offset + begin < stop)
 		{
-			if (init)														// init rolling hash for next chunk
+			if (!eof && end - begin < MAX_CHUNK_SIZE)					// not enough data for the longest chunk - refill
 			{
-				res = file.read_chunk(fingerprint.get_window_size());
-				if (res->empty())
+				flush();
+				if (stopped)
 					break;
-				fingerprint.initialize(*res);
-				bytes_read += res->size();
-				chunk = *res;
-				res.reset();
+				std::copy(buffer.begin() + begin, buffer.begin() + end, buffer.begin());
+				buffer_offset += begin;
+				end -= begin;
+				begin = 0;
 
-				init = false;
+				size_t bytes_read = file.read_block(std::span<uint8_t>(buffer).subspan(end, READ_BLOCK_SIZE));
+				eof = bytes_read < READ_BLOCK_SIZE;
+				end += bytes_read;
 			}
 
-			int b = file.read_byte();
-			if (b == EOF)
+			if (begin == end)
 				break;
-			bytes_read++;
-			uint8_t byte = static_cast<uint8_t>(b);
-			uint8_t last = chunk.back();
-			chunk.push_back(byte);
-
-			current_fingerprint = fingerprint.compute_next(byte);
-
-			// Adaptive boundary detection based on chunk size
-			bool boundary_found = false;
-			if (chunk.size() >= MAX_CHUNK_SIZE) {
-				// Force boundary at maximum chunk size
-				boundary_found = true;
-			} else if (chunk.size() >= MIN_CHUNK_SIZE) {
-				// Use adaptive mask based on chunk size for better small file handling
-				uint32_t mask;
-				if (chunk.size() < 2048) {
-					mask = 0x1FF;  // 1/512 probability for small chunks
-				} else if (chunk.size() < 4096) {
-					mask = 0x7FF;  // 1/2048 probability for medium chunks
-				} else {
-					mask = 0x1FFF; // 1/8192 probability for large chunks
+
+			std::span<const uint8_t> window(buffer.data() + begin, std::min(end - begin, MAX_CHUNK_SIZE));
+			auto chunk = window.first(find_chunk_end(window, fingerprint, current_fingerprint));
+			found[found_count] = Found{ current_fingerprint, buffer_offset + begin };
+			inputs[found_count] = chunk;
+			if (++found_count == HASH_BATCH)
+				flush();
+
+			begin += chunk.size();
+		}
+		flush();
+	}
+
+	/**
+	* Chunk the whole file overlapping boundary detection with strong hashing.
+	* The calling thread scans for boundaries and pushes descriptors of found chunks
+	* into a bounded lock-free queue; threads_ - 1 workers hash them in place. Two read
+	* buffers are used alternately: chunks in one buffer are hashed while the other is
+	* scanned. Before a buffer is refilled, all its chunks must be hashed, then they are
+	* passed to the visitor - so chunk order is preserved. Workers take up to HASH_BATCH
+	* jobs at once and hash them by hash_many(). If the queue is full, the scanner hashes
+	* the chunk itself.
+	* @param[in] file open file
+	* @param[in] visitor callable invoked as visitor(chunk, data)
+	*/
+	template <class F>
+	void scan_pipelined(FileIO& file, F& visitor) {
+		struct HashJob {
+			uint8_t* hash;
+			const uint8_t* data;
+			size_t size;
+			std::atomic<size_t>* pending;
+		};
+
+		// Chunk tables are reserved for the maximum amount of chunks in a buffer so that
+		// hash pointers held by queued jobs stay valid.
+		const size_t max_chunks = (READ_BLOCK_SIZE + MAX_CHUNK_SIZE) / MIN_CHUNK_SIZE + 1;
+		std::vector<uint8_t> buffers[2];
+		Table buffer_chunks[2];
+		std::atomic<size_t> pending[2]{ 0, 0 };
+		for (int i = 0; i < 2; i++) {
+			buffers[i].resize(READ_BLOCK_SIZE + MAX_CHUNK_SIZE);
+			buffer_chunks[i].reserve(max_chunks);
+		}
+
+		BoundedQueue<HashJob> queue(HASH_QUEUE_SIZE);
+		std::atomic<bool> done{ false };
+		auto run_jobs = [](U& hash_func, std::span<const HashJob> jobs) {
+			std::array<std::span<const uint8_t>, HASH_BATCH> inputs;
+			std::array<std::span<uint8_t>, HASH_BATCH> outputs;
+			for (size_t i = 0; i < jobs.size(); i++) {
+				inputs[i] = std::span<const uint8_t>(jobs[i].data, jobs[i].size);
+				outputs[i] = std::span<uint8_t>(jobs[i].hash, U::HASH_SIZE);
+			}
+			hash_func.hash_many(std::span(inputs).first(jobs.size()), outputs);
+			for (const auto& job : jobs)
+				job.pending->fetch_sub(1, std::memory_order_release);
+		};
+		auto pop_jobs = [&queue](std::array<HashJob, HASH_BATCH>& jobs) {
+			size_t count = 0;
+			while (count < jobs.size() && queue.try_pop(jobs[count]))
+				count++;
+			return std::span<const HashJob>(jobs.data(), count);
+		};
+
+		std::vector<std::thread> workers;
+		for (unsigned int i = 1; i < threads_; i++) {
+			workers.emplace_back([&] {
+				U hash_func;
+				std::array<HashJob, HASH_BATCH> jobs;
+				while (true) {
+					if (auto batch = pop_jobs(jobs); !batch.empty())
+						run_jobs(hash_func, batch);
+					else if (done.load(std::memory_order_acquire))
+						break;
+					else
+						std::this_thread::yield();
 				}
-				boundary_found = (((last << 8 | byte) & mask) == 0);
+			});
+		}
+
+		U hash_func;
+		size_t buffer_offsets[2]{ 0, 0 };								// file offsets of buffers[i][0]
+		auto drain = [&](int index) {								// wait for buffer's chunks and pass them to visitor
+			std::array<HashJob, HASH_BATCH> jobs;
+			while (pending[index].load(std::memory_order_acquire) > 0) {
+				if (auto batch = pop_jobs(jobs); !batch.empty())
+					run_jobs(hash_func, batch);
+				else
+					std::this_thread::yield();
 			}
+			for (size_t i = 0; i < buffer_chunks[index].size(); i++) {
+				const auto schunk = buffer_chunks[index][i];
+				visitor(schunk, std::span<const uint8_t>(buffers[index]).subspan(schunk.start_offset - buffer_offsets[index], schunk.chunk_size));
+			}
+			buffer_chunks[index].clear();
+		};
+
+		T fingerprint;
+		typename T::RollingHashType current_fingerprint{};
 
-			if (boundary_found)					// chunk boundary found
+		int cur = 0;
+		size_t begin = 0;												// start of current chunk in buffer
+		size_t end = file.read_block(std::span<uint8_t>(buffers[cur]).first(READ_BLOCK_SIZE), 0);
+		bool eof = end < READ_BLOCK_SIZE;
+
+		while (true)
+		{
+			if (!eof && end - begin < MAX_CHUNK_SIZE)					// switch buffers - move the tail and refill
 			{
-				SignedChunk<typename T::RollingHashType> schunk;
-				schunk.signature = current_fingerprint;
-				schunk.hash.resize(hash_func.get_hash_size());
-				hash_func.hash(schunk.hash, chunk);
-				schunk.start_offset = bytes_read - chunk.size();
-				schunk.chunk_size = chunk.size();
-				chunks.push_back(std::move(schunk));
-				chunk.clear();
-				init = true;
+				const int next = cur ^ 1;
+				drain(next);
+
+				std::copy(buffers[cur].begin() + begin, buffers[cur].begin() + end, buffers[next].begin());
+				buffer_offsets[next] = buffer_offsets[cur] + begin;
+				end -= begin;
+				begin = 0;
+				cur = next;
+
+				size_t bytes_read = file.read_block(std::span<uint8_t>(buffers[cur]).subspan(end, READ_BLOCK_SIZE));
+				eof = bytes_read < READ_BLOCK_SIZE;
+				end += bytes_read;
 			}
+
+			if (begin == end)
+				break;
+
+			std::span<const uint8_t> window(buffers[cur].data() + begin, std::min(end - begin, MAX_CHUNK_SIZE));
+			const size_t size = find_chunk_end(window, fingerprint, current_fingerprint);
+
+			auto& table = buffer_chunks[cur];
+			table.push_back(current_fingerprint, typename Table::Hash{}, buffer_offsets[cur] + begin, size);
+
+			HashJob job{ table.hash_at(table.size() - 1).data(), window.data(), size, &pending[cur] };
+			pending[cur].fetch_add(1, std::memory_order_relaxed);
+			if (!queue.try_push(job))
+				run_jobs(hash_func, std::span<const HashJob>(&job, 1));
+
+			begin += size;
 		}
 
-		if (chunk.size() > 0)									// emit residual chunk at EOF
-		{
-			SignedChunk<typename T::RollingHashType> schunk;
-			schunk.signature = current_fingerprint;
-			schunk.hash.resize(hash_func.get_hash_size());
-			hash_func.hash(schunk.hash, chunk);
-			schunk.start_offset = bytes_read - chunk.size();
-			schunk.chunk_size = chunk.size();
-			chunks.push_back(std::move(schunk));
+		drain(cur ^ 1);
+		drain(cur);
+
+		done.store(true, std::memory_order_release);
+		for (auto& worker : workers)
+			worker.join();
+	}
+
+	/**
+	* Chunk the file in segments, one per thread, then stitch segment results.
+	* Segment k starts its first chunk at its own start offset, which in general is not
+	* a boundary of the sequential chunking. Content-defined boundaries resynchronize
+	* quickly, so while stitching, chunks are rescanned sequentially (in bulk, by
+	* scan_range()) from the end of the already stitched list until it ends exactly where
+	* a chunk of one of the following segments starts. From that point segment's chunks
+	* are the same as the sequential ones. On zero-filled or periodic data the grids may
+	* never line up; then the rescan simply continues to the end of the file, so it never
+	* costs more than a sequential scan of the rest.
+	* @param[in] datafile file with data
+	* @param[in] file_size size of the file
+	*/
+	void generate_parallel(const std::filesystem::path& datafile, size_t file_size) {
+		const size_t segment_count = std::min<size_t>(threads_, file_size / MIN_SEGMENT_SIZE);
+		std::vector<Table> segments(segment_count);
+		std::vector<std::thread> workers;
+
+		for (size_t k = 0; k < segment_count; k++) {
+			workers.emplace_back([&, k] {
+				FileIO file;
+				auto collect = collect_into(segments[k]);
+				if (file.open(datafile, FileMode::IN))
+					scan_range(file, file_size * k / segment_count, file_size * (k + 1) / segment_count, collect);
+			});
+		}
+		for (auto& worker : workers)
+			worker.join();
+
+		FileIO file;
+		if (!file.open(datafile, FileMode::IN))
+			return;
+
+		chunks = std::move(segments[0]);
+
+		size_t k = 1;													// first segment not stitched yet
+		size_t index = 0;												// its chunk starting at the stitched end
+		auto resynchronized = [&] {
+			const size_t end = chunks.end_offset();
+			for (; k < segment_count; k++) {
+				const auto& next = segments[k];
+				if (next.empty() || end > next.back().start_offset)		// whole segment was overrun - try the next one
+					continue;
+				index = next.lower_bound(end);
+				return next[index].start_offset == end;
+			}
+			return false;
+		};
+		auto rescan = [&](const Chunk& chunk, std::span<const uint8_t>) {
+			chunks.push_back(chunk);
+			return !resynchronized();
+		};
+
+		while (chunks.end_offset() < file_size) {
+			if (resynchronized()) {
+				chunks.append(segments[k], index);
+				k++;
+				continue;
+			}
+
+			const size_t count = chunks.size();
+			scan_range(file, chunks.end_offset(), SIZE_MAX, rescan);
+			if (chunks.size() == count)									// file shrank meanwhile
+				break;
 		}
+
+		fix_residual_signature();
 	}
 
 	/**
-	* Get chunk list.
-	* @return Vector of signed chunks.
+	* Chunk single chunk starting at given offset and append it to out.
+	* @param[in] file open file
+	* @param[in] from offset of the chunk
+	* @param[out] out chunk table to append to
+	* @return True if a chunk was appended, false if nothing could be read at from
+	*         (end of file or read error).
 	*/
-	const std::vector<SignedChunk<typename T::RollingHashType>>& get_chunks() const noexcept {
-		return chunks;
+	bool scan_one(FileIO& file, size_t from, Table& out) {
+		std::vector<uint8_t> buffer(MAX_CHUNK_SIZE);
+		buffer.resize(file.read_block(buffer, from));
+		if (buffer.empty())
+			return false;
+
+		T fingerprint;
+		U hash_func;
+		typename T::RollingHashType current_fingerprint = out.empty() ? typename T::RollingHashType{} : out.back().signature;
+		auto chunk = std::span<const uint8_t>(buffer).first(find_chunk_end(buffer, fingerprint, current_fingerprint));
+		typename Table::Hash hash;
+		hash_func.hash(hash, chunk);
+		out.push_back(current_fingerprint, hash, from, chunk.size());
+		return true;
 	}
 
-private:
-	std::vector<SignedChunk<typename T::RollingHashType>> chunks;
+	/**
+	* Find the end of the chunk starting at the beginning of the given window.
+	* The window holds either at least MAX_CHUNK_SIZE bytes or all remaining bytes
+	* of the file, so the boundary is always found inside it.
+	*
+	* The boundary is searched first, then the rolling hash is initialized with the
+	* first window_size bytes of the chunk and rolled over the following bytes with
+	* the hash's own roll() loop (no virtual call per byte). If the chunk is too short for that
+	* (residual chunk at EOF), current_fingerprint keeps its previous value.
+	* Rolling hashes satisfying CutPointRollingHash decide the boundary themselves, windowed
+	* ones place fingerprint boundaries with their own value (find_windowed_boundary()).
+	* @param[in] window data starting at chunk start
+	* @param[in,out] fingerprint rolling hash used for the chunk
+	* @param[in,out] current_fingerprint last computed rolling hash value
+	* @return Length of the chunk in bytes.
+	*/
+	size_t find_chunk_end(std::span<const uint8_t> window, T& fingerprint,
+	                      typename T::RollingHashType& current_fingerprint) {
+		if constexpr (CutPointRollingHash<T>) {
+			const size_t size = fingerprint.find_cut_point(window, MIN_CHUNK_SIZE, TARGET_CHUNK_SIZE, MAX_CHUNK_SIZE);
+			current_fingerprint = fingerprint.get_current_fingerprint();
+			return size;
+		}
+		if constexpr (WindowedRollingHash<T> && P::BOUNDARY == BoundaryMode::FINGERPRINT)
+			return find_windowed_boundary(window, fingerprint, current_fingerprint);
+
+		const size_t window_size = fingerprint.get_window_size();
+		if (window.size() < window_size)
+			return window.size();
+
+		const size_t size = P::BOUNDARY == BoundaryMode::FINGERPRINT ? find_fingerprint_boundary(window)
+		                                                             : find_two_byte_boundary(window);
+
+		fingerprint.initialize(window.first(window_size));
+		if (size > window_size)
+			current_fingerprint = fingerprint.roll(window.subspan(window_size, size - window_size));
+
+		return size;
+	}
+
+	/**
+	* Find chunk boundary using the test (fingerprint & mask) == 0 with mask depending on
+	* the current chunk size, where fingerprint is the value of the windowed rolling hash T.
+	* The value depends only on the window, so the hash is initialized with the window
+	* ending at MIN_CHUNK_SIZE and rolled by T::roll() BOUNDARY_ROLL_STEP bytes at a time
+	* until a boundary is found. current_fingerprint is set to the value at the chunk end,
+	* as if the hash was rolled over the whole chunk.
+	* @param[in] window data starting at chunk start
+	* @param[in,out] fingerprint rolling hash used for the chunk
+	* @param[in,out] current_fingerprint last computed rolling hash value
+	* @return Length of the chunk in bytes.
+	*/
+	static size_t find_windowed_boundary(std::span<const uint8_t> window, T& fingerprint,
+	                                     typename T::RollingHashType& current_fingerprint) {
+		const size_t window_size = fingerprint.get_window_size();
+		const size_t first = std::max<size_t>(MIN_CHUNK_SIZE, window_size);	// shortest chunk with a whole window
+		size_t end = window.size();						// no content-defined boundary - forced at MAX_CHUNK_SIZE or residual chunk at EOF
+
+		if (window.size() >= first) {
+			fingerprint.initialize(window.subspan(first - window_size, window_size));
+			if ((fingerprint.get_current_fingerprint() & P::mask_for(first)) == 0) {
+				end = first;
+			} else {
+				size_t size = first;
+				auto boundary = [&size](typename T::RollingHashType value) { return (value & P::mask_for(++size)) == 0; };
+				std::vector<size_t> positions;
+				for (size_t from = first; from < window.size() && positions.empty(); from += BOUNDARY_ROLL_STEP) {
+					fingerprint.roll(window.subspan(from, std::min(BOUNDARY_ROLL_STEP, window.size() - from)), boundary, positions);
+					if (!positions.empty())
+						end = from + positions.front();
+				}
+			}
+		}
+
+		if (end >= window_size) {
+			fingerprint.initialize(window.subspan(end - window_size, window_size));
+			current_fingerprint = fingerprint.get_current_fingerprint();
+		}
+		return end;
+	}
+
+	/**
+	* Find chunk boundary using the test (fingerprint & mask) == 0 with mask depending on
+	* the current chunk size, where fingerprint is the Rabin-Karp hash of the last
+	* BOUNDARY_WINDOW bytes (base 256, modulus 2^31-1). This is the fallback for rolling
+	* hashes which are not windowed (RKFinger, StaticRKFinger): their compute_next() removes
+	* the previously added byte instead of the byte leaving the window, so the value depends
+	* on everything since the chunk start and boundaries placed by it would never
+	* resynchronize after an insertion - hence the separate windowed hash. Only windows
+	* ending at or after MIN_CHUNK_SIZE are hashed.
+	* @param[in] window data starting at chunk start
+	* @return Length of the chunk in bytes.
+	*/
+	static size_t find_fingerprint_boundary(std::span<const uint8_t> window) noexcept {
+		constexpr uint64_t MODULUS = 0x7FFFFFFF;
+		static constexpr auto OUTGOING = [] {				// byte * 256^(BOUNDARY_WINDOW-1) mod MODULUS
+			uint64_t factor = 1;
+			for (size_t i = 1; i < BOUNDARY_WINDOW; i++)
+				factor = (factor << 8) % MODULUS;
+			std::array<uint64_t, 256> table{};
+			for (uint64_t b = 0; b < table.size(); b++)
+				table[b] = b * factor % MODULUS;
+			return table;
+		}();
+
+		if (window.size() < MIN_CHUNK_SIZE)
+			return window.size();
+
+		uint64_t fingerprint = 0;
+		for (size_t i = MIN_CHUNK_SIZE - BOUNDARY_WINDOW; i < MIN_CHUNK_SIZE; i++)
+			fingerprint = ((fingerprint << 8) + window[i]) % MODULUS;
+		if ((fingerprint & P::mask_for(MIN_CHUNK_SIZE)) == 0)
+			return MIN_CHUNK_SIZE;
+
+		for (size_t i = MIN_CHUNK_SIZE; i < window.size(); i++) {
+			fingerprint = (((fingerprint + MODULUS - OUTGOING[window[i - BOUNDARY_WINDOW]]) << 8) + window[i]) % MODULUS;
+			if ((fingerprint & P::mask_for(i + 1)) == 0)
+				return i + 1;
+		}
+
+		// No content-defined boundary - either forced at MAX_CHUNK_SIZE or residual chunk at EOF
+		return window.size();
+	}
+
+	/**
+	* Find chunk boundary using the two-byte test ((last << 8 | byte) & mask) == 0 with
+	* mask depending on the current chunk size (policy's mask schedule). Masks are nested,
+	* so the candidates for the loosest mask are found with a vectorized scan and only
+	* those are checked against the mask for their size.
+	* @param[in] window data starting at chunk start
+	* @return Length of the chunk in bytes.
+	*/
+	static size_t find_two_byte_boundary(std::span<const uint8_t> window) noexcept {
+		std::array<uint32_t, 64> candidates;
+		size_t from = MIN_CHUNK_SIZE - 1;								// position of the last byte of a minimal chunk
+
+		while (from < window.size()) {
+			const size_t found = find_boundary_candidates(window, from, P::SMALL_MASK, candidates);
+
+			for (size_t i = 0; i < found; i++) {
+				const size_t size = candidates[i] + 1;
+				if (((window[size - 2] << 8 | window[size - 1]) & P::mask_for(size)) == 0)
+					return size;
+			}
+
+			if (found < candidates.size())
+				break;
+			from = candidates[found - 1] + 1;
+		}
+
+		// No content-defined boundary - either forced at MAX_CHUNK_SIZE or residual chunk at EOF
+		return window.size();
+	}
+
+	Table chunks;
+	ChunkStats stats_;
+	unsigned int threads_{ 1 };
+	bool file_digest_enabled_{ false };
+	std::optional<typename Table::Hash> file_digest_;
 };
 
 
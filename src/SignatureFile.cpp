@@ -0,0 +1,66 @@
+#include "SignatureFile.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <system_error>
+
+namespace {
+
+constexpr std::array<uint8_t, 4> SIGNATURE_MAGIC = { 'R', 'H', 'S', 'G' };
+
+} // namespace
+
+std::array<uint8_t, SIGNATURE_FILE_HEADER_SIZE> encode_signature_file_header(const SignatureFileHeader& header) noexcept
+{
+	std::array<uint8_t, SIGNATURE_FILE_HEADER_SIZE> out{};
+	std::copy(SIGNATURE_MAGIC.begin(), SIGNATURE_MAGIC.end(), out.begin());
+	out[4] = header.version;
+	out[5] = header.chunking_policy;
+	out[6] = header.signature_size;
+	out[7] = header.hash_size;
+	store_le(out.data() + 8, header.chunk_count);
+	store_le(out.data() + 16, header.file_size);
+	store_le(out.data() + 24, static_cast<uint64_t>(header.file_mtime));
+	return out;
+}
+
+bool decode_signature_file_header(std::span<const uint8_t> data, SignatureFileHeader& header) noexcept
+{
+	if (data.size() < SIGNATURE_FILE_HEADER_SIZE || !std::equal(SIGNATURE_MAGIC.begin(), SIGNATURE_MAGIC.end(), data.begin()))
+		return false;
+
+	header.version = data[4];
+	header.chunking_policy = data[5];
+	header.signature_size = data[6];
+	header.hash_size = data[7];
+	header.chunk_count = load_le<uint64_t>(data.data() + 8);
+	header.file_size = load_le<uint64_t>(data.data() + 16);
+	header.file_mtime = static_cast<int64_t>(load_le<uint64_t>(data.data() + 24));
+	return true;
+}
+
+bool read_signature_file_header(const std::filesystem::path& signature_file, SignatureFileHeader& header)
+{
+	std::ifstream file(signature_file, std::ios::binary);
+	if (!file)
+		return false;
+
+	std::array<uint8_t, SIGNATURE_FILE_HEADER_SIZE> data{};
+	file.read(reinterpret_cast<char*>(data.data()), data.size());
+	return decode_signature_file_header(std::span<const uint8_t>(data.data(), static_cast<size_t>(file.gcount())), header);
+}
+
+bool stamp_signature_file_header(const std::filesystem::path& data_file, SignatureFileHeader& header)
+{
+	std::error_code ec;
+	const auto size = std::filesystem::file_size(data_file, ec);
+	if (ec)
+		return false;
+	const auto mtime = std::filesystem::last_write_time(data_file, ec);
+	if (ec)
+		return false;
+
+	header.file_size = size;
+	header.file_mtime = static_cast<int64_t>(mtime.time_since_epoch().count());
+	return true;
+}
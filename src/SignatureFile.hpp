@@ -0,0 +1,101 @@
+#ifndef SIGNATUREFILE_HPP
+#define SIGNATUREFILE_HPP
+
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+
+constexpr size_t SIGNATURE_FILE_HEADER_SIZE = 40;
+constexpr uint8_t SIGNATURE_FILE_VERSION = 1;
+
+/**
+* Header of the signature (.sig) file holding the chunk list of a data file, so that
+* the signature of a base file can be computed once and reused by create and apply.
+*
+* Layout (all integers little-endian):
+*   'R' 'H' 'S' 'G' | version:u8 | chunking_policy:u8 | signature_size:u8 | hash_size:u8
+*   chunk_count:u64 | file_size:u64 | file_mtime:i64 | reserved:u64 (zero)
+* followed by chunk_count fixed-size records:
+*   signature:signature_size | start_offset:u64 | chunk_size:u64 | hash:hash_size
+*
+* Header and records are multiples of 8 bytes for usual sizes, so the file can be
+* mapped into memory and records accessed in place. File size and modification time
+* of the data file are recorded to detect stale signature files.
+*/
+struct SignatureFileHeader {
+	uint8_t version{ SIGNATURE_FILE_VERSION };		/*!< Signature file format version */
+	uint8_t chunking_policy{ 0 };					/*!< Chunking policy ID (see ChunkingPolicy) */
+	uint8_t signature_size{ 0 };					/*!< Size of the rolling hash signature in bytes */
+	uint8_t hash_size{ 0 };							/*!< Size of the strong hash in bytes */
+	uint64_t chunk_count{ 0 };						/*!< Amount of chunk records */
+	uint64_t file_size{ 0 };						/*!< Size of the signed data file */
+	int64_t file_mtime{ 0 };						/*!< Modification time of the signed data file */
+
+	/**
+	* Get size of a single chunk record.
+	* @return Record size in bytes.
+	*/
+	size_t record_size() const noexcept {
+		return signature_size + 2 * sizeof(uint64_t) + hash_size;
+	}
+};
+
+/**
+* Encode signature file header.
+* @param[in] header header to encode
+* @return Encoded header bytes.
+*/
+std::array<uint8_t, SIGNATURE_FILE_HEADER_SIZE> encode_signature_file_header(const SignatureFileHeader& header) noexcept;
+
+/**
+* Decode signature file header.
+* @param[in] data first bytes of the signature file
+* @param[out] header decoded header
+* @return True if data starts with a signature file header.
+*/
+bool decode_signature_file_header(std::span<const uint8_t> data, SignatureFileHeader& header) noexcept;
+
+/**
+* Read header of the given signature file.
+* @param[in] signature_file path to the signature file
+* @param[out] header read header
+* @return True if the file could be opened and starts with a signature file header.
+*/
+bool read_signature_file_header(const std::filesystem::path& signature_file, SignatureFileHeader& header);
+
+/**
+* Fill file size and modification time of the data file into the header.
+* @param[in] data_file path to the signed data file
+* @param[out] header header to be filled
+* @return True if file attributes could be read.
+*/
+bool stamp_signature_file_header(const std::filesystem::path& data_file, SignatureFileHeader& header);
+
+/**
+* Store unsigned value as little-endian bytes.
+* @param[out] out destination (sizeof(V) bytes)
+* @param[in] value value to store
+*/
+template <std::unsigned_integral V>
+constexpr void store_le(uint8_t* out, V value) noexcept {
+	for (size_t i = 0; i < sizeof(V); i++)
+		out[i] = static_cast<uint8_t>(value >> (8 * i));
+}
+
+/**
+* Load unsigned value from little-endian bytes.
+* @param[in] in source (sizeof(V) bytes)
+* @return Loaded value.
+*/
+template <std::unsigned_integral V>
+constexpr V load_le(const uint8_t* in) noexcept {
+	V value = 0;
+	for (size_t i = 0; i < sizeof(V); i++)
+		value |= static_cast<V>(in[i]) << (8 * i);
+	return value;
+}
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef STRONGHASH_HPP
+#define STRONGHASH_HPP
+
+#include "blake.h"
+#include "blake3.h"
+#include "xxh3.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/**
+* Strong hashes identifying chunks. The hash ID is stored in the delta header so that
+* Apply hashes the old file chunks the same way Delta did:
+*  - blake512 - BLAKE-512, 64-byte hashes (default, used by deltas without hash ID),
+*  - blake3 - BLAKE3, 32-byte hashes,
+*  - xxh3 - XXH3-128, 16-byte hashes, fastest but not cryptographic: use it only for
+*    inputs nobody crafts to collide.
+*/
+using DefaultStrongHash = BLAKE512;
+
+/**
+* Get strong hash ID by its command line name.
+* @param[in] name hash name (blake512, blake3, xxh3 or xxh3-128)
+* @param[out] id hash ID
+* @return True if the name is known.
+*/
+constexpr bool strong_hash_from_name(std::string_view name, uint8_t& id) noexcept {
+	if (name == "blake512")
+		id = BLAKE512::ID;
+	else if (name == "blake3")
+		id = BLAKE3::ID;
+	else if (name == "xxh3" || name == XXH3_128::NAME)
+		id = XXH3_128::ID;
+	else
+		return false;
+	return true;
+}
+
+/**
+* Get strong hash name by its ID.
+* @param[in] id hash ID
+* @return Hash name or "unknown".
+*/
+constexpr const char* strong_hash_name(uint8_t id) noexcept {
+	switch (id) {
+		case BLAKE512::ID: return BLAKE512::NAME;
+		case BLAKE3::ID:   return BLAKE3::NAME;
+		case XXH3_128::ID: return XXH3_128::NAME;
+		default:           return "unknown";
+	}
+}
+
+/**
+* Get strong hash ID by its hash size. Signature files record only the hash size,
+* which is unique for every strong hash.
+* @param[in] size hash size in bytes
+* @param[out] id hash ID
+* @return True if a strong hash of the given size is known.
+*/
+constexpr bool strong_hash_from_size(size_t size, uint8_t& id) noexcept {
+	if (size == BLAKE512::HASH_SIZE)
+		id = BLAKE512::ID;
+	else if (size == BLAKE3::HASH_SIZE)
+		id = BLAKE3::ID;
+	else if (size == XXH3_128::HASH_SIZE)
+		id = XXH3_128::ID;
+	else
+		return false;
+	return true;
+}
+
+#endif
@@ -1,25 +1,89 @@
 #ifndef BLAKE_H
 #define BLAKE_H
 
+#include "CpuDispatch.hpp"
 #include "IHash.hpp"
 
+#include <algorithm>
 #include <cstdint>
 #include <cstddef>
 #include <span>
 
+/**
+* Implementation of the BLAKE-512 compression function (scalar and AVX2 kernels
+* exist).
+*/
+using BlakeIsa = CpuIsa;
+
+/**
+* Get the BLAKE-512 compression implementation used at the given ISA level - the
+* best kernel not requiring a better ISA.
+* @param[in] isa ISA level
+* @return ISA of the kernel.
+*/
+BlakeIsa blake512_kernel_isa(CpuIsa isa) noexcept;
+
+/**
+* Get the best BLAKE-512 compression implementation allowed by cpu_best_isa().
+* @return Best usable ISA.
+*/
+BlakeIsa blake512_best_isa() noexcept;
+
+/**
+* Get the name of the ISA (for diagnostics).
+* @param[in] isa compression implementation
+* @return Name of the implementation.
+*/
+const char* blake512_isa_name(BlakeIsa isa) noexcept;
+
 /**
 * BLAKE-512 wrapper class. Simply wraps the underlying C implementation.
-* Implements IHash interface.
+* Implements IHash interface. One-shot hash() uses its own state, so it can be
+* called while incremental hashing (init/update/final) is in progress.
 */
 class BLAKE512 : public IHash
 {
 public:
+	static constexpr size_t HASH_SIZE = 64;		// Hash size in bytes
+	static constexpr uint8_t ID = 1;			// Strong hash ID recorded in delta header
+	static constexpr const char* NAME = "blake512";
+	static constexpr size_t LANES = 4;			// Inputs hashed at once by hash_many() with AVX2
+
+	/**
+	* Create hasher using the best compression implementation supported by the CPU.
+	*/
+	BLAKE512() noexcept : isa_(blake512_best_isa()) {}
+
+	/**
+	* Create hasher using given compression implementation (e.g. to compare it with
+	* the reference one). ISA not supported by the CPU is replaced by the best one.
+	* @param[in] isa compression implementation
+	*/
+	explicit BLAKE512(BlakeIsa isa) noexcept : isa_(blake512_kernel_isa(std::min(isa, cpu_detected_isa()))) {}
+
+	/**
+	* Get compression implementation used by this hasher.
+	* @return Compression ISA.
+	*/
+	BlakeIsa get_isa() const noexcept {
+		return isa_;
+	}
+
+	/**
+	* State of the underlying C implementation (state512).
+	*/
+	struct State {
+		uint64_t h[8], s[4], t[2];
+		unsigned int buflen, nullt;
+		uint8_t buf[128];
+	};
+
 	/**
 	* Get hash size in bytes.
 	* @return hash size in bytes.
 	*/
 	virtual size_t get_hash_size() const noexcept override {
-		return 64;
+		return HASH_SIZE;
 	}
 	
 	/**
@@ -40,10 +104,40 @@ public:
 
 		hash(std::span<uint8_t>{out, get_hash_size()}, std::span<const uint8_t>{in, inlen});
 	}
-	
-	
+
+	/**
+	* Computes hashes of several independent inputs (see IHash::hash_many()). With AVX2
+	* up to LANES inputs are hashed at once, one per 64-bit vector lane; a lane whose
+	* input is finished continues with the next input, so lengths may differ. Pass at
+	* least LANES inputs to use all lanes. Outputs shorter than HASH_SIZE are skipped.
+	* @param inputs[in] inputs to be hashed
+	* @param outputs[out] buffers to store hashes
+	*/
+	void hash_many(std::span<const std::span<const uint8_t>> inputs,
+	               std::span<const std::span<uint8_t>> outputs) override;
+
+	/**
+	* Start incremental hashing.
+	*/
+	void init() override;
+
+	/**
+	* Pass next part of the input to the incremental hash.
+	* @param in[in] input to be hashed (may be empty)
+	*/
+	void update(std::span<const uint8_t> in) override;
+
+	/**
+	* Finish incremental hashing and store the hash in the given buffer.
+	* @param out[out] buffer to store hash (nothing is done if it is too small).
+	*/
+	void final(std::span<uint8_t> out) override;
+
 private:
 	void blake512_hash(uint8_t* out, const uint8_t* in, uint64_t inlen);
+
+	BlakeIsa isa_;								// Compression implementation
+	State state_{};								// Incremental hashing state
 };
 
 #endif // BLAKE_H
@@ -0,0 +1,221 @@
+#include "blake3.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace {
+
+constexpr uint32_t IV[8] = {
+	0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A, 0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19
+};
+
+// Message word order of each round (the permutation applied round after round).
+constexpr uint8_t SCHEDULE[7][16] = {
+	{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+	{ 2, 6, 3, 10, 7, 0, 4, 13, 1, 11, 12, 5, 9, 14, 15, 8 },
+	{ 3, 4, 10, 12, 13, 2, 7, 14, 6, 5, 9, 0, 11, 15, 8, 1 },
+	{ 10, 7, 12, 9, 14, 3, 13, 15, 4, 0, 11, 2, 5, 8, 1, 6 },
+	{ 12, 13, 9, 11, 15, 10, 14, 8, 7, 2, 5, 3, 0, 1, 6, 4 },
+	{ 9, 14, 11, 5, 8, 12, 15, 1, 13, 3, 0, 10, 2, 6, 4, 7 },
+	{ 11, 15, 5, 0, 1, 9, 8, 6, 14, 10, 2, 12, 3, 4, 7, 13 },
+};
+
+// Domain separation flags
+constexpr uint32_t CHUNK_START = 1 << 0;
+constexpr uint32_t CHUNK_END = 1 << 1;
+constexpr uint32_t PARENT = 1 << 2;
+constexpr uint32_t ROOT = 1 << 3;
+
+inline uint32_t load_le32(const uint8_t* p)
+{
+	return uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24;
+}
+
+inline void store_le32(uint8_t* p, uint32_t value)
+{
+	p[0] = uint8_t(value);
+	p[1] = uint8_t(value >> 8);
+	p[2] = uint8_t(value >> 16);
+	p[3] = uint8_t(value >> 24);
+}
+
+// Quarter-round on v[a], v[b], v[c], v[d] - a macro, so that v stays in registers
+// also when the compiler does not inline (-Os).
+#define G(a, b, c, d, x, y)                  \
+	do {                                     \
+		v[a] += v[b] + (x);                  \
+		v[d] = std::rotr(v[d] ^ v[a], 16);   \
+		v[c] += v[d];                        \
+		v[b] = std::rotr(v[b] ^ v[c], 12);   \
+		v[a] += v[b] + (y);                  \
+		v[d] = std::rotr(v[d] ^ v[a], 8);    \
+		v[c] += v[d];                        \
+		v[b] = std::rotr(v[b] ^ v[c], 7);    \
+	} while (0)
+
+/**
+* Compress a block into the chaining value. Only the first 8 words of the output
+* are computed - all that is needed for 32-byte hashes.
+*/
+void compress(uint32_t cv[8], const uint8_t block[BLAKE3::BLOCK_SIZE], uint64_t counter, uint32_t block_len, uint32_t flags)
+{
+	uint32_t m[16];
+	for (int i = 0; i < 16; i++)
+		m[i] = load_le32(block + 4 * i);
+
+	uint32_t v[16] = {
+		cv[0], cv[1], cv[2], cv[3], cv[4], cv[5], cv[6], cv[7],
+		IV[0], IV[1], IV[2], IV[3], uint32_t(counter), uint32_t(counter >> 32), block_len, flags
+	};
+
+	// Unrolled rounds keep the message word indices constant.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC unroll 7
+#endif
+	for (const auto& s : SCHEDULE) {
+		G(0, 4, 8, 12, m[s[0]], m[s[1]]);
+		G(1, 5, 9, 13, m[s[2]], m[s[3]]);
+		G(2, 6, 10, 14, m[s[4]], m[s[5]]);
+		G(3, 7, 11, 15, m[s[6]], m[s[7]]);
+		G(0, 5, 10, 15, m[s[8]], m[s[9]]);
+		G(1, 6, 11, 12, m[s[10]], m[s[11]]);
+		G(2, 7, 8, 13, m[s[12]], m[s[13]]);
+		G(3, 4, 9, 14, m[s[14]], m[s[15]]);
+	}
+
+	for (int i = 0; i < 8; i++)
+		cv[i] = v[i] ^ v[i + 8];
+}
+
+#undef G
+
+void parent_cv(uint32_t out[8], const uint32_t left[8], const uint32_t right[8], uint32_t flags)
+{
+	uint8_t block[BLAKE3::BLOCK_SIZE];
+	for (int i = 0; i < 8; i++) {
+		store_le32(block + 4 * i, left[i]);
+		store_le32(block + 32 + 4 * i, right[i]);
+	}
+	std::copy(IV, IV + 8, out);
+	compress(out, block, 0, BLAKE3::BLOCK_SIZE, PARENT | flags);
+}
+
+uint32_t start_flag(const BLAKE3::State& S)
+{
+	return S.blocks_compressed == 0 ? CHUNK_START : 0;
+}
+
+void start_chunk(BLAKE3::State& S, uint64_t counter)
+{
+	std::copy(IV, IV + 8, S.cv);
+	S.chunk_counter = counter;
+	S.block_len = 0;
+	S.blocks_compressed = 0;
+}
+
+/**
+* Push chaining value of a complete chunk. Number of complete subtrees equals the
+* number of set bits of the chunk count, so a subtree is merged for every trailing
+* zero bit of it.
+*/
+void push_chunk_cv(BLAKE3::State& S, uint32_t cv[8], uint64_t total_chunks)
+{
+	while ((total_chunks & 1) == 0) {
+		parent_cv(cv, S.stack[--S.stack_len], cv, 0);
+		total_chunks >>= 1;
+	}
+	std::copy(cv, cv + 8, S.stack[S.stack_len++]);
+}
+
+void blake3_init(BLAKE3::State& S)
+{
+	start_chunk(S, 0);
+	S.stack_len = 0;
+}
+
+void blake3_update(BLAKE3::State& S, const uint8_t* in, size_t inlen)
+{
+	while (inlen > 0) {
+		// Chunk is finished only when more input follows - the last one is the root
+		// or the rightmost leaf, which are compressed with different flags.
+		if (S.blocks_compressed * BLAKE3::BLOCK_SIZE + S.block_len == BLAKE3::CHUNK_SIZE) {
+			uint32_t cv[8];
+			std::copy(S.cv, S.cv + 8, cv);
+			compress(cv, S.block, S.chunk_counter, BLAKE3::BLOCK_SIZE, CHUNK_END);
+			push_chunk_cv(S, cv, S.chunk_counter + 1);
+			start_chunk(S, S.chunk_counter + 1);
+		}
+
+		// Full blocks of the chunk are compressed straight from the input, except
+		// the chunk's last one.
+		while (S.block_len == 0 && inlen > BLAKE3::BLOCK_SIZE && S.blocks_compressed + 1 < BLAKE3::CHUNK_SIZE / BLAKE3::BLOCK_SIZE) {
+			compress(S.cv, in, S.chunk_counter, BLAKE3::BLOCK_SIZE, start_flag(S));
+			S.blocks_compressed++;
+			in += BLAKE3::BLOCK_SIZE;
+			inlen -= BLAKE3::BLOCK_SIZE;
+		}
+
+		if (S.block_len == BLAKE3::BLOCK_SIZE) {
+			compress(S.cv, S.block, S.chunk_counter, BLAKE3::BLOCK_SIZE, start_flag(S));
+			S.blocks_compressed++;
+			S.block_len = 0;
+		}
+
+		const size_t take = std::min(inlen, BLAKE3::BLOCK_SIZE - S.block_len);
+		std::memcpy(S.block + S.block_len, in, take);
+		S.block_len += static_cast<unsigned int>(take);
+		in += take;
+		inlen -= take;
+	}
+}
+
+void blake3_final(BLAKE3::State& S, uint8_t* out)
+{
+	std::memset(S.block + S.block_len, 0, BLAKE3::BLOCK_SIZE - S.block_len);
+
+	uint32_t cv[8];
+	std::copy(S.cv, S.cv + 8, cv);
+	if (S.stack_len == 0) {
+		compress(cv, S.block, S.chunk_counter, S.block_len, start_flag(S) | CHUNK_END | ROOT);
+	} else {
+		compress(cv, S.block, S.chunk_counter, S.block_len, start_flag(S) | CHUNK_END);
+		while (S.stack_len > 1)
+			parent_cv(cv, S.stack[--S.stack_len], cv, 0);
+		parent_cv(cv, S.stack[--S.stack_len], cv, ROOT);
+	}
+
+	for (int i = 0; i < 8; i++)
+		store_le32(out + 4 * i, cv[i]);
+}
+
+} // namespace
+
+void BLAKE3::hash(std::span<uint8_t> out, std::span<const uint8_t> in)
+{
+	if (out.size() < HASH_SIZE)
+		return;
+
+	State S;
+	blake3_init(S);
+	blake3_update(S, in.data(), in.size());
+	blake3_final(S, out.data());
+}
+
+void BLAKE3::init()
+{
+	blake3_init(state_);
+}
+
+void BLAKE3::update(std::span<const uint8_t> in)
+{
+	blake3_update(state_, in.data(), in.size());
+}
+
+void BLAKE3::final(std::span<uint8_t> out)
+{
+	if (out.size() < HASH_SIZE)
+		return;
+
+	blake3_final(state_, out.data());
+}
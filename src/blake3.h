@@ -0,0 +1,79 @@
+#ifndef BLAKE3_H
+#define BLAKE3_H
+
+#include "IHash.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+/**
+* BLAKE3 hash with 32-byte output (unkeyed hash mode). Input is split into 1 KiB
+* chunks whose chaining values are merged in a binary tree; a chunk takes 16
+* compressions of 7 rounds on 32-bit words. Portable scalar implementation - as fast
+* as the AVX2 BLAKE-512 compression, faster than the scalar one. Implements IHash interface; one-shot hash() uses
+* its own state, so it can be called while incremental hashing is in progress.
+*/
+class BLAKE3 : public IHash
+{
+public:
+	static constexpr size_t HASH_SIZE = 32;		// Hash size in bytes
+	static constexpr uint8_t ID = 2;			// Strong hash ID recorded in delta header
+	static constexpr const char* NAME = "blake3";
+
+	static constexpr size_t BLOCK_SIZE = 64;	// Compression function input
+	static constexpr size_t CHUNK_SIZE = 1024;	// Leaf of the hash tree
+	static constexpr size_t MAX_DEPTH = 54;		// Tree depth for 2^64 bytes of input
+
+	/**
+	* Incremental hashing state: the chunk being hashed and the stack of chaining
+	* values of complete subtrees.
+	*/
+	struct State {
+		uint32_t cv[8];							// Chaining value of the current chunk
+		uint64_t chunk_counter;					// Index of the current chunk
+		uint8_t block[BLOCK_SIZE];				// Buffered input of the current chunk
+		unsigned int block_len;					// Bytes in block
+		unsigned int blocks_compressed;			// Blocks of the current chunk already compressed
+		unsigned int stack_len;					// Chaining values on the stack
+		uint32_t stack[MAX_DEPTH][8];			// Chaining values of complete subtrees
+	};
+
+	/**
+	* Get hash size in bytes.
+	* @return hash size in bytes.
+	*/
+	size_t get_hash_size() const noexcept override {
+		return HASH_SIZE;
+	}
+
+	/**
+	* Computes hash and stores it in the given buffer.
+	* @param out[out] buffer to store hash (nothing is done if it is too small).
+	* @param in[in] input to be hashed
+	*/
+	void hash(std::span<uint8_t> out, std::span<const uint8_t> in) override;
+
+	/**
+	* Start incremental hashing.
+	*/
+	void init() override;
+
+	/**
+	* Pass next part of the input to the incremental hash.
+	* @param in[in] input to be hashed (may be empty)
+	*/
+	void update(std::span<const uint8_t> in) override;
+
+	/**
+	* Finish incremental hashing and store the hash in the given buffer.
+	* @param out[out] buffer to store hash (nothing is done if it is too small).
+	*/
+	void final(std::span<uint8_t> out) override;
+
+private:
+	State state_{};								// Incremental hashing state
+};
+
+#endif // BLAKE3_H
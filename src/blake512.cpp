@@ -16,6 +16,17 @@
 #include <stdio.h>
 #include <stdint.h>
 
+#if defined(__x86_64__) || defined(_M_X64)
+#define RH_BLAKE_X86
+#include <immintrin.h>
+#endif
+
+#if defined(RH_BLAKE_X86) && (defined(__GNUC__) || defined(__clang__))
+#define RH_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define RH_TARGET_AVX2
+#endif
+
 #define U8TO32_BIG(p)					      \
   (((uint32_t)((p)[0]) << 24) | ((uint32_t)((p)[1]) << 16) |  \
    ((uint32_t)((p)[2]) <<  8) | ((uint32_t)((p)[3])      ))
@@ -40,12 +51,9 @@ typedef struct
 
 typedef state256 state224;
 
-typedef struct
-{
-    uint64_t h[8], s[4], t[2];
-    unsigned int buflen, nullt;
-    uint8_t buf[128];
-} state512;
+typedef BLAKE512::State state512;
+
+typedef void (*compress512)(state512* S, const uint8_t* block);
 
 typedef state512 state384;
 
@@ -159,6 +167,237 @@ void blake512_compress(state512* S, const uint8_t* block)
 }
 
 
+#ifdef RH_BLAKE_X86
+
+/* Rounds of the AVX2 compression work on rows of the state (v[0..3], v[4..7],
+   v[8..11], v[12..15]) - the four G functions of a step run in the four 64-bit
+   lanes. Message words and constants of every step are taken in lane order:
+   column step uses sigma entries 0,2,4,6 (first half of G) and 1,3,5,7 (second
+   half), diagonal step 8,10,12,14 and 9,11,13,15. */
+static const uint8_t lane_order[16] = { 0, 2, 4, 6, 1, 3, 5, 7, 8, 10, 12, 14, 9, 11, 13, 15 };
+
+/* u512[sigma[r][e ^ 1]] in lane order - constant xored with message word sigma[r][e] */
+struct RoundConstants
+{
+    uint64_t c[16][16];
+    uint8_t m[16][16];
+};
+
+static RoundConstants make_round_constants()
+{
+    RoundConstants rc;
+    for (int r = 0; r < 16; ++r)
+        for (int k = 0; k < 16; ++k)
+        {
+            rc.m[r][k] = sigma[r][lane_order[k]];
+            rc.c[r][k] = u512[sigma[r][lane_order[k] ^ 1]];
+        }
+    return rc;
+}
+
+static const RoundConstants round_constants = make_round_constants();
+
+RH_TARGET_AVX2 static inline __m256i rotr64_avx2(__m256i x, int n)
+{
+    return _mm256_or_si256(_mm256_srli_epi64(x, n), _mm256_slli_epi64(x, 64 - n));
+}
+
+RH_TARGET_AVX2 void blake512_compress_avx2(state512* S, const uint8_t* block)
+{
+    const __m256i bswap64 = _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+                                             7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+    const __m256i rotr16 = _mm256_setr_epi8(2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9,
+                                            2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9);
+    alignas(32) uint64_t m[16];
+
+    for (int i = 0; i < 4; ++i)
+    {
+        const __m256i words = _mm256_loadu_si256((const __m256i*)(block + 32 * i));
+        _mm256_store_si256((__m256i*)(m + 4 * i), _mm256_shuffle_epi8(words, bswap64));
+    }
+
+    const __m256i h0 = _mm256_loadu_si256((const __m256i*)S->h);
+    const __m256i h1 = _mm256_loadu_si256((const __m256i*)(S->h + 4));
+    const __m256i salt = _mm256_loadu_si256((const __m256i*)S->s);
+
+    __m256i a = h0;
+    __m256i b = h1;
+    __m256i c = _mm256_xor_si256(salt, _mm256_loadu_si256((const __m256i*)u512));
+    __m256i d = _mm256_loadu_si256((const __m256i*)(u512 + 4));
+
+    /* don't xor t when the block is only padding */
+    if (!S->nullt)
+        d = _mm256_xor_si256(d, _mm256_setr_epi64x((long long)S->t[0], (long long)S->t[0],
+                                                   (long long)S->t[1], (long long)S->t[1]));
+
+#define G4(step)                                                                                \
+    {                                                                                           \
+        const uint8_t* mi = round_constants.m[r] + 8 * step;                                   \
+        const uint64_t* ci = round_constants.c[r] + 8 * step;                                  \
+        const __m256i m0 = _mm256_setr_epi64x((long long)m[mi[0]], (long long)m[mi[1]],         \
+                                              (long long)m[mi[2]], (long long)m[mi[3]]);        \
+        const __m256i m1 = _mm256_setr_epi64x((long long)m[mi[4]], (long long)m[mi[5]],         \
+                                              (long long)m[mi[6]], (long long)m[mi[7]]);        \
+        a = _mm256_add_epi64(_mm256_add_epi64(a, b),                                            \
+                             _mm256_xor_si256(m0, _mm256_loadu_si256((const __m256i*)ci)));     \
+        d = _mm256_shuffle_epi32(_mm256_xor_si256(d, a), _MM_SHUFFLE(2, 3, 0, 1));             \
+        c = _mm256_add_epi64(c, d);                                                             \
+        b = rotr64_avx2(_mm256_xor_si256(b, c), 25);                                            \
+        a = _mm256_add_epi64(_mm256_add_epi64(a, b),                                            \
+                             _mm256_xor_si256(m1, _mm256_loadu_si256((const __m256i*)(ci + 4)))); \
+        d = _mm256_shuffle_epi8(_mm256_xor_si256(d, a), rotr16);                               \
+        c = _mm256_add_epi64(c, d);                                                             \
+        b = rotr64_avx2(_mm256_xor_si256(b, c), 11);                                            \
+    }
+
+    for (int r = 0; r < 16; ++r)
+    {
+        /* column step */
+        G4(0);
+        /* diagonal step - rotate rows so that diagonals become columns */
+        b = _mm256_permute4x64_epi64(b, _MM_SHUFFLE(0, 3, 2, 1));
+        c = _mm256_permute4x64_epi64(c, _MM_SHUFFLE(1, 0, 3, 2));
+        d = _mm256_permute4x64_epi64(d, _MM_SHUFFLE(2, 1, 0, 3));
+        G4(1);
+        b = _mm256_permute4x64_epi64(b, _MM_SHUFFLE(2, 1, 0, 3));
+        c = _mm256_permute4x64_epi64(c, _MM_SHUFFLE(1, 0, 3, 2));
+        d = _mm256_permute4x64_epi64(d, _MM_SHUFFLE(0, 3, 2, 1));
+    }
+#undef G4
+
+    _mm256_storeu_si256((__m256i*)S->h, _mm256_xor_si256(_mm256_xor_si256(h0, salt), _mm256_xor_si256(a, c)));
+    _mm256_storeu_si256((__m256i*)(S->h + 4), _mm256_xor_si256(_mm256_xor_si256(h1, salt), _mm256_xor_si256(b, d)));
+}
+
+/* 4x4 transpose of 64-bit words: row i becomes word i of every row */
+RH_TARGET_AVX2 static inline void transpose4x64_avx2(__m256i r[4])
+{
+    const __m256i t0 = _mm256_unpacklo_epi64(r[0], r[1]);
+    const __m256i t1 = _mm256_unpackhi_epi64(r[0], r[1]);
+    const __m256i t2 = _mm256_unpacklo_epi64(r[2], r[3]);
+    const __m256i t3 = _mm256_unpackhi_epi64(r[2], r[3]);
+    r[0] = _mm256_permute2x128_si256(t0, t2, 0x20);
+    r[1] = _mm256_permute2x128_si256(t1, t3, 0x20);
+    r[2] = _mm256_permute2x128_si256(t0, t2, 0x31);
+    r[3] = _mm256_permute2x128_si256(t1, t3, 0x31);
+}
+
+/* Multi-buffer compression of four independent states, one per 64-bit lane: v[i]
+   holds word i of all four states, so the G functions are the scalar ones applied
+   lane-wise - no diagonalization, and all four G functions of a step are independent. */
+RH_TARGET_AVX2 static void blake512_compress4_avx2(state512* const S[4], const uint8_t* const block[4])
+{
+    const __m256i bswap64 = _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+                                             7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+    const __m256i rotr16 = _mm256_setr_epi8(2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9,
+                                            2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9);
+    __m256i m[16], v[16], h[8], s[4];
+    int i, r;
+
+    for (i = 0; i < 4; ++i)
+    {
+        for (int l = 0; l < 4; ++l)
+            m[4 * i + l] = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(block[l] + 32 * i)), bswap64);
+        transpose4x64_avx2(m + 4 * i);
+    }
+
+    for (i = 0; i < 2; ++i)
+    {
+        for (int l = 0; l < 4; ++l)
+            h[4 * i + l] = _mm256_loadu_si256((const __m256i*)(S[l]->h + 4 * i));
+        transpose4x64_avx2(h + 4 * i);
+    }
+    for (int l = 0; l < 4; ++l)
+        s[l] = _mm256_loadu_si256((const __m256i*)S[l]->s);
+    transpose4x64_avx2(s);
+
+    /* don't xor t when the block is only padding */
+    const __m256i t0 = _mm256_setr_epi64x(S[0]->nullt ? 0 : (long long)S[0]->t[0], S[1]->nullt ? 0 : (long long)S[1]->t[0],
+                                          S[2]->nullt ? 0 : (long long)S[2]->t[0], S[3]->nullt ? 0 : (long long)S[3]->t[0]);
+    const __m256i t1 = _mm256_setr_epi64x(S[0]->nullt ? 0 : (long long)S[0]->t[1], S[1]->nullt ? 0 : (long long)S[1]->t[1],
+                                          S[2]->nullt ? 0 : (long long)S[2]->t[1], S[3]->nullt ? 0 : (long long)S[3]->t[1]);
+
+    for (i = 0; i < 8; ++i)  v[i] = h[i];
+    for (i = 0; i < 4; ++i)  v[8 + i] = _mm256_xor_si256(s[i], _mm256_set1_epi64x((long long)u512[i]));
+    v[12] = _mm256_xor_si256(t0, _mm256_set1_epi64x((long long)u512[4]));
+    v[13] = _mm256_xor_si256(t0, _mm256_set1_epi64x((long long)u512[5]));
+    v[14] = _mm256_xor_si256(t1, _mm256_set1_epi64x((long long)u512[6]));
+    v[15] = _mm256_xor_si256(t1, _mm256_set1_epi64x((long long)u512[7]));
+
+#define G4X(a,b,c,d,e)                                                                          \
+    v[a] = _mm256_add_epi64(_mm256_add_epi64(v[a], v[b]),                                       \
+        _mm256_xor_si256(m[sigma[r][e]], _mm256_set1_epi64x((long long)u512[sigma[r][e+1]]))); \
+    v[d] = _mm256_shuffle_epi32(_mm256_xor_si256(v[d], v[a]), _MM_SHUFFLE(2, 3, 0, 1));         \
+    v[c] = _mm256_add_epi64(v[c], v[d]);                                                        \
+    v[b] = rotr64_avx2(_mm256_xor_si256(v[b], v[c]), 25);                                       \
+    v[a] = _mm256_add_epi64(_mm256_add_epi64(v[a], v[b]),                                       \
+        _mm256_xor_si256(m[sigma[r][e+1]], _mm256_set1_epi64x((long long)u512[sigma[r][e]]))); \
+    v[d] = _mm256_shuffle_epi8(_mm256_xor_si256(v[d], v[a]), rotr16);                          \
+    v[c] = _mm256_add_epi64(v[c], v[d]);                                                        \
+    v[b] = rotr64_avx2(_mm256_xor_si256(v[b], v[c]), 11);
+
+    for (r = 0; r < 16; ++r)
+    {
+        /* column step */
+        G4X(0, 4, 8, 12, 0);
+        G4X(1, 5, 9, 13, 2);
+        G4X(2, 6, 10, 14, 4);
+        G4X(3, 7, 11, 15, 6);
+        /* diagonal step */
+        G4X(0, 5, 10, 15, 8);
+        G4X(1, 6, 11, 12, 10);
+        G4X(2, 7, 8, 13, 12);
+        G4X(3, 4, 9, 14, 14);
+    }
+#undef G4X
+
+    for (i = 0; i < 8; ++i)
+        h[i] = _mm256_xor_si256(_mm256_xor_si256(h[i], s[i % 4]), _mm256_xor_si256(v[i], v[i + 8]));
+    for (i = 0; i < 2; ++i)
+    {
+        transpose4x64_avx2(h + 4 * i);
+        for (int l = 0; l < 4; ++l)
+            _mm256_storeu_si256((__m256i*)(S[l]->h + 4 * i), h[4 * i + l]);
+    }
+}
+
+#endif /* RH_BLAKE_X86 */
+
+
+static const IsaKernel<compress512> compress_kernels[] =
+{
+#ifdef RH_BLAKE_X86
+    { CpuIsa::AVX2, blake512_compress_avx2 },
+#endif
+    { CpuIsa::SCALAR, blake512_compress },
+};
+
+
+static compress512 compress_for(BlakeIsa isa)
+{
+    return select_kernel(compress_kernels, isa).fn;
+}
+
+
+BlakeIsa blake512_kernel_isa(CpuIsa isa) noexcept
+{
+    return select_kernel(compress_kernels, isa).isa;
+}
+
+
+BlakeIsa blake512_best_isa() noexcept
+{
+    static const BlakeIsa best = blake512_kernel_isa(cpu_best_isa());
+    return best;
+}
+
+
+const char* blake512_isa_name(BlakeIsa isa) noexcept
+{
+    return cpu_isa_name(isa);
+}
+
+
 void blake512_init(state512* S)
 {
     S->h[0] = 0x6a09e667f3bcc908ULL;
@@ -174,7 +413,7 @@ void blake512_init(state512* S)
 }
 
 
-void blake512_update(state512* S, const uint8_t* in, uint64_t inlen)
+void blake512_update(state512* S, const uint8_t* in, uint64_t inlen, compress512 compress)
 {
     unsigned int left = S->buflen;
     unsigned int fill = 128 - left;
@@ -187,7 +426,7 @@ void blake512_update(state512* S, const uint8_t* in, uint64_t inlen)
 
         if (S->t[0] == 0) S->t[1]++;
 
-        blake512_compress(S, S->buf);
+        compress(S, S->buf);
         in += fill;
         inlen -= fill;
         left = 0;
@@ -200,7 +439,7 @@ void blake512_update(state512* S, const uint8_t* in, uint64_t inlen)
 
         if (S->t[0] == 0) S->t[1]++;
 
-        blake512_compress(S, in);
+        compress(S, in);
         in += 128;
         inlen -= 128;
     }
@@ -216,7 +455,7 @@ void blake512_update(state512* S, const uint8_t* in, uint64_t inlen)
 }
 
 
-void blake512_final(state512* S, uint8_t* out)
+void blake512_final(state512* S, uint8_t* out, compress512 compress)
 {
     uint8_t msglen[16], zo = 0x01, oo = 0x81;
     uint64_t lo = S->t[0] + (S->buflen << 3), hi = S->t[1];
@@ -230,7 +469,7 @@ void blake512_final(state512* S, uint8_t* out)
     if (S->buflen == 111)   /* one padding byte */
     {
         S->t[0] -= 8;
-        blake512_update(S, &oo, 1);
+        blake512_update(S, &oo, 1, compress);
     }
     else
     {
@@ -239,23 +478,23 @@ void blake512_final(state512* S, uint8_t* out)
             if (!S->buflen) S->nullt = 1;
 
             S->t[0] -= 888 - (S->buflen << 3);
-            blake512_update(S, padding, 111 - S->buflen);
+            blake512_update(S, padding, 111 - S->buflen, compress);
         }
         else   /* need 2 compressions */
         {
             S->t[0] -= 1024 - (S->buflen << 3);
-            blake512_update(S, padding, 128 - S->buflen);
+            blake512_update(S, padding, 128 - S->buflen, compress);
             S->t[0] -= 888;
-            blake512_update(S, padding + 1, 111);
+            blake512_update(S, padding + 1, 111, compress);
             S->nullt = 1;
         }
 
-        blake512_update(S, &zo, 1);
+        blake512_update(S, &zo, 1, compress);
         S->t[0] -= 8;
     }
 
     S->t[0] -= 128;
-    blake512_update(S, msglen, 16);
+    blake512_update(S, msglen, 16, compress);
     U64TO8_BIG(out + 0, S->h[0]);
     U64TO8_BIG(out + 8, S->h[1]);
     U64TO8_BIG(out + 16, S->h[2]);
@@ -267,11 +506,184 @@ void blake512_final(state512* S, uint8_t* out)
 }
 
 
+#ifdef RH_BLAKE_X86
+
+/* Message hashed in a multi-buffer lane. Full input blocks are compressed in place,
+   the last one or two blocks (rest of the input, padding and message length) are
+   built in tail up front - the same blocks blake512_final() would compress. */
+typedef struct
+{
+    state512 S;
+    const uint8_t* in;            /* next full input block */
+    uint64_t blocks;              /* full input blocks left */
+    uint64_t lo, hi;              /* message length in bits */
+    unsigned int tail_blocks;     /* 1 or 2 */
+    unsigned int tail_next;       /* tail blocks already returned */
+    uint8_t* out;
+    uint8_t tail[256];
+} lane512;
+
+static void lane512_start(lane512* L, const uint8_t* in, uint64_t inlen, uint8_t* out)
+{
+    const unsigned int rest = (unsigned int)(inlen % 128);
+    const unsigned int last = rest > 111 ? 128 : 0;   /* offset of the block with the length */
+
+    blake512_init(&L->S);
+    L->in = in;
+    L->blocks = inlen / 128;
+    L->lo = inlen << 3;
+    L->hi = inlen >> 61;
+    L->tail_blocks = last ? 2 : 1;
+    L->tail_next = 0;
+    L->out = out;
+
+    memset(L->tail, 0, sizeof(L->tail));
+    if (rest)
+        memcpy(L->tail, in + (inlen - rest), rest);
+    L->tail[rest] = 0x80;
+    L->tail[last + 111] |= 0x01;
+    U64TO8_BIG(L->tail + last + 112, L->hi);
+    U64TO8_BIG(L->tail + last + 120, L->lo);
+}
+
+/* Set counter of the lane's next block and return it, NULL when the message is done. */
+static const uint8_t* lane512_next(lane512* L)
+{
+    if (L->blocks)
+    {
+        const uint8_t* block = L->in;
+        L->S.t[0] += 1024;
+        if (L->S.t[0] == 0) L->S.t[1]++;
+        L->in += 128;
+        L->blocks--;
+        return block;
+    }
+
+    if (L->tail_next == L->tail_blocks)
+        return NULL;
+
+    if (L->tail_next == 0)
+    {
+        L->S.t[0] = L->lo;
+        L->S.t[1] = L->hi;
+        L->S.nullt = (L->lo % 1024) == 0;   /* no input bytes in the block */
+    }
+    else
+        L->S.nullt = 1;
+    return L->tail + 128 * L->tail_next++;
+}
+
+static void lane512_finish(const lane512* L)
+{
+    for (int i = 0; i < 8; ++i)
+    {
+        U64TO8_BIG(L->out + 8 * i, L->S.h[i]);
+    }
+}
+
+/* Hash inputs four at a time; a lane whose message is finished takes the next one.
+   When fewer than two lanes are busy, the rest is compressed one lane at a time. */
+static void blake512_hash_many_avx2(std::span<const std::span<const uint8_t>> inputs,
+                                    std::span<const std::span<uint8_t>> outputs)
+{
+    const size_t count = inputs.size() < outputs.size() ? inputs.size() : outputs.size();
+    static const uint8_t idle_block[128] = { 0 };
+    state512 idle_state;
+    lane512 lanes[4];
+    state512* states[4];
+    const uint8_t* blocks[4] = { NULL, NULL, NULL, NULL };
+    const uint8_t* current[4];
+    size_t next = 0;
+    int l;
+
+    blake512_init(&idle_state);
+
+    for (;;)
+    {
+        unsigned int busy = 0;
+        for (l = 0; l < 4; ++l)
+        {
+            while (!blocks[l] && next < count)
+            {
+                if (outputs[next].size() >= BLAKE512::HASH_SIZE)
+                {
+                    lane512_start(&lanes[l], inputs[next].data(), inputs[next].size(), outputs[next].data());
+                    blocks[l] = lane512_next(&lanes[l]);
+                }
+                ++next;
+            }
+            busy += blocks[l] != NULL;
+        }
+        if (busy < 2)
+            break;
+
+        for (l = 0; l < 4; ++l)
+        {
+            states[l] = blocks[l] ? &lanes[l].S : &idle_state;
+            current[l] = blocks[l] ? blocks[l] : idle_block;
+        }
+        blake512_compress4_avx2(states, current);
+
+        for (l = 0; l < 4; ++l)
+            if (blocks[l] && !(blocks[l] = lane512_next(&lanes[l])))
+                lane512_finish(&lanes[l]);
+    }
+
+    for (l = 0; l < 4; ++l)
+    {
+        if (!blocks[l])
+            continue;
+        do
+            blake512_compress_avx2(&lanes[l].S, blocks[l]);
+        while ((blocks[l] = lane512_next(&lanes[l])));
+        lane512_finish(&lanes[l]);
+    }
+}
+
+#endif /* RH_BLAKE_X86 */
+
+
 void BLAKE512::blake512_hash(uint8_t* out, const uint8_t* in, uint64_t inlen)
 {
+    const compress512 compress = compress_for(isa_);
     state512 S;
     blake512_init(&S);
-    blake512_update(&S, in, inlen);
-    blake512_final(&S, out);
+    blake512_update(&S, in, inlen, compress);
+    blake512_final(&S, out, compress);
 }
 
+
+void BLAKE512::init()
+{
+    blake512_init(&state_);
+}
+
+
+void BLAKE512::update(std::span<const uint8_t> in)
+{
+    if (!in.empty())
+        blake512_update(&state_, in.data(), in.size(), compress_for(isa_));
+}
+
+
+void BLAKE512::final(std::span<uint8_t> out)
+{
+    if (out.size() < HASH_SIZE)
+        return;
+
+    blake512_final(&state_, out.data(), compress_for(isa_));
+}
+
+
+void BLAKE512::hash_many(std::span<const std::span<const uint8_t>> inputs,
+                         std::span<const std::span<uint8_t>> outputs)
+{
+#ifdef RH_BLAKE_X86
+    if (isa_ == BlakeIsa::AVX2)
+    {
+        blake512_hash_many_avx2(inputs, outputs);
+        return;
+    }
+#endif
+    IHash::hash_many(inputs, outputs);
+}
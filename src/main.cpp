@@ -1,46 +1,250 @@
+#include <algorithm>
+#include <charconv>
+#include <iomanip>
 #include <iostream>
+#include <optional>
+#include <string>
 #include <string_view>
+#include <type_traits>
+#include <vector>
 
 #include "rh_config.h"
 
 #include "Apply.hpp"
+#include "ChunkStats.hpp"
+#include "ChunkingPolicy.hpp"
 #include "Delta.hpp"
+#include "DeltaHeader.hpp"
 #include "DeltaViewer.hpp"
 #include "RK_finger.hpp"
 #include "Signature.hpp"
-#include "blake.h"
+#include "SignatureFile.hpp"
+#include "StrongHash.hpp"
 
 namespace {
 
+/**
+* Command line options shared by subcommands. Positional arguments are collected
+* in order, options may appear anywhere after the subcommand.
+*/
+struct Options {
+	unsigned int threads = 1;
+	std::optional<uint8_t> chunking;					// default policy if not given
+	std::optional<uint8_t> strong_hash;					// default strong hash if not given
+	const char* signature = nullptr;					// precomputed signature of the old file
+	std::vector<ByteRange> changed;						// ranges changed since the signature was written
+	bool stats = false;									// print chunking and delta statistics
+	bool digest = false;								// print strong hash of the signed file
+	std::vector<const char*> args;
+};
+
 void print_usage(const char* prog)
 {
 	std::cout << "Usage:" << std::endl;
-	std::cout << "  " << prog << " create <oldfile> <newfile> <delta>" << std::endl;
-	std::cout << "  " << prog << " apply  <oldfile> <delta> <outfile>" << std::endl;
+	std::cout << "  " << prog << " sign   [--threads N] [--chunking small|default|large[-fp]] [--hash blake512|blake3|xxh3] [--stats] [--digest] <file> <sigfile>" << std::endl;
+	std::cout << "  " << prog << " sign   --signature <oldsigfile> [--changed OFFSET:LENGTH]... <file> <sigfile>" << std::endl;
+	std::cout << "  " << prog << " create [--threads N] [--chunking small|default|large[-fp]] [--hash blake512|blake3|xxh3] [--signature <oldsigfile>] [--stats] <oldfile> <newfile> <delta>" << std::endl;
+	std::cout << "  (use - as <newfile> to read the new file from standard input)" << std::endl;
+	std::cout << "  " << prog << " apply  [--threads N] [--signature <oldsigfile>] <oldfile> <delta> <outfile>" << std::endl;
 	std::cout << "  " << prog << " view   <delta>" << std::endl;
 }
 
-int run_create(const char* old_path, const char* new_path, const char* delta_path)
+/**
+* Print chunk size distribution and timing of a chunked file.
+*/
+void print_chunk_stats(const char* name, const ChunkStats& stats)
 {
-	Signature<RKFinger, BLAKE512> old_signature;
-	Signature<RKFinger, BLAKE512> new_signature;
+	std::cout << std::fixed << std::setprecision(1);
+	std::cout << name << ": " << stats.chunk_count << " chunks, " << stats.total_bytes << " bytes in "
+	          << stats.elapsed_ms << " ms (" << stats.throughput_mib_s() << " MiB/s)" << std::endl;
+	if (stats.chunk_count == 0)
+		return;
+
+	std::cout << "  chunk size min " << stats.min_chunk_size << ", avg " << stats.average_chunk_size()
+	          << ", max " << stats.max_chunk_size << ", forced cuts " << stats.forced_cuts << " ("
+	          << 100.0 * double(stats.forced_cuts) / double(stats.chunk_count) << "%)" << std::endl;
 
-	old_signature.generate_signatures(old_path);
-	new_signature.generate_signatures(new_path);
+	const size_t peak = *std::max_element(stats.histogram.begin(), stats.histogram.end());
+	for (size_t b = 0; b < stats.histogram.size(); b++) {
+		if (stats.histogram[b] == 0)
+			continue;
+		const size_t bar = (stats.histogram[b] * 40 + peak - 1) / peak;
+		std::cout << "  [" << std::setw(7) << (size_t(1) << b) << ", " << std::setw(7) << (size_t(2) << b) << ") "
+		          << std::setw(9) << stats.histogram[b] << " " << std::string(bar, '#') << std::endl;
+	}
+}
 
-	Delta<RKFinger, BLAKE512> delta;
-	auto result = delta.generate_delta(old_signature, new_signature, old_path, new_path, delta_path);
+/**
+* Print entry breakdown and timing of a generated delta.
+*/
+void print_delta_stats(const DeltaStats& stats, size_t bytes_written)
+{
+	auto percent = [&](uint64_t bytes) {
+		return stats.new_bytes() ? 100.0 * double(bytes) / double(stats.new_bytes()) : 0.0;
+	};
+
+	std::cout << std::fixed << std::setprecision(1);
+	std::cout << "Delta: " << bytes_written << " bytes written in " << stats.elapsed_ms << " ms" << std::endl;
+	std::cout << "  original " << std::setw(9) << stats.original_chunks << " chunks " << std::setw(12)
+	          << stats.original_bytes << " bytes (" << percent(stats.original_bytes) << "%)" << std::endl;
+	std::cout << "  modified " << std::setw(9) << stats.modified_chunks << " chunks " << std::setw(12)
+	          << stats.modified_bytes << " bytes (" << percent(stats.modified_bytes) << "%)" << std::endl;
+	std::cout << "  added    " << std::setw(9) << stats.added_chunks << " chunks " << std::setw(12)
+	          << stats.added_bytes << " bytes (" << percent(stats.added_bytes) << "%)" << std::endl;
+	std::cout << "  removed  " << std::setw(9) << stats.removed_chunks << " chunks " << std::setw(12)
+	          << stats.removed_bytes << " bytes of old file" << std::endl;
+	std::cout << "  matched " << 100.0 * stats.matched_ratio() << "% of new file, payload "
+	          << stats.payload_bytes << " bytes" << std::endl;
+	std::cout << "  super-chunks matched " << stats.matched_super_chunks << ", old chunks indexed "
+	          << stats.indexed_chunks << std::endl;
+}
+
+/**
+* Call fn with the chunking policy selected by ID (passed as an empty tag object).
+*/
+template <class F>
+int with_chunking_policy(uint8_t id, F&& fn)
+{
+	switch (id) {
+		case SmallChunkingPolicy::ID:   return fn(SmallChunkingPolicy{});
+		case DefaultChunkingPolicy::ID: return fn(DefaultChunkingPolicy{});
+		case LargeChunkingPolicy::ID:   return fn(LargeChunkingPolicy{});
+		case SmallFingerprintChunkingPolicy::ID:   return fn(SmallFingerprintChunkingPolicy{});
+		case DefaultFingerprintChunkingPolicy::ID: return fn(DefaultFingerprintChunkingPolicy{});
+		case LargeFingerprintChunkingPolicy::ID:   return fn(LargeFingerprintChunkingPolicy{});
+		default:
+			std::cerr << "Unknown chunking policy " << static_cast<int>(id) << std::endl;
+			return 1;
+	}
+}
+
+/**
+* Call fn with the strong hash selected by ID (passed as std::type_identity tag).
+*/
+template <class F>
+int with_strong_hash(uint8_t id, F&& fn)
+{
+	switch (id) {
+		case BLAKE512::ID: return fn(std::type_identity<BLAKE512>{});
+		case BLAKE3::ID:   return fn(std::type_identity<BLAKE3>{});
+		case XXH3_128::ID: return fn(std::type_identity<XXH3_128>{});
+		default:
+			std::cerr << "Unknown strong hash " << static_cast<int>(id) << std::endl;
+			return 1;
+	}
+}
+
+/**
+* Parse unsigned decimal number which has to span the whole string.
+*/
+template <class V>
+bool parse_number(std::string_view text, V& value)
+{
+	auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+	return ec == std::errc() && ptr == text.data() + text.size();
+}
+
+bool parse_options(int argc, const char** argv, Options& options)
+{
+	for (int i = 2; i < argc; i++) {
+		const std::string_view arg{argv[i]};
+		if (arg == "--threads") {
+			if (i + 1 >= argc)
+				return false;
+			if (!parse_number(argv[++i], options.threads) || options.threads == 0)
+				return false;
+		} else if (arg == "--chunking") {
+			uint8_t id = 0;
+			if (i + 1 >= argc || !chunking_policy_from_name(argv[++i], id))
+				return false;
+			options.chunking = id;
+		} else if (arg == "--hash") {
+			uint8_t id = 0;
+			if (i + 1 >= argc || !strong_hash_from_name(argv[++i], id))
+				return false;
+			options.strong_hash = id;
+		} else if (arg == "--signature") {
+			if (i + 1 >= argc)
+				return false;
+			options.signature = argv[++i];
+		} else if (arg == "--changed") {
+			if (i + 1 >= argc)
+				return false;
+			const std::string_view value{argv[++i]};
+			const auto colon = value.find(':');
+			ByteRange range{};
+			if (colon == std::string_view::npos || !parse_number(value.substr(0, colon), range.offset) ||
+			    !parse_number(value.substr(colon + 1), range.size))
+				return false;
+			options.changed.push_back(range);
+		} else if (arg == "--stats") {
+			options.stats = true;
+		} else if (arg == "--digest") {
+			options.digest = true;
+		} else if (arg.starts_with("--")) {
+			return false;
+		} else {
+			options.args.push_back(argv[i]);
+		}
+	}
+	return true;
+}
+
+template <StrongHashAlgorithm U, ChunkingPolicyType P>
+int create_delta(const char* old_path, const char* new_path, const char* delta_path, const Options& options)
+{
+	Signature<RKFinger, U, P> old_signature;
+	Signature<RKFinger, U, P> new_signature;
+	Delta<RKFinger, U, P> delta;
+
+	old_signature.set_threads(options.threads);
+	new_signature.set_threads(options.threads);
+
+	if (options.signature) {
+		if (!old_signature.load_signatures(options.signature, old_path)) {
+			std::cerr << "Error generating delta: Signature file is invalid or does not match old file: "
+			          << options.signature << std::endl;
+			return 1;
+		}
+	} else {
+		old_signature.generate_signatures(old_path);
+	}
+
+	typename Delta<RKFinger, U, P>::Result result;
+	const bool streamed = std::string_view(new_path) == "-";
+	if (streamed) {
+		// New file is chunked while it is read, its entries are written right away.
+		FileIO input;
+		if (!input.open_stdin()) {
+			std::cerr << "Error generating delta: Failed to open standard input" << std::endl;
+			return 1;
+		}
+		result = delta.generate_delta_stream(old_signature, new_signature, input, old_path, delta_path);
+	} else {
+		new_signature.generate_signatures(new_path);
+		result = delta.generate_delta(old_signature, new_signature, old_path, new_path, delta_path);
+	}
 
 	if (!result.success) {
 		std::cerr << "Error generating delta: " << result.error_message << std::endl;
 		return 1;
 	}
+
+	if (options.stats) {
+		print_chunk_stats(options.signature ? "Old file (loaded)" : "Old file", old_signature.get_stats());
+		print_chunk_stats(streamed ? "New file (streamed, time includes delta)" : "New file", new_signature.get_stats());
+		print_delta_stats(result.stats, result.bytes_written);
+	}
 	return 0;
 }
 
-int run_apply(const char* old_path, const char* delta_path, const char* out_path)
+template <StrongHashAlgorithm U, ChunkingPolicyType P>
+int apply_delta(const char* old_path, const char* delta_path, const char* out_path, const Options& options)
 {
-	Apply<RKFinger, BLAKE512> apply;
+	Apply<RKFinger, U, P> apply;
+	apply.set_threads(options.threads);
+	if (options.signature)
+		apply.set_old_signature_file(options.signature);
 	auto result = apply.apply_delta(old_path, delta_path, out_path);
 
 	if (!result.success) {
@@ -53,6 +257,114 @@ int run_apply(const char* old_path, const char* delta_path, const char* out_path
 	return 0;
 }
 
+template <StrongHashAlgorithm U, ChunkingPolicyType P>
+int sign_file(const char* path, const char* signature_path, const Options& options)
+{
+	Signature<RKFinger, U, P> signature;
+	signature.set_threads(options.threads);
+	signature.set_file_digest(options.digest);
+	if (options.signature) {
+		if (!signature.refresh_signatures(options.signature, path, options.changed))
+			std::cout << "Previous signature not usable, signed from scratch" << std::endl;
+	} else {
+		signature.generate_signatures(path);
+	}
+
+	if (!signature.save_signatures(signature_path, path)) {
+		std::cerr << "Error writing signature file: " << signature_path << std::endl;
+		return 1;
+	}
+
+	std::cout << "Signed " << signature.get_chunks().size() << " chunks of " << path
+	          << " to " << signature_path << std::endl;
+	if (options.stats)
+		print_chunk_stats(path, signature.get_stats());
+	if (options.digest) {
+		if (const auto& digest = signature.get_file_digest()) {
+			std::cout << U::NAME << ' ' << std::hex << std::setfill('0');
+			for (uint8_t b : *digest)
+				std::cout << std::setw(2) << unsigned(b);
+			std::cout << std::dec << std::setfill(' ') << "  " << path << std::endl;
+		} else {
+			std::cout << "File digest not computed (previous signature reused)" << std::endl;
+		}
+	}
+	return 0;
+}
+
+int run_sign(const char* path, const char* signature_path, const Options& options)
+{
+	// Refreshed signature keeps the chunking policy and the strong hash of the previous one.
+	uint8_t chunking = options.chunking.value_or(DefaultChunkingPolicy::ID);
+	uint8_t strong_hash = options.strong_hash.value_or(DefaultStrongHash::ID);
+	SignatureFileHeader header;
+	if (options.signature && read_signature_file_header(options.signature, header)) {
+		if (!options.chunking)
+			chunking = header.chunking_policy;
+		if (!options.strong_hash)
+			strong_hash_from_size(header.hash_size, strong_hash);
+	}
+
+	return with_strong_hash(strong_hash, [&]<class U>(std::type_identity<U>) {
+		return with_chunking_policy(chunking, [&]<class P>(P) {
+			return sign_file<U, P>(path, signature_path, options);
+		});
+	});
+}
+
+int run_create(const char* old_path, const char* new_path, const char* delta_path, const Options& options)
+{
+	uint8_t chunking = options.chunking.value_or(DefaultChunkingPolicy::ID);
+	uint8_t strong_hash = options.strong_hash.value_or(DefaultStrongHash::ID);
+
+	// Precomputed signature determines the chunking policy and the strong hash of the delta.
+	if (options.signature) {
+		SignatureFileHeader header;
+		if (!read_signature_file_header(options.signature, header)) {
+			std::cerr << "Error generating delta: Invalid signature file: " << options.signature << std::endl;
+			return 1;
+		}
+		if (options.chunking && *options.chunking != header.chunking_policy) {
+			std::cerr << "Error generating delta: Signature file uses different chunking policy: "
+			          << chunking_policy_name(header.chunking_policy) << std::endl;
+			return 1;
+		}
+		chunking = header.chunking_policy;
+
+		uint8_t signature_hash = 0;
+		if (!strong_hash_from_size(header.hash_size, signature_hash) ||
+		    (options.strong_hash && *options.strong_hash != signature_hash)) {
+			std::cerr << "Error generating delta: Signature file uses different strong hash ("
+			          << static_cast<int>(header.hash_size) << "-byte hashes)" << std::endl;
+			return 1;
+		}
+		strong_hash = signature_hash;
+	}
+
+	return with_strong_hash(strong_hash, [&]<class U>(std::type_identity<U>) {
+		return with_chunking_policy(chunking, [&]<class P>(P) {
+			return create_delta<U, P>(old_path, new_path, delta_path, options);
+		});
+	});
+}
+
+int run_apply(const char* old_path, const char* delta_path, const char* out_path, const Options& options)
+{
+	// Old file signature has to be regenerated with the policy and the strong hash the
+	// delta was created with.
+	DeltaHeader header;
+	if (!read_delta_header(delta_path, header)) {
+		std::cerr << "Error applying delta: Failed to open delta file: " << delta_path << std::endl;
+		return 1;
+	}
+
+	return with_strong_hash(header.strong_hash, [&]<class U>(std::type_identity<U>) {
+		return with_chunking_policy(header.chunking_policy, [&]<class P>(P) {
+			return apply_delta<U, P>(old_path, delta_path, out_path, options);
+		});
+	});
+}
+
 } // namespace
 
 int main(int argc, const char** argv)
@@ -67,28 +379,43 @@ int main(int argc, const char** argv)
 
 	const std::string_view command{argv[1]};
 
+	Options options;
+	if (!parse_options(argc, argv, options)) {
+		print_usage(argv[0]);
+		return 1;
+	}
+	const auto& args = options.args;
+
+	if (command == "sign") {
+		if (args.size() != 2 || (!options.signature && !options.changed.empty())) {
+			print_usage(argv[0]);
+			return 1;
+		}
+		return run_sign(args[0], args[1], options);
+	}
+
 	if (command == "create") {
-		if (argc != 5) {
+		if (args.size() != 3) {
 			print_usage(argv[0]);
 			return 1;
 		}
-		return run_create(argv[2], argv[3], argv[4]);
+		return run_create(args[0], args[1], args[2], options);
 	}
 
 	if (command == "apply") {
-		if (argc != 5) {
+		if (args.size() != 3) {
 			print_usage(argv[0]);
 			return 1;
 		}
-		return run_apply(argv[2], argv[3], argv[4]);
+		return run_apply(args[0], args[1], args[2], options);
 	}
 
 	if (command == "view") {
-		if (argc != 3) {
+		if (args.size() != 1) {
 			print_usage(argv[0]);
 			return 1;
 		}
-		return view_delta(argv[2]);
+		return view_delta(args[0]);
 	}
 
 	std::cerr << "Unknown command: " << command << std::endl;
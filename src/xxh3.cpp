@@ -0,0 +1,392 @@
+#include "xxh3.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+#if !defined(__SIZEOF_INT128__) && defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+namespace {
+
+constexpr uint32_t PRIME32_1 = 0x9E3779B1U;
+constexpr uint32_t PRIME32_2 = 0x85EBCA77U;
+constexpr uint32_t PRIME32_3 = 0xC2B2AE3DU;
+constexpr uint64_t PRIME64_1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr uint64_t PRIME64_3 = 0x165667B19E3779F9ULL;
+constexpr uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+constexpr uint64_t PRIME64_5 = 0x27D4EB2F165667C5ULL;
+constexpr uint64_t PRIME_MX1 = 0x165667919E3779F9ULL;
+constexpr uint64_t PRIME_MX2 = 0x9FB21C651E98DF25ULL;
+
+constexpr size_t STRIPE_LEN = 64;
+constexpr size_t SECRET_SIZE = 192;
+constexpr size_t SECRET_CONSUME_RATE = 8;					// Secret offset advance per stripe
+constexpr size_t STRIPES_PER_BLOCK = (SECRET_SIZE - STRIPE_LEN) / SECRET_CONSUME_RATE;
+constexpr size_t SECRET_LASTACC_START = 7;
+constexpr size_t SECRET_MERGEACCS_START = 11;
+constexpr size_t SECRET_SIZE_MIN = 136;
+constexpr size_t MID_SIZE_MAX = 240;
+
+alignas(64) constexpr uint8_t SECRET[SECRET_SIZE] = {
+	0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+	0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+	0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+	0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+	0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+	0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+	0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+	0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+	0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+	0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+	0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+	0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+};
+
+constexpr uint64_t INITIAL_ACC[8] = {
+	PRIME32_3, PRIME64_1, PRIME64_2, PRIME64_3, PRIME64_4, PRIME32_2, PRIME64_5, PRIME32_1
+};
+
+struct Hash128 {
+	uint64_t lo;
+	uint64_t hi;
+};
+
+inline uint32_t read32(const uint8_t* p)
+{
+	uint32_t value;
+	std::memcpy(&value, p, sizeof(value));
+	return std::endian::native == std::endian::little ? value : std::byteswap(value);
+}
+
+inline uint64_t read64(const uint8_t* p)
+{
+	uint64_t value;
+	std::memcpy(&value, p, sizeof(value));
+	return std::endian::native == std::endian::little ? value : std::byteswap(value);
+}
+
+inline void write64_be(uint8_t* p, uint64_t value)
+{
+	value = std::endian::native == std::endian::big ? value : std::byteswap(value);
+	std::memcpy(p, &value, sizeof(value));
+}
+
+inline Hash128 mul64_to128(uint64_t a, uint64_t b)
+{
+#if defined(__SIZEOF_INT128__)
+	const unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+	return { static_cast<uint64_t>(product), static_cast<uint64_t>(product >> 64) };
+#elif defined(_MSC_VER) && defined(_M_X64)
+	uint64_t hi;
+	const uint64_t lo = _umul128(a, b, &hi);
+	return { lo, hi };
+#else
+	// Schoolbook multiplication of 32-bit halves, the middle sums cannot overflow.
+	const uint64_t lo_lo = (a & 0xFFFFFFFFU) * (b & 0xFFFFFFFFU);
+	const uint64_t hi_lo = (a >> 32) * (b & 0xFFFFFFFFU);
+	const uint64_t lo_hi = (a & 0xFFFFFFFFU) * (b >> 32);
+	const uint64_t hi_hi = (a >> 32) * (b >> 32);
+	const uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFFU) + lo_hi;
+	const uint64_t upper = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+	const uint64_t lower = (cross << 32) | (lo_lo & 0xFFFFFFFFU);
+	return { lower, upper };
+#endif
+}
+
+inline uint64_t mul128_fold64(uint64_t a, uint64_t b)
+{
+	const Hash128 product = mul64_to128(a, b);
+	return product.lo ^ product.hi;
+}
+
+inline uint64_t xorshift64(uint64_t value, int shift)
+{
+	return value ^ (value >> shift);
+}
+
+uint64_t xxh64_avalanche(uint64_t value)
+{
+	value = xorshift64(value, 33) * PRIME64_2;
+	value = xorshift64(value, 29) * PRIME64_3;
+	return xorshift64(value, 32);
+}
+
+uint64_t avalanche(uint64_t value)
+{
+	value = xorshift64(value, 37) * PRIME_MX1;
+	return xorshift64(value, 32);
+}
+
+Hash128 len_1to3(const uint8_t* in, size_t len)
+{
+	const uint32_t combined = uint32_t(in[0]) << 16 | uint32_t(in[len >> 1]) << 24 | uint32_t(in[len - 1]) |
+	                          uint32_t(len) << 8;
+	const uint32_t combined_hi = std::rotl(std::byteswap(combined), 13);
+	const uint64_t flip_lo = uint64_t(read32(SECRET) ^ read32(SECRET + 4));
+	const uint64_t flip_hi = uint64_t(read32(SECRET + 8) ^ read32(SECRET + 12));
+	return { xxh64_avalanche(combined ^ flip_lo), xxh64_avalanche(combined_hi ^ flip_hi) };
+}
+
+Hash128 len_4to8(const uint8_t* in, size_t len)
+{
+	const uint64_t input = read32(in) + (uint64_t(read32(in + len - 4)) << 32);
+	const uint64_t keyed = input ^ (read64(SECRET + 16) ^ read64(SECRET + 24));
+	Hash128 m = mul64_to128(keyed, PRIME64_1 + (len << 2));
+	m.hi += m.lo << 1;
+	m.lo ^= m.hi >> 3;
+	m.lo = xorshift64(m.lo, 35) * PRIME_MX2;
+	m.lo = xorshift64(m.lo, 28);
+	return { m.lo, avalanche(m.hi) };
+}
+
+Hash128 len_9to16(const uint8_t* in, size_t len)
+{
+	const uint64_t flip_lo = read64(SECRET + 32) ^ read64(SECRET + 40);
+	const uint64_t flip_hi = read64(SECRET + 48) ^ read64(SECRET + 56);
+	const uint64_t input_lo = read64(in);
+	uint64_t input_hi = read64(in + len - 8);
+	Hash128 m = mul64_to128(input_lo ^ input_hi ^ flip_lo, PRIME64_1);
+	m.lo += uint64_t(len - 1) << 54;
+	input_hi ^= flip_hi;
+	m.hi += input_hi + uint64_t(uint32_t(input_hi)) * (PRIME32_2 - 1);
+	m.lo ^= std::byteswap(m.hi);
+
+	Hash128 h = mul64_to128(m.lo, PRIME64_2);
+	h.hi += m.hi * PRIME64_2;
+	return { avalanche(h.lo), avalanche(h.hi) };
+}
+
+Hash128 len_0to16(const uint8_t* in, size_t len)
+{
+	if (len > 8)
+		return len_9to16(in, len);
+	if (len >= 4)
+		return len_4to8(in, len);
+	if (len > 0)
+		return len_1to3(in, len);
+	return { xxh64_avalanche(read64(SECRET + 64) ^ read64(SECRET + 72)),
+	         xxh64_avalanche(read64(SECRET + 80) ^ read64(SECRET + 88)) };
+}
+
+inline uint64_t mix16(const uint8_t* in, const uint8_t* secret)
+{
+	return mul128_fold64(read64(in) ^ read64(secret), read64(in + 8) ^ read64(secret + 8));
+}
+
+inline void mix32(Hash128& acc, const uint8_t* in1, const uint8_t* in2, const uint8_t* secret)
+{
+	acc.lo += mix16(in1, secret);
+	acc.lo ^= read64(in2) + read64(in2 + 8);
+	acc.hi += mix16(in2, secret + 16);
+	acc.hi ^= read64(in1) + read64(in1 + 8);
+}
+
+Hash128 finish_mid(const Hash128& acc, size_t len)
+{
+	const uint64_t lo = acc.lo + acc.hi;
+	const uint64_t hi = acc.lo * PRIME64_1 + acc.hi * PRIME64_4 + uint64_t(len) * PRIME64_2;
+	return { avalanche(lo), 0 - avalanche(hi) };
+}
+
+Hash128 len_17to128(const uint8_t* in, size_t len)
+{
+	Hash128 acc{ len * PRIME64_1, 0 };
+	if (len > 32) {
+		if (len > 64) {
+			if (len > 96)
+				mix32(acc, in + 48, in + len - 64, SECRET + 96);
+			mix32(acc, in + 32, in + len - 48, SECRET + 64);
+		}
+		mix32(acc, in + 16, in + len - 32, SECRET + 32);
+	}
+	mix32(acc, in, in + len - 16, SECRET);
+	return finish_mid(acc, len);
+}
+
+Hash128 len_129to240(const uint8_t* in, size_t len)
+{
+	constexpr size_t START_OFFSET = 3;
+	constexpr size_t LAST_OFFSET = 17;
+
+	Hash128 acc{ len * PRIME64_1, 0 };
+	size_t i = 0;
+	for (; i < 4; i++)
+		mix32(acc, in + 32 * i, in + 32 * i + 16, SECRET + 32 * i);
+	acc.lo = avalanche(acc.lo);
+	acc.hi = avalanche(acc.hi);
+	for (; i < len / 32; i++)
+		mix32(acc, in + 32 * i, in + 32 * i + 16, SECRET + START_OFFSET + 32 * (i - 4));
+	mix32(acc, in + len - 16, in + len - 32, SECRET + SECRET_SIZE_MIN - LAST_OFFSET - 16);
+	return finish_mid(acc, len);
+}
+
+inline void accumulate_512(uint64_t acc[8], const uint8_t* in, const uint8_t* secret)
+{
+	for (int i = 0; i < 8; i++) {
+		const uint64_t data = read64(in + 8 * i);
+		const uint64_t key = data ^ read64(secret + 8 * i);
+		acc[i ^ 1] += data;
+		acc[i] += uint64_t(uint32_t(key)) * (key >> 32);
+	}
+}
+
+inline void scramble(uint64_t acc[8], const uint8_t* secret)
+{
+	for (int i = 0; i < 8; i++)
+		acc[i] = (xorshift64(acc[i], 47) ^ read64(secret + 8 * i)) * PRIME32_1;
+}
+
+void accumulate(uint64_t acc[8], const uint8_t* in, const uint8_t* secret, size_t stripes)
+{
+	for (size_t s = 0; s < stripes; s++)
+		accumulate_512(acc, in + s * STRIPE_LEN, secret + s * SECRET_CONSUME_RATE);
+}
+
+Hash128 merge(const uint64_t acc[8], uint64_t len)
+{
+	auto merge_accs = [&](const uint8_t* secret, uint64_t result) {
+		for (int i = 0; i < 4; i++)
+			result += mul128_fold64(acc[2 * i] ^ read64(secret + 16 * i), acc[2 * i + 1] ^ read64(secret + 16 * i + 8));
+		return avalanche(result);
+	};
+	return { merge_accs(SECRET + SECRET_MERGEACCS_START, len * PRIME64_1),
+	         merge_accs(SECRET + SECRET_SIZE - 64 - SECRET_MERGEACCS_START, ~(len * PRIME64_2)) };
+}
+
+Hash128 len_long(const uint8_t* in, size_t len)
+{
+	constexpr size_t BLOCK_LEN = STRIPE_LEN * STRIPES_PER_BLOCK;
+
+	uint64_t acc[8];
+	std::copy(INITIAL_ACC, INITIAL_ACC + 8, acc);
+	const size_t blocks = (len - 1) / BLOCK_LEN;
+	for (size_t b = 0; b < blocks; b++) {
+		accumulate(acc, in + b * BLOCK_LEN, SECRET, STRIPES_PER_BLOCK);
+		scramble(acc, SECRET + SECRET_SIZE - STRIPE_LEN);
+	}
+
+	accumulate(acc, in + blocks * BLOCK_LEN, SECRET, (len - 1 - blocks * BLOCK_LEN) / STRIPE_LEN);
+	accumulate_512(acc, in + len - STRIPE_LEN, SECRET + SECRET_SIZE - STRIPE_LEN - SECRET_LASTACC_START);
+	return merge(acc, len);
+}
+
+Hash128 xxh3_128(const uint8_t* in, size_t len)
+{
+	if (len <= 16)
+		return len_0to16(in, len);
+	if (len <= 128)
+		return len_17to128(in, len);
+	if (len <= MID_SIZE_MAX)
+		return len_129to240(in, len);
+	return len_long(in, len);
+}
+
+void store(uint8_t* out, const Hash128& hash)
+{
+	write64_be(out, hash.hi);
+	write64_be(out + 8, hash.lo);
+}
+
+/**
+* Accumulate stripes of the incremental state, scrambling at the end of every block.
+* @return Stripes accumulated in the current block afterwards.
+*/
+size_t consume_stripes(uint64_t acc[8], size_t stripes_done, const uint8_t* in, size_t stripes)
+{
+	if (STRIPES_PER_BLOCK - stripes_done <= stripes) {
+		const size_t to_end = STRIPES_PER_BLOCK - stripes_done;
+		accumulate(acc, in, SECRET + stripes_done * SECRET_CONSUME_RATE, to_end);
+		scramble(acc, SECRET + SECRET_SIZE - STRIPE_LEN);
+		accumulate(acc, in + to_end * STRIPE_LEN, SECRET, stripes - to_end);
+		return stripes - to_end;
+	}
+	accumulate(acc, in, SECRET + stripes_done * SECRET_CONSUME_RATE, stripes);
+	return stripes_done + stripes;
+}
+
+} // namespace
+
+void XXH3_128::hash(std::span<uint8_t> out, std::span<const uint8_t> in)
+{
+	if (out.size() < HASH_SIZE)
+		return;
+
+	store(out.data(), xxh3_128(in.data(), in.size()));
+}
+
+void XXH3_128::init()
+{
+	std::copy(INITIAL_ACC, INITIAL_ACC + 8, state_.acc);
+	state_.total_len = 0;
+	state_.stripes = 0;
+	state_.buffered = 0;
+}
+
+void XXH3_128::update(std::span<const uint8_t> in)
+{
+	constexpr size_t BUFFER_STRIPES = BUFFER_SIZE / STRIPE_LEN;
+	State& S = state_;
+	const uint8_t* data = in.data();
+	size_t len = in.size();
+	S.total_len += len;
+
+	if (S.buffered + len <= BUFFER_SIZE) {
+		std::copy(data, data + len, S.buffer + S.buffered);
+		S.buffered += static_cast<unsigned int>(len);
+		return;
+	}
+
+	// Buffer is accumulated only when more input follows, so that the last stripe
+	// is always available to final().
+	if (S.buffered > 0) {
+		const size_t fill = BUFFER_SIZE - S.buffered;
+		std::copy(data, data + fill, S.buffer + S.buffered);
+		data += fill;
+		len -= fill;
+		S.stripes = consume_stripes(S.acc, S.stripes, S.buffer, BUFFER_STRIPES);
+		S.buffered = 0;
+	}
+
+	if (len > BUFFER_SIZE) {
+		do {
+			S.stripes = consume_stripes(S.acc, S.stripes, data, BUFFER_STRIPES);
+			data += BUFFER_SIZE;
+			len -= BUFFER_SIZE;
+		} while (len > BUFFER_SIZE);
+		std::copy(data - STRIPE_LEN, data, S.buffer + BUFFER_SIZE - STRIPE_LEN);
+	}
+
+	std::copy(data, data + len, S.buffer);
+	S.buffered = static_cast<unsigned int>(len);
+}
+
+void XXH3_128::final(std::span<uint8_t> out)
+{
+	if (out.size() < HASH_SIZE)
+		return;
+
+	const State& S = state_;
+	if (S.total_len <= MID_SIZE_MAX) {
+		store(out.data(), xxh3_128(S.buffer, S.buffered));
+		return;
+	}
+
+	uint64_t acc[8];
+	std::copy(S.acc, S.acc + 8, acc);
+	const uint8_t* last_stripe_secret = SECRET + SECRET_SIZE - STRIPE_LEN - SECRET_LASTACC_START;
+	if (S.buffered >= STRIPE_LEN) {
+		consume_stripes(acc, S.stripes, S.buffer, (S.buffered - 1) / STRIPE_LEN);
+		accumulate_512(acc, S.buffer + S.buffered - STRIPE_LEN, last_stripe_secret);
+	} else {
+		// Last stripe starts in the previously accumulated input, still at the buffer end.
+		uint8_t last_stripe[STRIPE_LEN];
+		const size_t catchup = STRIPE_LEN - S.buffered;
+		std::copy(S.buffer + BUFFER_SIZE - catchup, S.buffer + BUFFER_SIZE, last_stripe);
+		std::copy(S.buffer, S.buffer + S.buffered, last_stripe + catchup);
+		accumulate_512(acc, last_stripe, last_stripe_secret);
+	}
+	store(out.data(), merge(acc, S.total_len));
+}
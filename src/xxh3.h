@@ -0,0 +1,74 @@
+#ifndef XXH3_H
+#define XXH3_H
+
+#include "IHash.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+/**
+* XXH3 128-bit hash (default secret, seed 0). Output is the canonical form: high
+* 64 bits followed by low 64 bits, both big-endian. Much faster than the BLAKE
+* hashes, but not cryptographic - chunk identity is reliable only for inputs which
+* are not crafted to collide, i.e. in trusted pipelines.
+* Implements IHash interface; one-shot hash() uses its own state, so it can be
+* called while incremental hashing is in progress.
+*/
+class XXH3_128 : public IHash
+{
+public:
+	static constexpr size_t HASH_SIZE = 16;		// Hash size in bytes
+	static constexpr uint8_t ID = 3;			// Strong hash ID recorded in delta header
+	static constexpr const char* NAME = "xxh3-128";
+
+	static constexpr size_t BUFFER_SIZE = 256;	// Input buffered by incremental hashing
+
+	/**
+	* Incremental hashing state.
+	*/
+	struct State {
+		uint64_t acc[8];						// Accumulators
+		uint64_t total_len;						// Bytes passed so far
+		size_t stripes;							// Stripes accumulated in the current block
+		unsigned int buffered;					// Bytes in buffer
+		alignas(64) uint8_t buffer[BUFFER_SIZE];	// Input not accumulated yet (with the last stripe before it)
+	};
+
+	/**
+	* Get hash size in bytes.
+	* @return hash size in bytes.
+	*/
+	size_t get_hash_size() const noexcept override {
+		return HASH_SIZE;
+	}
+
+	/**
+	* Computes hash and stores it in the given buffer.
+	* @param out[out] buffer to store hash (nothing is done if it is too small).
+	* @param in[in] input to be hashed
+	*/
+	void hash(std::span<uint8_t> out, std::span<const uint8_t> in) override;
+
+	/**
+	* Start incremental hashing.
+	*/
+	void init() override;
+
+	/**
+	* Pass next part of the input to the incremental hash.
+	* @param in[in] input to be hashed (may be empty)
+	*/
+	void update(std::span<const uint8_t> in) override;
+
+	/**
+	* Finish incremental hashing and store the hash in the given buffer.
+	* @param out[out] buffer to store hash (nothing is done if it is too small).
+	*/
+	void final(std::span<uint8_t> out) override;
+
+private:
+	State state_{};								// Incremental hashing state
+};
+
+#endif // XXH3_H
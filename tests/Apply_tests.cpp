@@ -2,6 +2,7 @@
 
 #include "Apply.hpp"
 #include "Delta.hpp"
+#include "DeltaHeader.hpp"
 #include "RK_finger.hpp"
 #include "Signature.hpp"
 #include "blake.h"
@@ -16,8 +17,9 @@
 namespace {
 
 // Layout-derived constants so tests don't break silently if the entry
-// header or opcode encoding changes. See writeDeltaEntry / createOptimizedDiff
-// in src/Delta.hpp.
+// header or opcode encoding changes. See writeDeltaHeader / writeDeltaEntry /
+// createOptimizedDiff in src/Delta.hpp.
+//   delta   = file header (DELTA_HEADER_SIZE) | entries...
 //   header  = entry_type:u64 | signature:u64 | hash:hash_size | chunk_size:u64
 //   D-op    = 'D' | pos:u32 BE | count:u8 | count bytes
 inline size_t entry_header_size()
@@ -296,6 +298,75 @@ TEST(Apply, truncated_added_payload_fails)
 	cleanup({OLD, NEW, DELTA, OUT});
 }
 
+TEST(Apply, corrupted_added_payload_fails)
+{
+	const char* OLD = "apply_t_corrupt_pl_old";
+	const char* NEW = "apply_t_corrupt_pl_new";
+	const char* DELTA = "apply_t_corrupt_pl_delta";
+	const char* OUT = "apply_t_corrupt_pl_out";
+
+	// All-ADDED delta with more chunks than are verified in one batch. A flipped byte
+	// in the first payload must fail before anything is written, one in the last
+	// payload only after all preceding chunks were verified and written.
+	write_bytes(OLD, {});
+	write_random(NEW, 256 * 1024, 0xBADC0DEu);
+
+	Signature<RKFinger, BLAKE512> os, ns;
+	os.generate_signatures(OLD);
+	ns.generate_signatures(NEW);
+	ASSERT_GT(ns.get_chunks().size(), 8u);
+	Delta<RKFinger, BLAKE512> d;
+	auto dr = d.generate_delta(os, ns, OLD, NEW, DELTA);
+	ASSERT_TRUE(dr.success);
+	const auto raw = read_all(DELTA);
+	const size_t last_chunk = ns.get_chunks()[ns.get_chunks().size() - 1].chunk_size;
+
+	for (size_t pos : { DELTA_HEADER_SIZE + entry_header_size(), raw.size() - 1 }) {
+		auto corrupted = raw;
+		corrupted[pos] ^= 0x01;
+		write_bytes(DELTA, corrupted);
+
+		Apply<RKFinger, BLAKE512> apply;
+		auto ar = apply.apply_delta(OLD, DELTA, OUT);
+		EXPECT_FALSE(ar.success);
+		EXPECT_EQ(ar.error_message, "ADDED entry hash mismatch");
+		EXPECT_EQ(ar.bytes_written, pos == raw.size() - 1 ? 256 * 1024 - last_chunk : 0);
+	}
+
+	cleanup({OLD, NEW, DELTA, OUT});
+}
+
+TEST(Apply, pending_output_is_bounded)
+{
+	const char* OLD = "apply_t_pending_old";
+	const char* NEW = "apply_t_pending_new";
+	const char* DELTA = "apply_t_pending_delta";
+	const char* OUT = "apply_t_pending_out";
+
+	// One modified chunk near the start: unchanged chunks behind it must not pile
+	// up waiting for more chunks to verify.
+	write_random(OLD, 16 * 1024 * 1024, 0xB0B0u);
+	auto data = read_all(OLD);
+	data[100000] ^= 0x5A;
+	write_bytes(NEW, data);
+
+	Signature<RKFinger, BLAKE512> os, ns;
+	os.generate_signatures(OLD);
+	ns.generate_signatures(NEW);
+	Delta<RKFinger, BLAKE512> d;
+	ASSERT_TRUE(d.generate_delta(os, ns, OLD, NEW, DELTA).success);
+
+	using Applier = Apply<RKFinger, BLAKE512>;
+	Applier apply;
+	auto ar = apply.apply_delta(OLD, DELTA, OUT);
+	ASSERT_TRUE(ar.success) << ar.error_message;
+	EXPECT_EQ(read_all(OUT), data);
+	EXPECT_GT(ar.peak_pending_bytes, 0u);
+	EXPECT_LT(ar.peak_pending_bytes, Applier::MAX_PENDING_BYTES + DefaultChunkingPolicy::MAX_CHUNK_SIZE);
+
+	cleanup({OLD, NEW, DELTA, OUT});
+}
+
 TEST(Apply, truncated_modified_after_header_fails)
 {
 	const char* OLD = "apply_t_modtrunc1_old";
@@ -304,8 +375,8 @@ TEST(Apply, truncated_modified_after_header_fails)
 	const char* OUT = "apply_t_modtrunc1_out";
 
 	// 256 distinct bytes form a single chunk; flipping one byte yields a
-	// MODIFIED entry. Truncating the delta to the first 88 bytes leaves the
-	// entry header with zero opcode bytes; tail-copy from old would otherwise
+	// MODIFIED entry. Truncating the delta right after the first entry header
+	// leaves it with zero opcode bytes; tail-copy from old would otherwise
 	// silently reproduce the old chunk.
 	std::vector<uint8_t> data(256);
 	for (size_t i = 0; i < 256; ++i)
@@ -323,10 +394,10 @@ TEST(Apply, truncated_modified_after_header_fails)
 	auto dr = d.generate_delta(os, ns, OLD, NEW, DELTA);
 	ASSERT_TRUE(dr.success);
 
-	const size_t header_size = entry_header_size();
+	const size_t header_size = DELTA_HEADER_SIZE + entry_header_size();
 	auto raw = read_all(DELTA);
 	ASSERT_GT(raw.size(), header_size);
-	raw.resize(header_size);  // header only, no diff opcodes
+	raw.resize(header_size);  // headers only, no diff opcodes
 	write_bytes(DELTA, raw);
 
 	Apply<RKFinger, BLAKE512> apply;
@@ -365,7 +436,7 @@ TEST(Apply, truncated_modified_at_opcode_boundary_fails)
 	ASSERT_TRUE(dr.success);
 
 	// Truncate after the first 'D' opcode (count=1) but before the second.
-	const size_t cut = entry_header_size() + d_opcode_size(1);
+	const size_t cut = DELTA_HEADER_SIZE + entry_header_size() + d_opcode_size(1);
 	auto raw = read_all(DELTA);
 	ASSERT_GT(raw.size(), cut);
 	raw.resize(cut);
@@ -503,3 +574,121 @@ TEST(Apply, truncated_partial_header_fails)
 
 	cleanup({OLD, NEW, DELTA, OUT});
 }
+
+TEST(Apply, stream_delta_matches_file_delta)
+{
+	const char* OLD = "apply_t_stream_old";
+	const char* NEW = "apply_t_stream_new";
+	const char* DELTA_FILE = "apply_t_stream_delta_file";
+	const char* DELTA_STREAM = "apply_t_stream_delta_stream";
+	const char* OUT = "apply_t_stream_out";
+
+	write_random(OLD, 700000, 0x57EAu);
+	auto data = read_all(OLD);
+	data.insert(data.begin() + 100000, 333, 0x11);
+	data[400000] ^= 0xFF;
+	data.erase(data.begin() + 600000, data.begin() + 620000);
+	write_bytes(NEW, data);
+
+	Signature<RKFinger, BLAKE512> old_sig, new_sig;
+	old_sig.generate_signatures(OLD);
+	new_sig.generate_signatures(NEW);
+	Delta<RKFinger, BLAKE512> delta;
+	ASSERT_TRUE(delta.generate_delta(old_sig, new_sig, OLD, NEW, DELTA_FILE).success);
+
+	for (unsigned int threads : { 1u, 2u }) {
+		FileIO input;
+		ASSERT_TRUE(input.open(NEW, FileMode::IN));
+		Signature<RKFinger, BLAKE512> chunker;
+		chunker.set_threads(threads);
+		auto dr = delta.generate_delta_stream(old_sig, chunker, input, OLD, DELTA_STREAM);
+		ASSERT_TRUE(dr.success) << dr.error_message;
+		EXPECT_TRUE(chunker.get_chunks().empty());
+		EXPECT_EQ(read_all(DELTA_FILE), read_all(DELTA_STREAM)) << "threads " << threads;
+	}
+
+	Apply<RKFinger, BLAKE512> apply;
+	auto ar = apply.apply_delta(OLD, DELTA_STREAM, OUT);
+	ASSERT_TRUE(ar.success) << ar.error_message;
+	EXPECT_EQ(read_all(NEW), read_all(OUT));
+
+	cleanup({OLD, NEW, DELTA_FILE, DELTA_STREAM, OUT});
+}
+
+TEST(Apply, delta_stats_account_every_byte)
+{
+	const char* OLD = "apply_t_stats_old";
+	const char* NEW = "apply_t_stats_new";
+	const char* DELTA = "apply_t_stats_delta";
+
+	write_random(OLD, 300000, 0x5747u);
+	auto data = read_all(OLD);
+	const size_t old_size = data.size();
+	data.resize(200000);
+	data.resize(250000, 0x42);
+	write_bytes(NEW, data);
+
+	Signature<RKFinger, BLAKE512> old_sig, new_sig;
+	old_sig.generate_signatures(OLD);
+	new_sig.generate_signatures(NEW);
+	Delta<RKFinger, BLAKE512> delta;
+	auto dr = delta.generate_delta(old_sig, new_sig, OLD, NEW, DELTA);
+	ASSERT_TRUE(dr.success) << dr.error_message;
+
+	const auto& stats = dr.stats;
+	EXPECT_EQ(stats.new_bytes(), data.size());
+	EXPECT_EQ(stats.original_chunks + stats.modified_chunks + stats.added_chunks + stats.removed_chunks,
+	          dr.chunks_processed);
+	EXPECT_EQ(stats.original_chunks + stats.modified_chunks + stats.removed_chunks, old_sig.get_chunks().size());
+	EXPECT_GT(stats.matched_ratio(), 0.5);
+	EXPECT_LT(stats.matched_ratio(), 1.0);
+	EXPECT_LT(stats.payload_bytes, dr.bytes_written);
+
+	// Identical files are fully matched without payload.
+	dr = delta.generate_delta(old_sig, old_sig, OLD, OLD, DELTA);
+	ASSERT_TRUE(dr.success) << dr.error_message;
+	EXPECT_EQ(dr.stats.original_bytes, old_size);
+	EXPECT_EQ(dr.stats.matched_ratio(), 1.0);
+	EXPECT_EQ(dr.stats.payload_bytes, 0u);
+
+	cleanup({OLD, NEW, DELTA});
+}
+
+TEST(Apply, super_chunk_matching_roundtrip)
+{
+	const char* OLD = "apply_t_super_old";
+	const char* NEW = "apply_t_super_new";
+	const char* DELTA = "apply_t_super_delta";
+	const char* OUT = "apply_t_super_out";
+
+	write_random(OLD, 3 * 1024 * 1024, 0x5ACEu);
+	auto data = read_all(OLD);
+	data.insert(data.begin() + 700000, 4000, 0x21);
+	data[1800000] ^= 0xFF;
+	data.erase(data.begin() + 2500000, data.begin() + 2540000);
+	write_bytes(NEW, data);
+
+	Signature<RKFinger, BLAKE512> old_sig, new_sig;
+	old_sig.generate_signatures(OLD);
+	new_sig.generate_signatures(NEW);
+
+	Delta<RKFinger, BLAKE512> delta;
+	auto flat = delta.generate_delta(old_sig, new_sig, OLD, NEW, DELTA);
+	ASSERT_TRUE(flat.success) << flat.error_message;
+	EXPECT_EQ(flat.stats.matched_super_chunks, 0u);
+
+	delta.set_super_chunk_threshold(0);
+	auto dr = delta.generate_delta(old_sig, new_sig, OLD, NEW, DELTA);
+	ASSERT_TRUE(dr.success) << dr.error_message;
+	EXPECT_GT(dr.stats.matched_super_chunks, 0u);
+	EXPECT_LT(dr.stats.indexed_chunks, old_sig.get_chunks().size() / 4);
+	EXPECT_EQ(dr.stats.new_bytes(), data.size());
+	EXPECT_GE(dr.stats.original_bytes, flat.stats.original_bytes);
+
+	Apply<RKFinger, BLAKE512> apply;
+	auto ar = apply.apply_delta(OLD, DELTA, OUT);
+	ASSERT_TRUE(ar.success) << ar.error_message;
+	EXPECT_EQ(read_all(NEW), read_all(OUT));
+
+	cleanup({OLD, NEW, DELTA, OUT});
+}
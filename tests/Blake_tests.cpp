@@ -1,4 +1,7 @@
 #include <limits.h>
+#include <array>
+#include <random>
+#include <span>
 #include <vector>
 #include "gtest/gtest.h"
 
@@ -36,4 +39,148 @@ TEST(blake512, hash)
 	
 	for (int i = 0; i < 64; i++)
 		ASSERT_EQ(hash_result[i], hash_pattern[i]);
-}
\ No newline at end of file
+}
+
+TEST(blake512, incremental_matches_one_shot)
+{
+	std::mt19937 rng(0xB1A4u);
+	std::vector<uint8_t> data(1000);
+	for (auto& b : data)
+		b = static_cast<uint8_t>(rng());
+
+	BLAKE512 hash;
+	std::array<uint8_t, 64> expected, result;
+
+	// Sizes around padding (111, 112) and block (128) boundaries, split at every kind of offset.
+	for (size_t size : { 0, 1, 92, 110, 111, 112, 127, 128, 129, 255, 256, 257, 1000 }) {
+		const std::span<const uint8_t> input(data.data(), size);
+		hash.hash(expected, input);
+		for (size_t split : { size_t(0), size / 3, size / 2, size }) {
+			hash.init();
+			hash.update(input.first(split));
+			hash.update({});
+			hash.update(input.subspan(split));
+			hash.final(result);
+			ASSERT_EQ(result, expected) << "size " << size << " split " << split;
+		}
+	}
+}
+
+TEST(blake512, incremental_byte_at_a_time)
+{
+	uint8_t test_vector[92];
+	for (unsigned int i = 0; i < 92; i++)
+		test_vector[i] = i;
+
+	BLAKE512 hash;
+	std::array<uint8_t, 64> expected, result;
+	hash.hash(expected, test_vector);
+
+	hash.init();
+	for (uint8_t byte : test_vector) {
+		hash.update(std::span<const uint8_t>(&byte, 1));
+		std::array<uint8_t, 64> unrelated;
+		hash.hash(unrelated, test_vector);				// One-shot hash does not disturb incremental state
+	}
+	hash.final(result);
+	EXPECT_EQ(result, expected);
+}
+
+TEST(blake512, final_small_buffer)
+{
+	BLAKE512 hash;
+	std::array<uint8_t, 32> small{};
+
+	hash.init();
+	hash.final(small);										// Should not crash or write
+	EXPECT_EQ(small, (std::array<uint8_t, 32>{}));
+}
+
+TEST(blake512, isa_names)
+{
+	EXPECT_STREQ(blake512_isa_name(BlakeIsa::SCALAR), "scalar");
+	EXPECT_STREQ(blake512_isa_name(BlakeIsa::AVX2), "avx2");
+	EXPECT_EQ(BLAKE512().get_isa(), blake512_best_isa());
+	EXPECT_EQ(BLAKE512(BlakeIsa::SCALAR).get_isa(), BlakeIsa::SCALAR);
+}
+
+TEST(blake512, compress_implementations_match)
+{
+	// Every supported implementation against the reference one - lengths cover
+	// blocks of padding only (the counter is not xored then) and multi-block input.
+	std::mt19937 rng(0xB1A5u);
+	std::vector<uint8_t> data(4096 + 300);
+	for (auto& b : data)
+		b = static_cast<uint8_t>(rng());
+
+	BLAKE512 reference(BlakeIsa::SCALAR);
+	for (BlakeIsa isa : { BlakeIsa::SCALAR, BlakeIsa::AVX2 }) {
+		if (isa > blake512_best_isa())
+			continue;
+		BLAKE512 hash(isa);
+		std::array<uint8_t, 64> expected, result;
+		for (size_t size = 0; size <= data.size(); size += (size < 300 ? 1 : 997)) {
+			const std::span<const uint8_t> input(data.data(), size);
+			reference.hash(expected, input);
+			hash.hash(result, input);
+			ASSERT_EQ(result, expected) << blake512_isa_name(isa) << " size " << size;
+
+			hash.init();
+			hash.update(input.first(size / 2));
+			hash.update(input.subspan(size / 2));
+			hash.final(result);
+			ASSERT_EQ(result, expected) << blake512_isa_name(isa) << " incremental size " << size;
+		}
+	}
+}
+
+TEST(blake512, hash_many_matches_hash)
+{
+	// Unequal lengths (every padding case, empty input, multi-block) so that lanes finish
+	// at different blocks and take over the next input; batch sizes below and above LANES.
+	std::mt19937 rng(0x3A17u);
+	std::vector<uint8_t> data(8192 + 300 + 8);					// inputs start at offset < 8
+	for (auto& b : data)
+		b = static_cast<uint8_t>(rng());
+
+	BLAKE512 reference(BlakeIsa::SCALAR);
+	for (BlakeIsa isa : { BlakeIsa::SCALAR, BlakeIsa::AVX2 }) {
+		if (isa > blake512_best_isa())
+			continue;
+		BLAKE512 hash(isa);
+		for (size_t count : { size_t(0), size_t(1), size_t(2), size_t(4), size_t(7), size_t(300) }) {
+			std::vector<std::span<const uint8_t>> inputs;
+			for (size_t i = 0; i < count; i++) {
+				const size_t size = i % 5 == 4 ? 8192 + rng() % 300 : rng() % 300;
+				inputs.push_back(std::span<const uint8_t>(data).subspan(rng() % 8, size));
+			}
+			std::vector<std::array<uint8_t, 64>> results(count);
+			std::vector<std::span<uint8_t>> outputs(results.begin(), results.end());
+			hash.hash_many(inputs, outputs);
+
+			std::array<uint8_t, 64> expected;
+			for (size_t i = 0; i < count; i++) {
+				reference.hash(expected, inputs[i]);
+				ASSERT_EQ(results[i], expected) << blake512_isa_name(isa) << " input " << i << " of " << count
+				                                << ", size " << inputs[i].size();
+			}
+		}
+	}
+}
+
+TEST(blake512, hash_many_small_output)
+{
+	// Outputs shorter than the hash are skipped, the other ones are still computed.
+	const std::array<uint8_t, 3> data{ 'a', 'b', 'c' };
+	std::array<uint8_t, 64> expected, first{}, third{};
+	std::array<uint8_t, 8> small{};
+	BLAKE512 hash;
+	hash.hash(expected, data);
+
+	const std::span<const uint8_t> inputs[3] = { data, data, data };
+	const std::span<uint8_t> outputs[3] = { first, small, third };
+	hash.hash_many(inputs, outputs);
+	EXPECT_EQ(first, expected);
+	EXPECT_EQ(third, expected);
+	EXPECT_EQ(small, (std::array<uint8_t, 8>{}));
+}
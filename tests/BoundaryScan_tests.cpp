@@ -0,0 +1,68 @@
+#include "gtest/gtest.h"
+
+#include "BoundaryScan.hpp"
+
+#include <random>
+#include <vector>
+
+namespace {
+
+std::vector<uint32_t> scan_all(const std::vector<uint8_t>& data, size_t from, uint16_t mask, BoundaryScanIsa isa)
+{
+	std::vector<uint32_t> all;
+	std::vector<uint32_t> positions(7);							// small buffer to exercise resuming
+	while (true) {
+		size_t found = find_boundary_candidates(data, from, mask, positions, isa);
+		all.insert(all.end(), positions.begin(), positions.begin() + found);
+		if (found < positions.size())
+			break;
+		from = positions[found - 1] + 1;
+	}
+	return all;
+}
+
+std::vector<uint32_t> reference(const std::vector<uint8_t>& data, size_t from, uint16_t mask)
+{
+	std::vector<uint32_t> out;
+	for (size_t i = std::max<size_t>(from, 1); i < data.size(); ++i)
+		if (((data[i - 1] << 8 | data[i]) & mask) == 0)
+			out.push_back(static_cast<uint32_t>(i));
+	return out;
+}
+
+} // namespace
+
+TEST(BoundaryScan, best_isa_has_name)
+{
+	EXPECT_STRNE(boundary_scan_isa_name(boundary_scan_best_isa()), "unknown");
+}
+
+TEST(BoundaryScan, kernels_match_reference)
+{
+	std::vector<uint8_t> data(70000);
+	std::mt19937 rng(0x5CA7u);
+	std::uniform_int_distribution<int> dist(0, 255);
+	for (auto& b : data)
+		b = static_cast<uint8_t>(dist(rng));
+	// Low-entropy region where nearly every position is a candidate
+	std::fill(data.begin() + 30000, data.begin() + 30100, 0);
+
+	for (int isa = 0; isa <= static_cast<int>(boundary_scan_best_isa()); ++isa) {
+		for (uint16_t mask : {0x1FF, 0x7FF, 0x1FFF, 0x3F, 0xFFFF}) {
+			for (size_t from : {0u, 1u, 511u, 69990u}) {
+				EXPECT_EQ(scan_all(data, from, mask, static_cast<BoundaryScanIsa>(isa)), reference(data, from, mask))
+					<< boundary_scan_isa_name(static_cast<BoundaryScanIsa>(isa)) << " mask " << mask << " from " << from;
+			}
+		}
+	}
+}
+
+TEST(BoundaryScan, empty_input)
+{
+	std::vector<uint8_t> data;
+	std::vector<uint32_t> positions(4);
+
+	EXPECT_EQ(find_boundary_candidates(data, 0, 0x1FF, positions), 0u);
+	data.push_back(0);
+	EXPECT_EQ(find_boundary_candidates(data, 0, 0x1FF, positions), 0u);		// no previous byte
+}
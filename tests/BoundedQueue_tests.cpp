@@ -0,0 +1,65 @@
+#include "gtest/gtest.h"
+
+#include "BoundedQueue.hpp"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+TEST(BoundedQueue, capacity_rounded_up)
+{
+	BoundedQueue<int> queue(100);
+
+	EXPECT_EQ(queue.capacity(), 128u);
+}
+
+TEST(BoundedQueue, fifo_and_full)
+{
+	BoundedQueue<int> queue(4);
+	int value = 0;
+
+	EXPECT_FALSE(queue.try_pop(value));
+	for (int i = 0; i < 4; i++)
+		EXPECT_TRUE(queue.try_push(i));
+	EXPECT_FALSE(queue.try_push(4));							// queue is full
+
+	for (int i = 0; i < 4; i++) {
+		ASSERT_TRUE(queue.try_pop(value));
+		EXPECT_EQ(value, i);
+	}
+	EXPECT_FALSE(queue.try_pop(value));
+}
+
+TEST(BoundedQueue, concurrent_producers_consumers)
+{
+	constexpr int PER_PRODUCER = 100000;
+	BoundedQueue<int> queue(64);
+	std::atomic<long long> sum{ 0 };
+	std::atomic<int> consumed{ 0 };
+	std::vector<std::thread> threads;
+
+	for (int p = 0; p < 2; p++) {
+		threads.emplace_back([&] {
+			for (int i = 1; i <= PER_PRODUCER; i++)
+				while (!queue.try_push(i))
+					std::this_thread::yield();
+		});
+	}
+	for (int c = 0; c < 2; c++) {
+		threads.emplace_back([&] {
+			int value;
+			while (consumed.load() < 2 * PER_PRODUCER) {
+				if (queue.try_pop(value)) {
+					sum += value;
+					consumed++;
+				} else {
+					std::this_thread::yield();
+				}
+			}
+		});
+	}
+	for (auto& t : threads)
+		t.join();
+
+	EXPECT_EQ(sum.load(), 2LL * PER_PRODUCER * (PER_PRODUCER + 1) / 2);
+}
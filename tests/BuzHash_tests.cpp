@@ -0,0 +1,78 @@
+#include "gtest/gtest.h"
+
+#include "BuzHash.hpp"
+#include "TestFiles.hpp"
+
+#include <bit>
+#include <vector>
+
+namespace {
+
+// Cyclic polynomial hash of the window computed directly from the definition.
+uint64_t reference_hash(std::span<const uint8_t> window)
+{
+	uint64_t value = 0;
+	for (size_t i = 0; i < window.size(); ++i)
+		value ^= std::rotl(BuzHash::table_value(window[i]), static_cast<int>((window.size() - 1 - i) % 64));
+	return value;
+}
+
+} // namespace
+
+TEST(BuzHash, initialize_correct)
+{
+	BuzHash buz;
+
+	std::vector<uint8_t> init(48, 0xBE);
+	EXPECT_EQ(buz.initialize(init), true);
+	EXPECT_EQ(buz.get_current_fingerprint(), reference_hash(init));
+}
+
+TEST(BuzHash, initialize_incorrect)
+{
+	BuzHash buz;
+
+	std::vector<uint8_t> init(47, 0xBE);					// Less than window size
+	EXPECT_EQ(buz.initialize(init), false);
+}
+
+TEST(BuzHash, rolling_window)
+{
+	// Value depends only on the last window_size bytes and matches the definition.
+	auto data = random_bytes(4096, 0xB021u);
+	for (unsigned int window : { 1u, 16u, 48u, 64u }) {
+		BuzHash rolled(window), direct(window);
+		EXPECT_EQ(rolled.get_window_size(), window);
+
+		rolled.initialize(std::span<const uint8_t>(data).first(window));
+		for (size_t i = window; i < data.size(); ++i) {
+			const uint64_t value = rolled.compute_next(data[i]);
+			if (i % 511 == 0) {
+				ASSERT_EQ(value, reference_hash(std::span<const uint8_t>(data).subspan(i + 1 - window, window))) << "window " << window;
+			}
+		}
+
+		direct.initialize(std::span<const uint8_t>(data).last(window));
+		EXPECT_EQ(rolled.get_current_fingerprint(), direct.get_current_fingerprint());
+	}
+}
+
+TEST(BuzHash, roll_matches_compute_next)
+{
+	auto data = random_bytes(4096, 0xB023u);
+	BuzHash single, batch;
+	single.initialize(data);
+	batch.initialize(data);
+
+	std::vector<size_t> expected;
+	for (size_t i = WINDOW_DEF_SIZE; i < data.size(); ++i) {
+		if ((single.compute_next(data[i]) & 15) == 0)
+			expected.push_back(i + 1 - WINDOW_DEF_SIZE);
+	}
+
+	std::vector<size_t> positions;
+	batch.roll(std::span<const uint8_t>(data).subspan(WINDOW_DEF_SIZE), [](uint64_t value) { return (value & 15) == 0; }, positions);
+	EXPECT_EQ(positions, expected);
+	EXPECT_EQ(batch.get_current_fingerprint(), single.get_current_fingerprint());
+	EXPECT_EQ(batch.compute_next(0x42), single.compute_next(0x42));
+}
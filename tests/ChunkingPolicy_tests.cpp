@@ -0,0 +1,253 @@
+#include "gtest/gtest.h"
+
+#include "Apply.hpp"
+#include "BuzHash.hpp"
+#include "ChunkingPolicy.hpp"
+#include "Delta.hpp"
+#include "DeltaHeader.hpp"
+#include "MersenneRKFinger.hpp"
+#include "RK_finger.hpp"
+#include "RabinFinger.hpp"
+#include "Signature.hpp"
+#include "TestFiles.hpp"
+#include "blake.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+
+template <class P>
+void check_chunk_sizes(const char* path)
+{
+	Signature<RKFinger, BLAKE512, P> signatures;
+	signatures.generate_signatures(path);
+	const auto& chunks = signatures.get_chunks();
+
+	ASSERT_GT(chunks.size(), 1u);
+	for (size_t i = 0; i + 1 < chunks.size(); ++i) {
+		EXPECT_GE(chunks[i].chunk_size, P::MIN_CHUNK_SIZE);
+		EXPECT_LE(chunks[i].chunk_size, P::MAX_CHUNK_SIZE);
+	}
+}
+
+template <class P>
+size_t chunk_count(const char* path)
+{
+	Signature<RKFinger, BLAKE512, P> signatures;
+	signatures.generate_signatures(path);
+	return signatures.get_chunks().size();
+}
+
+// Log-like text: no two-byte boundaries, but windowed fingerprints vary.
+std::vector<uint8_t> log_text(size_t size)
+{
+	std::string text;
+	for (unsigned int line = 0; text.size() < size; line++)
+		text += "12:00:" + std::to_string(line % 60) + " worker-" + std::to_string(line * 7 % 13) +
+		        " request " + std::to_string(100000 + line) + " done\n";
+	return std::vector<uint8_t>(text.begin(), text.end());
+}
+
+// Fingerprint boundaries of a windowed rolling hash are placed by the hash itself: every
+// chunk ends at the first size >= MIN_CHUNK_SIZE where its value over the preceding
+// window matches the mask (or is cut at MAX_CHUNK_SIZE).
+template <class T>
+void check_windowed_boundaries(const std::vector<uint8_t>& data, const char* path)
+{
+	using P = DefaultFingerprintChunkingPolicy;
+	Signature<T, BLAKE512, P> signatures;
+	signatures.generate_signatures(path);
+	const auto& chunks = signatures.get_chunks();
+	ASSERT_GT(chunks.size(), 10u);
+
+	T finger;
+	const size_t window = finger.get_window_size();
+	auto value_at = [&](size_t end) {
+		finger.initialize(std::span<const uint8_t>(data).subspan(end - window, window));
+		return finger.get_current_fingerprint();
+	};
+
+	for (size_t i = 0; i + 1 < chunks.size(); ++i) {
+		const size_t start = chunks[i].start_offset, size = chunks[i].chunk_size;
+		EXPECT_EQ(chunks[i].signature, value_at(start + size));
+		for (size_t s = P::MIN_CHUNK_SIZE; s < size; s++)
+			ASSERT_NE(value_at(start + s) & P::mask_for(s), 0u) << "chunk " << i << " size " << s;
+		if (size < P::MAX_CHUNK_SIZE) {
+			EXPECT_EQ(value_at(start + size) & P::mask_for(size), 0u) << "chunk " << i;
+		}
+	}
+}
+
+} // namespace
+
+TEST(ChunkingPolicy, default_matches_original_constants)
+{
+	EXPECT_EQ(DefaultChunkingPolicy::MIN_CHUNK_SIZE, 512u);
+	EXPECT_EQ(DefaultChunkingPolicy::MAX_CHUNK_SIZE, 16384u);
+	EXPECT_EQ(DefaultChunkingPolicy::mask_for(512), 0x1FFu);
+	EXPECT_EQ(DefaultChunkingPolicy::mask_for(2048), 0x7FFu);
+	EXPECT_EQ(DefaultChunkingPolicy::mask_for(4096), 0x1FFFu);
+}
+
+TEST(ChunkingPolicy, names)
+{
+	uint8_t id = 0;
+
+	EXPECT_TRUE(chunking_policy_from_name("large", id));
+	EXPECT_EQ(id, LargeChunkingPolicy::ID);
+	EXPECT_STREQ(chunking_policy_name(id), "large");
+	EXPECT_TRUE(chunking_policy_from_name("default-fp", id));
+	EXPECT_EQ(id, DefaultFingerprintChunkingPolicy::ID);
+	EXPECT_NE(id, DefaultChunkingPolicy::ID);
+	EXPECT_STREQ(chunking_policy_name(id), "default-fp");
+	EXPECT_FALSE(chunking_policy_from_name("huge", id));
+	EXPECT_STREQ(chunking_policy_name(0), "unknown");
+}
+
+TEST(ChunkingPolicy, chunk_sizes_follow_policy)
+{
+	const char* FILE_NAME = "policy_t_sizes";
+	write_bytes(FILE_NAME, random_bytes(1024 * 1024, 0x9011u));
+
+	check_chunk_sizes<SmallChunkingPolicy>(FILE_NAME);
+	check_chunk_sizes<DefaultChunkingPolicy>(FILE_NAME);
+	check_chunk_sizes<LargeChunkingPolicy>(FILE_NAME);
+	check_chunk_sizes<SmallFingerprintChunkingPolicy>(FILE_NAME);
+	check_chunk_sizes<DefaultFingerprintChunkingPolicy>(FILE_NAME);
+	check_chunk_sizes<LargeFingerprintChunkingPolicy>(FILE_NAME);
+
+	EXPECT_GT(chunk_count<SmallChunkingPolicy>(FILE_NAME), chunk_count<DefaultChunkingPolicy>(FILE_NAME));
+	EXPECT_GT(chunk_count<DefaultChunkingPolicy>(FILE_NAME), chunk_count<LargeChunkingPolicy>(FILE_NAME));
+
+	std::remove(FILE_NAME);
+}
+
+TEST(ChunkingPolicy, delta_records_policy)
+{
+	const char* OLD = "policy_t_record_old";
+	const char* NEW = "policy_t_record_new";
+	const char* DELTA = "policy_t_record_delta";
+	const char* OUT = "policy_t_record_out";
+
+	write_bytes(OLD, random_bytes(300000, 0x11u));
+	auto data = read_all(OLD);
+	data[150000] ^= 0x5A;
+	write_bytes(NEW, data);
+
+	Signature<RKFinger, BLAKE512, LargeChunkingPolicy> os, ns;
+	os.generate_signatures(OLD);
+	ns.generate_signatures(NEW);
+	Delta<RKFinger, BLAKE512, LargeChunkingPolicy> d;
+	ASSERT_TRUE(d.generate_delta(os, ns, OLD, NEW, DELTA).success);
+
+	DeltaHeader header;
+	ASSERT_TRUE(read_delta_header(DELTA, header));
+	EXPECT_EQ(header.version, DELTA_FORMAT_VERSION);
+	EXPECT_EQ(header.chunking_policy, LargeChunkingPolicy::ID);
+
+	// Applying with a different policy would regenerate different old chunks.
+	Apply<RKFinger, BLAKE512> wrong;
+	EXPECT_FALSE(wrong.apply_delta(OLD, DELTA, OUT).success);
+
+	Apply<RKFinger, BLAKE512, LargeChunkingPolicy> apply;
+	auto ar = apply.apply_delta(OLD, DELTA, OUT);
+	ASSERT_TRUE(ar.success) << ar.error_message;
+	EXPECT_EQ(read_all(NEW), read_all(OUT));
+
+	for (const auto* p : {OLD, NEW, DELTA, OUT})
+		std::remove(p);
+}
+
+TEST(ChunkingPolicy, legacy_delta_without_header)
+{
+	const char* OLD = "policy_t_legacy_old";
+	const char* NEW = "policy_t_legacy_new";
+	const char* DELTA = "policy_t_legacy_delta";
+	const char* OUT = "policy_t_legacy_out";
+
+	write_bytes(OLD, random_bytes(100000, 0x22u));
+	auto data = read_all(OLD);
+	data.insert(data.begin() + 5000, 10, 0x42);
+	write_bytes(NEW, data);
+
+	Signature<RKFinger, BLAKE512> os, ns;
+	os.generate_signatures(OLD);
+	ns.generate_signatures(NEW);
+	Delta<RKFinger, BLAKE512> d;
+	ASSERT_TRUE(d.generate_delta(os, ns, OLD, NEW, DELTA).success);
+
+	// Strip the header to get the pre-header format.
+	auto raw = read_all(DELTA);
+	write_bytes(DELTA, std::vector<uint8_t>(raw.begin() + DELTA_HEADER_SIZE, raw.end()));
+
+	DeltaHeader header;
+	ASSERT_TRUE(read_delta_header(DELTA, header));
+	EXPECT_EQ(header.version, 0);
+	EXPECT_EQ(header.chunking_policy, DefaultChunkingPolicy::ID);
+
+	Apply<RKFinger, BLAKE512> apply;
+	auto ar = apply.apply_delta(OLD, DELTA, OUT);
+	ASSERT_TRUE(ar.success) << ar.error_message;
+	EXPECT_EQ(read_all(NEW), read_all(OUT));
+
+	for (const auto* p : {OLD, NEW, DELTA, OUT})
+		std::remove(p);
+}
+
+TEST(ChunkingPolicy, fingerprint_boundaries_on_low_entropy_data)
+{
+	const char* OLD = "policy_t_fp_old";
+	const char* NEW = "policy_t_fp_new";
+	const char* DELTA = "policy_t_fp_delta";
+	const char* OUT = "policy_t_fp_out";
+
+	auto data = log_text(600000);
+	write_bytes(OLD, data);
+	data.insert(data.begin() + 300000, 100, '#');
+	write_bytes(NEW, data);
+
+	Signature<RKFinger, BLAKE512> two_byte;
+	two_byte.generate_signatures(OLD);
+	EXPECT_EQ(two_byte.get_stats().forced_cuts + 1, two_byte.get_stats().chunk_count);
+
+	Signature<RKFinger, BLAKE512, DefaultFingerprintChunkingPolicy> os, ns;
+	os.generate_signatures(OLD);
+	ns.generate_signatures(NEW);
+	EXPECT_LT(os.get_stats().forced_cuts * 10, os.get_stats().chunk_count);
+	for (size_t i = 0; i + 1 < os.get_chunks().size(); ++i)
+		EXPECT_GE(os.get_chunks()[i].chunk_size, DefaultFingerprintChunkingPolicy::MIN_CHUNK_SIZE);
+
+	// Boundaries resynchronize after the insertion.
+	Delta<RKFinger, BLAKE512, DefaultFingerprintChunkingPolicy> d;
+	d.set_super_chunk_threshold(0);
+	auto dr = d.generate_delta(os, ns, OLD, NEW, DELTA);
+	ASSERT_TRUE(dr.success) << dr.error_message;
+	EXPECT_GT(dr.stats.matched_ratio(), 0.95);
+
+	DeltaHeader header;
+	ASSERT_TRUE(read_delta_header(DELTA, header));
+	EXPECT_EQ(header.chunking_policy, DefaultFingerprintChunkingPolicy::ID);
+
+	Apply<RKFinger, BLAKE512, DefaultFingerprintChunkingPolicy> apply;
+	auto ar = apply.apply_delta(OLD, DELTA, OUT);
+	ASSERT_TRUE(ar.success) << ar.error_message;
+	EXPECT_EQ(read_all(NEW), read_all(OUT));
+
+	for (const auto* p : {OLD, NEW, DELTA, OUT})
+		std::remove(p);
+}
+
+TEST(ChunkingPolicy, fingerprint_boundaries_use_windowed_hash)
+{
+	const char* FILE_NAME = "policy_t_fp_windowed";
+	const auto data = log_text(300000);
+	write_bytes(FILE_NAME, data);
+
+	check_windowed_boundaries<MersenneRKFinger>(data, FILE_NAME);
+	check_windowed_boundaries<BuzHash>(data, FILE_NAME);
+	check_windowed_boundaries<RabinFinger>(data, FILE_NAME);
+
+	std::remove(FILE_NAME);
+}
@@ -0,0 +1,87 @@
+#include "gtest/gtest.h"
+
+#include "ByteCompare.hpp"
+#include "CpuDispatch.hpp"
+
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+int scalar_kernel() { return 0; }
+int sse2_kernel() { return 1; }
+int avx2_kernel() { return 2; }
+
+using Kernel = int (*)();
+
+constexpr IsaKernel<Kernel> KERNELS[] = {
+	{ CpuIsa::AVX2, avx2_kernel },
+	{ CpuIsa::SSE2, sse2_kernel },
+	{ CpuIsa::SCALAR, scalar_kernel },
+};
+
+size_t reference_prefix(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b)
+{
+	size_t i = 0;
+	while (i < a.size() && i < b.size() && a[i] == b[i])
+		i++;
+	return i;
+}
+
+} // namespace
+
+TEST(CpuDispatch, isa_names)
+{
+	for (CpuIsa isa : { CpuIsa::SCALAR, CpuIsa::SSE2, CpuIsa::AVX2, CpuIsa::AVX512 }) {
+		CpuIsa parsed = CpuIsa::SCALAR;
+		ASSERT_TRUE(cpu_isa_from_name(cpu_isa_name(isa), parsed));
+		EXPECT_EQ(parsed, isa);
+	}
+	CpuIsa parsed;
+	EXPECT_FALSE(cpu_isa_from_name("neon", parsed));
+}
+
+TEST(CpuDispatch, best_isa_respects_override)
+{
+	EXPECT_LE(cpu_best_isa(), cpu_detected_isa());
+
+	CpuIsa forced;
+	if (const char* value = std::getenv(FORCE_ISA_ENV); value && cpu_isa_from_name(value, forced))
+		EXPECT_LE(cpu_best_isa(), forced);
+	else
+		EXPECT_EQ(cpu_best_isa(), cpu_detected_isa());
+}
+
+TEST(CpuDispatch, select_kernel_picks_best_runnable)
+{
+	EXPECT_EQ(select_kernel(KERNELS, CpuIsa::SCALAR).fn(), 0);
+	EXPECT_EQ(select_kernel(KERNELS, CpuIsa::SSE2).fn(), 1);
+	EXPECT_EQ(select_kernel(KERNELS, CpuIsa::AVX2).fn(), 2);
+	EXPECT_EQ(select_kernel(KERNELS, CpuIsa::AVX512).isa, CpuIsa::AVX2);
+}
+
+TEST(ByteCompare, kernels_match_reference)
+{
+	std::mt19937 rng(0xC0DEu);
+	std::vector<uint8_t> a(1000);
+	for (auto& byte : a)
+		byte = static_cast<uint8_t>(rng());
+
+	for (int isa = 0; isa <= static_cast<int>(cpu_detected_isa()); ++isa) {
+		for (size_t size : { 0, 1, 15, 16, 17, 63, 64, 65, 200, 1000 }) {
+			const std::vector<uint8_t> first(a.begin(), a.begin() + size);
+			// Mismatch at every position of the buffer, and none.
+			for (size_t at = 0; at <= size; ++at) {
+				std::vector<uint8_t> second = first;
+				if (at < size)
+					second[at] ^= 0x01;
+				second.push_back(0x42);							// longer buffer does not matter
+				ASSERT_EQ(common_prefix_length(first, second, static_cast<ByteCompareIsa>(isa)),
+				          reference_prefix(first, second))
+					<< cpu_isa_name(static_cast<CpuIsa>(isa)) << " size " << size << " mismatch " << at;
+			}
+		}
+	}
+	EXPECT_EQ(common_prefix_length(a, a), a.size());
+}
@@ -0,0 +1,99 @@
+#include "gtest/gtest.h"
+
+#include "GearHash.hpp"
+#include "Signature.hpp"
+#include "blake.h"
+#include "TestFiles.hpp"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+TEST(GearHash, initialize_correct)
+{
+	GearHash gear;
+
+	std::vector<uint8_t> init(64, 0xBE);
+	EXPECT_EQ(gear.initialize(init), true);
+}
+
+TEST(GearHash, initialize_incorrect)
+{
+	GearHash gear;
+
+	std::vector<uint8_t> init(63, 0xBE);					// Less than window size
+	EXPECT_EQ(gear.initialize(init), false);
+}
+
+TEST(GearHash, rolling_window)
+{
+	// Hash depends only on the last window_size bytes: rolling over new data
+	// must give the same value as initializing with that data directly.
+	auto data = random_bytes(256, 0x6EA2u);
+	GearHash rolled, direct;
+
+	rolled.initialize(std::span<const uint8_t>(data).first(64));
+	for (size_t i = 64; i < data.size(); ++i)
+		rolled.compute_next(data[i]);
+
+	direct.initialize(std::span<const uint8_t>(data).last(64));
+	EXPECT_EQ(rolled.get_current_fingerprint(), direct.get_current_fingerprint());
+}
+
+TEST(GearHash, roll_matches_compute_next)
+{
+	auto data = random_bytes(4096, 0x5013u);
+	GearHash single, batch;
+	single.initialize(data);
+	batch.initialize(data);
+
+	std::vector<size_t> expected;
+	for (size_t i = 64; i < data.size(); ++i) {
+		if ((single.compute_next(data[i]) >> 60) == 0)
+			expected.push_back(i + 1 - 64);
+	}
+
+	std::vector<size_t> positions;
+	batch.roll(std::span<const uint8_t>(data).subspan(64), [](uint64_t value) { return (value >> 60) == 0; }, positions);
+	EXPECT_EQ(positions, expected);
+	EXPECT_EQ(batch.get_current_fingerprint(), single.get_current_fingerprint());
+}
+
+TEST(GearHash, cut_point_limits)
+{
+	GearHash gear;
+	auto data = random_bytes(1 << 20, 0xC0DEu);
+	std::span<const uint8_t> rest(data);
+
+	while (rest.size() > 16384) {
+		size_t cut = gear.find_cut_point(rest, 512, 8192, 16384);
+		EXPECT_GT(cut, 512u);
+		EXPECT_LE(cut, 16384u);
+		rest = rest.subspan(cut);
+	}
+
+	// Data shorter than the minimum chunk size is a single residual chunk.
+	EXPECT_EQ(gear.find_cut_point(rest.first(100), 512, 8192, 16384), 100u);
+}
+
+TEST(GearHash, signature_chunk_sizes)
+{
+	const char* FILE_NAME = "gear_t_signature";
+	write_bytes(FILE_NAME, random_bytes(4 * 1024 * 1024, 0x1234u));
+
+	Signature<GearHash, BLAKE512> signatures;
+	signatures.generate_signatures(FILE_NAME);
+	const auto& chunks = signatures.get_chunks();
+
+	ASSERT_GT(chunks.size(), 0u);
+	EXPECT_EQ(chunks[0].start_offset, 0u);
+	for (size_t i = 1; i < chunks.size(); ++i)
+		ASSERT_EQ(chunks[i].start_offset, chunks[i - 1].start_offset + chunks[i - 1].chunk_size);
+
+	// Normalized chunking keeps the average close to the 8 KiB target.
+	const size_t average = (4 * 1024 * 1024) / chunks.size();
+	EXPECT_GT(average, 6144u);
+	EXPECT_LT(average, 10240u);
+
+	std::remove(FILE_NAME);
+}
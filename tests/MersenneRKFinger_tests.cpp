@@ -0,0 +1,95 @@
+#include "gtest/gtest.h"
+
+#include "MersenneRKFinger.hpp"
+#include "TestFiles.hpp"
+
+#include <vector>
+
+namespace {
+
+// Polynomial hash of the window computed by plain modular doubling (every intermediate
+// value stays below 2^62, so no 128-bit arithmetic is needed).
+uint64_t reference_hash(std::span<const uint8_t> window)
+{
+	uint64_t value = 0;
+	for (uint8_t byte : window) {
+		for (int bit = 0; bit < 8; bit++) {
+			value *= 2;
+			if (value >= MERSENNE61_MODULUS)
+				value -= MERSENNE61_MODULUS;
+		}
+		value = (value + byte) % MERSENNE61_MODULUS;
+	}
+	return value;
+}
+
+} // namespace
+
+TEST(MersenneRKFinger, initialize_correct)
+{
+	MersenneRKFinger finger;
+
+	std::vector<uint8_t> init(48, 0xBE);
+	EXPECT_EQ(finger.initialize(init), true);
+	EXPECT_EQ(finger.get_current_fingerprint(), reference_hash(init));
+}
+
+TEST(MersenneRKFinger, initialize_incorrect)
+{
+	MersenneRKFinger finger;
+
+	std::vector<uint8_t> init(47, 0xBE);					// Less than window size
+	EXPECT_EQ(finger.initialize(init), false);
+}
+
+TEST(MersenneRKFinger, reduce)
+{
+	EXPECT_EQ(reduce_mersenne61(0), 0u);
+	EXPECT_EQ(reduce_mersenne61(MERSENNE61_MODULUS), 0u);
+	EXPECT_EQ(reduce_mersenne61(MERSENNE61_MODULUS + 5), 5u);
+	EXPECT_EQ(reduce_mersenne61(~0ULL), static_cast<uint64_t>(~0ULL % MERSENNE61_MODULUS));
+}
+
+TEST(MersenneRKFinger, rolling_window)
+{
+	// Value depends only on the last window_size bytes and matches the polynomial hash.
+	auto data = random_bytes(4096, 0x61u);
+	for (unsigned int window : { 1u, 16u, 48u, 64u }) {
+		MersenneRKFinger rolled(window), direct(window);
+		EXPECT_EQ(rolled.get_window_size(), window);
+
+		rolled.initialize(std::span<const uint8_t>(data).first(window));
+		for (size_t i = window; i < data.size(); ++i) {
+			const uint64_t value = rolled.compute_next(data[i]);
+			if (i % 511 == 0) {
+				ASSERT_EQ(value, reference_hash(std::span<const uint8_t>(data).subspan(i + 1 - window, window))) << "window " << window;
+			}
+		}
+
+		direct.initialize(std::span<const uint8_t>(data).last(window));
+		EXPECT_EQ(rolled.get_current_fingerprint(), direct.get_current_fingerprint());
+		EXPECT_LT(rolled.get_current_fingerprint(), rolled.get_modulus());
+	}
+}
+
+TEST(MersenneRKFinger, roll_matches_compute_next)
+{
+	auto data = random_bytes(4096, 0x5012u);
+	MersenneRKFinger single, batch;
+	single.initialize(data);
+	batch.initialize(data);
+
+	std::vector<size_t> expected;
+	for (size_t i = WINDOW_DEF_SIZE; i < data.size(); ++i) {
+		if ((single.compute_next(data[i]) & 15) == 0)
+			expected.push_back(i + 1 - WINDOW_DEF_SIZE);
+	}
+
+	std::vector<size_t> positions;
+	batch.roll(std::span<const uint8_t>(data).subspan(WINDOW_DEF_SIZE), [](uint64_t value) { return (value & 15) == 0; }, positions);
+	EXPECT_EQ(positions, expected);
+	EXPECT_EQ(batch.get_current_fingerprint(), single.get_current_fingerprint());
+
+	// Ring buffer state is kept, so per-byte rolling can continue after roll().
+	EXPECT_EQ(batch.compute_next(0x42), single.compute_next(0x42));
+}
@@ -3,6 +3,10 @@
 
 #include "RK_finger.hpp"
 
+#include <random>
+#include <span>
+#include <vector>
+
 TEST(RKfinger, initialize_correct)
 {
 	RKFinger rk;
@@ -72,4 +76,115 @@ TEST(RKfinger, get_current_fingerprint)
 	EXPECT_EQ(rk.compute_next(10), 758716516);
 
 	EXPECT_EQ(rk.get_current_fingerprint(), 758716516);
-}
\ No newline at end of file
+}
+
+TEST(RKfinger, roll_matches_compute_next)
+{
+	std::mt19937 rng(0x5011u);
+	std::vector<uint8_t> data(5000);
+	for (auto& b : data)
+		b = static_cast<uint8_t>(rng());
+	const std::span<const uint8_t> bytes(data);
+
+	// Default modulus takes the division free path, the other one the generic path.
+	for (const RKFinger& params : { RKFinger(), RKFinger(256, 48, INT_MAX), RKFinger(12, 30, 123009) }) {
+		RKFinger single = params, batch = params;
+		const unsigned int window = params.get_window_size();
+		single.initialize(bytes);
+		batch.initialize(bytes);
+
+		std::vector<size_t> expected;
+		for (size_t i = window; i < data.size(); ++i) {
+			if (single.compute_next(data[i]) % 7 == 0)
+				expected.push_back(i + 1 - window);
+		}
+
+		std::vector<size_t> positions;
+		EXPECT_EQ(batch.roll(bytes.subspan(window), [](uint64_t value) { return value % 7 == 0; }, positions),
+		          single.get_current_fingerprint());
+		EXPECT_EQ(positions, expected);
+		EXPECT_EQ(batch.get_current_fingerprint(), single.get_current_fingerprint());
+
+		// Rolling in pieces continues from the current state.
+		RKFinger pieces = params;
+		pieces.initialize(bytes);
+		pieces.roll(bytes.subspan(window, 100));
+		EXPECT_EQ(pieces.roll(bytes.subspan(window + 100)), single.get_current_fingerprint());
+	}
+}
+
+TEST(RKfinger, roll_empty)
+{
+	RKFinger rk;
+	std::vector<uint8_t> init(48, 0xBE);
+
+	rk.initialize(init);
+	EXPECT_EQ(rk.roll(std::span<const uint8_t>()), rk.get_current_fingerprint());
+}
+
+TEST(StaticRKFinger, matches_runtime_rkfinger)
+{
+	std::mt19937 rng(0x5018u);
+	std::vector<uint8_t> data(5000);
+	for (auto& b : data)
+		b = static_cast<uint8_t>(rng());
+	const std::span<const uint8_t> bytes(data);
+
+	RKFinger runtime(12, 30, 123009);
+	StaticRKFinger<30, 12, 123009> fixed;
+	EXPECT_EQ(fixed.get_alphabet_size(), 12);
+	EXPECT_EQ(fixed.get_window_size(), 30);
+	EXPECT_EQ(fixed.get_modulus(), 123009);
+
+	runtime.initialize(bytes);
+	fixed.initialize(bytes);
+	EXPECT_EQ(fixed.get_current_fingerprint(), runtime.get_current_fingerprint());
+	for (size_t i = 30; i < data.size(); ++i)
+		ASSERT_EQ(fixed.compute_next(data[i]), runtime.compute_next(data[i])) << "byte " << i;
+}
+
+TEST(StaticRKFinger, default_params_roll)
+{
+	std::mt19937 rng(0x5019u);
+	std::vector<uint8_t> data(5000);
+	for (auto& b : data)
+		b = static_cast<uint8_t>(rng());
+	const std::span<const uint8_t> bytes(data);
+
+	RKFinger runtime;
+	StaticRKFinger<> fixed;
+	EXPECT_EQ(fixed.get_window_size(), WINDOW_DEF_SIZE);
+	EXPECT_EQ(fixed.get_modulus(), INT_MAX);
+
+	runtime.initialize(bytes);
+	fixed.initialize(bytes);
+	std::vector<size_t> expected, positions;
+	runtime.roll(bytes.subspan(WINDOW_DEF_SIZE), [](uint64_t value) { return value % 5 == 0; }, expected);
+	EXPECT_EQ(fixed.roll(bytes.subspan(WINDOW_DEF_SIZE), [](uint64_t value) { return value % 5 == 0; }, positions),
+	          runtime.get_current_fingerprint());
+	EXPECT_EQ(positions, expected);
+}
+
+TEST(StaticRKFinger, compile_time_tables)
+{
+	static_assert(StaticRKFinger<>::OUT_TABLE[0] == 0);
+	static_assert(StaticRKFinger<4, 10, 1000003>::OUT_TABLE[1] == StaticRKFinger<4, 10, 1000003>::H);
+	static_assert(StaticRKFinger<4, 10, 1000003>::OUT_TABLE[255] == (255 * StaticRKFinger<4, 10, 1000003>::H) % 1000003);
+	SUCCEED();
+}
+
+TEST(StaticRKFinger, reduce)
+{
+	std::mt19937_64 rng(0x501Au);
+	std::vector<uint64_t> values = { 0, 1, INT_MAX, 123009, 123008, 1ULL << 40, UINT64_MAX, UINT64_MAX - 1 };
+	for (int i = 0; i < 10000; i++)
+		values.push_back(rng() >> (i % 64));
+
+	for (uint64_t value : values) {
+		EXPECT_EQ(StaticRKFinger<>::reduce(value), value % INT_MAX) << value;
+		EXPECT_EQ((StaticRKFinger<30, 12, 123009>::reduce(value)), value % 123009) << value;
+		EXPECT_EQ((StaticRKFinger<48, 256, (1ULL << 24) - 1>::reduce(value)), value % ((1ULL << 24) - 1)) << value;
+		EXPECT_EQ((StaticRKFinger<48, 256, 7>::reduce(value)), value % 7) << value;
+		EXPECT_EQ((StaticRKFinger<48, 256, 1>::reduce(value)), 0u) << value;
+	}
+}
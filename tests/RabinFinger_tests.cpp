@@ -0,0 +1,122 @@
+#include "gtest/gtest.h"
+
+#include "RabinFinger.hpp"
+#include "TestFiles.hpp"
+
+#include <vector>
+
+namespace {
+
+// Fingerprint of the window computed directly from the definition.
+uint64_t reference_hash(std::span<const uint8_t> window, uint64_t polynomial = RABIN_DEF_POLYNOMIAL)
+{
+	uint64_t value = 0;
+	for (uint8_t byte : window)
+		value = gf2_mulmod(value, 0x100, polynomial) ^ byte;
+	return value;
+}
+
+} // namespace
+
+TEST(RabinFinger, irreducible)
+{
+	EXPECT_TRUE(gf2_irreducible(RABIN_DEF_POLYNOMIAL));
+	EXPECT_EQ(gf2_degree(RABIN_DEF_POLYNOMIAL), 53);
+	EXPECT_TRUE(gf2_irreducible(0x11B));						// x^8 + x^4 + x^3 + x + 1 (AES)
+	EXPECT_FALSE(gf2_irreducible(0x31));						// (x^2 + x + 1)(x^3 + x + 1)
+	EXPECT_FALSE(gf2_irreducible(RABIN_DEF_POLYNOMIAL ^ 1));	// Divisible by x
+	static_assert(gf2_irreducible(RABIN_DEF_POLYNOMIAL));
+}
+
+TEST(RabinFinger, gf2_arithmetic)
+{
+	EXPECT_EQ(gf2_mod(0x31, 0x7), 0u);
+	EXPECT_EQ(gf2_mod(0x31, 0xB), 0u);
+	EXPECT_EQ(gf2_mulmod(0x7, 0xB, 0x1FF), 0x31u);
+	EXPECT_EQ(gf2_mulmod(0x53, 0xCA, 0x11B), 0x01u);			// Inverses in AES field
+	EXPECT_EQ(gf2_degree(0), -1);
+}
+
+TEST(RabinFinger, initialize_correct)
+{
+	RabinFinger rabin;
+
+	std::vector<uint8_t> init(48, 0xBE);
+	EXPECT_EQ(rabin.initialize(init), true);
+	EXPECT_EQ(rabin.get_current_fingerprint(), reference_hash(init));
+	EXPECT_EQ(rabin.get_polynomial(), RABIN_DEF_POLYNOMIAL);
+}
+
+TEST(RabinFinger, initialize_incorrect)
+{
+	RabinFinger rabin;
+
+	std::vector<uint8_t> init(47, 0xBE);					// Less than window size
+	EXPECT_EQ(rabin.initialize(init), false);
+}
+
+TEST(RabinFinger, invalid_polynomial)
+{
+	EXPECT_EQ(RabinFinger(48, 0x11B).get_polynomial(), RABIN_DEF_POLYNOMIAL);	// Degree too low
+	EXPECT_EQ(RabinFinger(48, ~0ULL).get_polynomial(), RABIN_DEF_POLYNOMIAL);	// Degree too high
+}
+
+TEST(RabinFinger, rolling_window)
+{
+	// Value depends only on the last window_size bytes and matches the definition.
+	auto data = random_bytes(4096, 0xAB17u);
+	const uint64_t other = 0x2C5B3F9A7D8E1ULL;				// Degree 49
+	for (uint64_t polynomial : { RABIN_DEF_POLYNOMIAL, other }) {
+		for (unsigned int window : { 1u, 16u, 48u, 64u }) {
+			RabinFinger rolled(window, polynomial), direct(window, polynomial);
+			EXPECT_EQ(rolled.get_window_size(), window);
+
+			rolled.initialize(std::span<const uint8_t>(data).first(window));
+			for (size_t i = window; i < data.size(); ++i) {
+				const uint64_t value = rolled.compute_next(data[i]);
+				if (i % 511 == 0) {
+					ASSERT_EQ(value, reference_hash(std::span<const uint8_t>(data).subspan(i + 1 - window, window), polynomial)) << "window " << window;
+				}
+			}
+
+			direct.initialize(std::span<const uint8_t>(data).last(window));
+			EXPECT_EQ(rolled.get_current_fingerprint(), direct.get_current_fingerprint());
+			EXPECT_LT(gf2_degree(rolled.get_current_fingerprint()), gf2_degree(polynomial));
+		}
+	}
+}
+
+TEST(RabinFinger, roll_matches_compute_next)
+{
+	auto data = random_bytes(4096, 0xAB18u);
+	RabinFinger single, batch;
+	single.initialize(data);
+	batch.initialize(data);
+
+	std::vector<size_t> expected;
+	for (size_t i = WINDOW_DEF_SIZE; i < data.size(); ++i) {
+		if ((single.compute_next(data[i]) & 15) == 0)
+			expected.push_back(i + 1 - WINDOW_DEF_SIZE);
+	}
+
+	std::vector<size_t> positions;
+	batch.roll(std::span<const uint8_t>(data).subspan(WINDOW_DEF_SIZE), [](uint64_t value) { return (value & 15) == 0; }, positions);
+	EXPECT_EQ(positions, expected);
+	EXPECT_EQ(batch.get_current_fingerprint(), single.get_current_fingerprint());
+	EXPECT_EQ(batch.compute_next(0x42), single.compute_next(0x42));
+}
+
+TEST(RabinFinger, boundary_distribution)
+{
+	// Low bits of the fingerprint of random data are uniform: a 1/64 mask matches
+	// about 1/64 of positions.
+	auto data = random_bytes(1 << 20, 0xAB1Au);
+	RabinFinger rabin;
+	std::vector<size_t> positions;
+	rabin.initialize(data);
+	rabin.roll(std::span<const uint8_t>(data).subspan(WINDOW_DEF_SIZE), [](uint64_t value) { return (value & 63) == 0; }, positions);
+
+	const double expected = double(data.size() - WINDOW_DEF_SIZE) / 64;
+	EXPECT_GT(double(positions.size()), expected * 0.9);
+	EXPECT_LT(double(positions.size()), expected * 1.1);
+}
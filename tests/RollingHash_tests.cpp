@@ -0,0 +1,55 @@
+#include "gtest/gtest.h"
+
+#include "Apply.hpp"
+#include "BuzHash.hpp"
+#include "Delta.hpp"
+#include "GearHash.hpp"
+#include "MersenneRKFinger.hpp"
+#include "RK_finger.hpp"
+#include "RabinFinger.hpp"
+#include "Signature.hpp"
+#include "TestFiles.hpp"
+#include "blake.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Properties every rolling hash usable by Signature must have. Algorithm specific
+// checks (reference values, window behavior) live in the per-hash test files.
+template <class T>
+class RollingHash : public ::testing::Test {};
+
+using RollingHashTypes = ::testing::Types<GearHash, MersenneRKFinger, BuzHash, RabinFinger, StaticRKFinger<>>;
+TYPED_TEST_SUITE(RollingHash, RollingHashTypes);
+
+TYPED_TEST(RollingHash, roundtrip)
+{
+	// Suite name is unique per hash, e.g. "RollingHash/0".
+	std::string prefix = ::testing::UnitTest::GetInstance()->current_test_info()->test_suite_name();
+	std::replace(prefix.begin(), prefix.end(), '/', '_');
+	const std::string OLD = prefix + "_old", NEW = prefix + "_new", DELTA = prefix + "_delta", OUT = prefix + "_out";
+
+	auto data = random_bytes(256 * 1024, 0xABCDu);
+	write_bytes(OLD, data);
+	data.insert(data.begin() + 100000, {1, 2, 3, 4, 5});
+	data[200000] ^= 0xFF;
+	write_bytes(NEW, data);
+
+	Signature<TypeParam, BLAKE512> os, ns;
+	os.generate_signatures(OLD);
+	ns.generate_signatures(NEW);
+	ASSERT_GT(os.get_chunks().size(), 1u);
+	Delta<TypeParam, BLAKE512> d;
+	auto dr = d.generate_delta(os, ns, OLD.c_str(), NEW.c_str(), DELTA.c_str());
+	ASSERT_TRUE(dr.success) << dr.error_message;
+
+	Apply<TypeParam, BLAKE512> apply;
+	auto ar = apply.apply_delta(OLD.c_str(), DELTA.c_str(), OUT.c_str());
+	ASSERT_TRUE(ar.success) << ar.error_message;
+	EXPECT_EQ(read_all(NEW), read_all(OUT));
+
+	for (const auto& p : {OLD, NEW, DELTA, OUT})
+		std::remove(p.c_str());
+}
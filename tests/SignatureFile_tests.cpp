@@ -0,0 +1,258 @@
+#include "gtest/gtest.h"
+
+#include "Apply.hpp"
+#include "Delta.hpp"
+#include "RK_finger.hpp"
+#include "Signature.hpp"
+#include "SignatureFile.hpp"
+#include "TestFiles.hpp"
+#include "blake.h"
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace {
+
+void expect_refresh_matches(const char* data_path, const char* sig_path, std::span<const ByteRange> changed, bool reused)
+{
+	Signature<RKFinger, BLAKE512> refreshed;
+	EXPECT_EQ(refreshed.refresh_signatures(sig_path, data_path, changed), reused);
+
+	Signature<RKFinger, BLAKE512> generated;
+	generated.generate_signatures(data_path);
+
+	const auto& a = refreshed.get_chunks();
+	const auto& b = generated.get_chunks();
+	ASSERT_EQ(a.size(), b.size());
+	for (size_t i = 0; i < a.size(); ++i) {
+		EXPECT_EQ(a[i], b[i]) << "chunk " << i;
+		EXPECT_EQ(a[i].start_offset, b[i].start_offset) << "chunk " << i;
+	}
+}
+
+} // namespace
+
+TEST(SignatureFile, header_round_trip)
+{
+	SignatureFileHeader header;
+	header.chunking_policy = 13;
+	header.signature_size = 8;
+	header.hash_size = 64;
+	header.chunk_count = 0x0102030405060708ull;
+	header.file_size = 1234567;
+	header.file_mtime = -42;
+
+	auto encoded = encode_signature_file_header(header);
+	EXPECT_EQ(encoded[0], 'R');
+	EXPECT_EQ(encoded[8], 0x08);					// little-endian chunk count
+
+	SignatureFileHeader decoded;
+	ASSERT_TRUE(decode_signature_file_header(encoded, decoded));
+	EXPECT_EQ(decoded.version, SIGNATURE_FILE_VERSION);
+	EXPECT_EQ(decoded.chunking_policy, 13);
+	EXPECT_EQ(decoded.chunk_count, header.chunk_count);
+	EXPECT_EQ(decoded.file_size, header.file_size);
+	EXPECT_EQ(decoded.file_mtime, header.file_mtime);
+	EXPECT_EQ(decoded.record_size(), 88u);
+
+	encoded[1] = 'X';
+	EXPECT_FALSE(decode_signature_file_header(encoded, decoded));
+}
+
+TEST(SignatureFile, save_and_load)
+{
+	const char* DATA = "sigfile_t_data";
+	const char* SIG = "sigfile_t_data.sig";
+	write_bytes(DATA, random_bytes(2 * 1024 * 1024 + 77, 0x516u));
+
+	Signature<RKFinger, BLAKE512> generated;
+	generated.generate_signatures(DATA);
+	ASSERT_TRUE(generated.save_signatures(SIG, DATA));
+
+	SignatureFileHeader header;
+	ASSERT_TRUE(read_signature_file_header(SIG, header));
+	EXPECT_EQ(header.chunk_count, generated.get_chunks().size());
+	EXPECT_EQ(std::filesystem::file_size(SIG), SIGNATURE_FILE_HEADER_SIZE + header.chunk_count * header.record_size());
+
+	Signature<RKFinger, BLAKE512> loaded;
+	ASSERT_TRUE(loaded.load_signatures(SIG, DATA));
+	const auto& a = loaded.get_chunks();
+	const auto& b = generated.get_chunks();
+	ASSERT_EQ(a.size(), b.size());
+	for (size_t i = 0; i < a.size(); ++i) {
+		EXPECT_EQ(a[i], b[i]) << "chunk " << i;
+		EXPECT_EQ(a[i].start_offset, b[i].start_offset) << "chunk " << i;
+	}
+
+	// Different chunking policy must not accept the file.
+	Signature<RKFinger, BLAKE512, LargeChunkingPolicy> large;
+	EXPECT_FALSE(large.load_signatures(SIG, DATA));
+
+	std::remove(DATA);
+	std::remove(SIG);
+}
+
+TEST(SignatureFile, rejects_stale_and_damaged_files)
+{
+	const char* DATA = "sigfile_t_stale";
+	const char* SIG = "sigfile_t_stale.sig";
+	auto data = random_bytes(300000, 0x5A1Eu);
+	write_bytes(DATA, data);
+
+	Signature<RKFinger, BLAKE512> generated;
+	generated.generate_signatures(DATA);
+	ASSERT_TRUE(generated.save_signatures(SIG, DATA));
+	const auto sig = read_all(SIG);
+
+	Signature<RKFinger, BLAKE512> loaded;
+
+	// Truncated record table.
+	write_bytes(SIG, std::vector<uint8_t>(sig.begin(), sig.end() - 1));
+	EXPECT_FALSE(loaded.load_signatures(SIG, DATA));
+
+	// Record offsets not tiling the file.
+	auto damaged = sig;
+	damaged[SIGNATURE_FILE_HEADER_SIZE + 8] ^= 1;
+	write_bytes(SIG, damaged);
+	EXPECT_FALSE(loaded.load_signatures(SIG, DATA));
+
+	// Data file modified after signing (same size, newer modification time).
+	write_bytes(SIG, sig);
+	ASSERT_TRUE(loaded.load_signatures(SIG, DATA));
+	data[1000] ^= 0xFF;
+	write_bytes(DATA, data);
+	std::filesystem::last_write_time(DATA, std::filesystem::last_write_time(DATA) + std::chrono::seconds(5));
+	EXPECT_FALSE(loaded.load_signatures(SIG, DATA));
+
+	EXPECT_FALSE(loaded.load_signatures("sigfile_t_missing.sig", DATA));
+
+	std::remove(DATA);
+	std::remove(SIG);
+}
+
+TEST(SignatureFile, apply_with_signature_file)
+{
+	const char* OLD = "sigfile_t_apply_old";
+	const char* NEW = "sigfile_t_apply_new";
+	const char* SIG = "sigfile_t_apply_old.sig";
+	const char* DELTA = "sigfile_t_apply_delta";
+	const char* OUT = "sigfile_t_apply_out";
+
+	auto data = random_bytes(500000, 0xA991u);
+	write_bytes(OLD, data);
+	data.insert(data.begin() + 250000, 100, 0x33);
+	write_bytes(NEW, data);
+
+	Signature<RKFinger, BLAKE512> os, ns;
+	os.generate_signatures(OLD);
+	ASSERT_TRUE(os.save_signatures(SIG, OLD));
+
+	Signature<RKFinger, BLAKE512> loaded;
+	ASSERT_TRUE(loaded.load_signatures(SIG, OLD));
+	ns.generate_signatures(NEW);
+	Delta<RKFinger, BLAKE512> d;
+	ASSERT_TRUE(d.generate_delta(loaded, ns, OLD, NEW, DELTA).success);
+
+	Apply<RKFinger, BLAKE512> apply;
+	apply.set_old_signature_file(SIG);
+	auto ar = apply.apply_delta(OLD, DELTA, OUT);
+	ASSERT_TRUE(ar.success) << ar.error_message;
+	EXPECT_EQ(read_all(NEW), read_all(OUT));
+
+	// Signature of another file is rejected before the output is written.
+	std::remove(OUT);
+	apply.set_old_signature_file(DELTA);
+	EXPECT_FALSE(apply.apply_delta(OLD, DELTA, OUT).success);
+	EXPECT_FALSE(std::filesystem::exists(OUT));
+
+	for (const auto* p : {OLD, NEW, SIG, DELTA, OUT})
+		std::remove(p);
+}
+
+TEST(SignatureFile, refresh_after_partial_changes)
+{
+	const char* DATA = "sigfile_t_refresh";
+	const char* SIG = "sigfile_t_refresh.sig";
+	auto data = random_bytes(1024 * 1024 + 31, 0x4EF4u);
+	write_bytes(DATA, data);
+
+	Signature<RKFinger, BLAKE512> original;
+	original.generate_signatures(DATA);
+	ASSERT_TRUE(original.save_signatures(SIG, DATA));
+
+	// Append - no ranges needed.
+	auto appended = data;
+	auto tail = random_bytes(70000, 0x7A11u);
+	appended.insert(appended.end(), tail.begin(), tail.end());
+	write_bytes(DATA, appended);
+	expect_refresh_matches(DATA, SIG, {}, true);
+
+	// In-place updates of a few pages, including the very last byte.
+	auto updated = data;
+	const std::vector<ByteRange> pages = { { 4096, 4096 }, { 600000, 10 }, { data.size() - 1, 1 } };
+	for (const auto& page : pages)
+		for (size_t i = 0; i < page.size; i++)
+			updated[page.offset + i] ^= 0xA5;
+	write_bytes(DATA, updated);
+	expect_refresh_matches(DATA, SIG, pages, true);
+
+	// Truncation.
+	write_bytes(DATA, std::vector<uint8_t>(data.begin(), data.begin() + 500000));
+	expect_refresh_matches(DATA, SIG, {}, true);
+
+	// Changes not reported in ranges are found by verification and rechunked.
+	auto unreported = data;
+	unreported[10] ^= 0xFF;
+	write_bytes(DATA, unreported);
+	expect_refresh_matches(DATA, SIG, {}, true);
+
+	// Unusable signature file.
+	expect_refresh_matches(DATA, "sigfile_t_refresh_missing.sig", {}, false);
+
+	std::remove(DATA);
+	std::remove(SIG);
+}
+
+TEST(SignatureFile, refresh_finds_unreported_in_place_edit)
+{
+	const char* OLD = "sigfile_t_unreported_old";
+	const char* NEW = "sigfile_t_unreported_new";
+	const char* SIG = "sigfile_t_unreported.sig";
+	const char* REFRESHED = "sigfile_t_unreported_refreshed.sig";
+	const char* DELTA = "sigfile_t_unreported_delta";
+	const char* OUT = "sigfile_t_unreported_out";
+	auto data = random_bytes(3 * 1024 * 1024, 0x1B17u);
+	write_bytes(NEW, data);
+
+	Signature<RKFinger, BLAKE512> original;
+	original.generate_signatures(NEW);
+	ASSERT_TRUE(original.save_signatures(SIG, NEW));
+
+	// One byte overwritten in the middle, size unchanged, no ranges given.
+	write_bytes(OLD, data);
+	data[2000001] ^= 0x01;
+	write_bytes(NEW, data);
+	expect_refresh_matches(NEW, SIG, {}, true);
+
+	// The refreshed signature describes the edited file, so deltas against it apply.
+	Signature<RKFinger, BLAKE512> refreshed;
+	ASSERT_TRUE(refreshed.refresh_signatures(SIG, NEW));
+	ASSERT_TRUE(refreshed.save_signatures(REFRESHED, NEW));
+
+	Signature<RKFinger, BLAKE512> base, target;
+	ASSERT_TRUE(base.load_signatures(REFRESHED, NEW));
+	target.generate_signatures(OLD);
+	Delta<RKFinger, BLAKE512> delta;
+	ASSERT_TRUE(delta.generate_delta(base, target, NEW, OLD, DELTA).success);
+	Apply<RKFinger, BLAKE512> apply;
+	auto result = apply.apply_delta(NEW, DELTA, OUT);
+	ASSERT_TRUE(result.success) << result.error_message;
+	EXPECT_EQ(read_all(OUT), read_all(OLD));
+
+	for (const auto* p : { OLD, NEW, SIG, REFRESHED, DELTA, OUT })
+		std::remove(p);
+}
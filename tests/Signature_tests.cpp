@@ -5,6 +5,77 @@
 #include "blake.h"
 #include "Signature.hpp"
 
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Table = Signature<RKFinger, BLAKE512>::Table;
+
+// Byte-at-a-time chunker equivalent to the original generate_signatures loop,
+// used as a reference for the block-buffered scanner.
+Table reference_chunks(const std::vector<uint8_t>& data)
+{
+	Table out;
+	RKFinger fingerprint;
+	BLAKE512 hash_func;
+	const size_t window = fingerprint.get_window_size();
+	uint64_t current_fingerprint = 0;
+	size_t pos = 0;
+
+	while (pos < data.size()) {
+		size_t start = pos;
+		size_t init = std::min(window, data.size() - pos);
+		fingerprint.initialize(std::span<const uint8_t>(data.data() + pos, init));
+		std::vector<uint8_t> chunk(data.begin() + pos, data.begin() + pos + init);
+		pos += init;
+
+		while (pos < data.size()) {
+			uint8_t byte = data[pos++];
+			uint8_t last = chunk.back();
+			chunk.push_back(byte);
+			current_fingerprint = fingerprint.compute_next(byte);
+
+			bool boundary = false;
+			if (chunk.size() >= 16384) {
+				boundary = true;
+			} else if (chunk.size() >= 512) {
+				uint32_t mask = chunk.size() < 2048 ? 0x1FF : chunk.size() < 4096 ? 0x7FF : 0x1FFF;
+				boundary = (((last << 8 | byte) & mask) == 0);
+			}
+			if (boundary)
+				break;
+		}
+
+		Table::Hash hash;
+		hash_func.hash(hash, chunk);
+		out.push_back(current_fingerprint, hash, start, chunk.size());
+	}
+	return out;
+}
+
+void write_bytes(const std::string& path, const std::vector<uint8_t>& bytes)
+{
+	std::ofstream f(path, std::ios::binary);
+	if (!bytes.empty())
+		f.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+}
+
+void expect_same_chunks(const Table& a, const Table& b)
+{
+	ASSERT_EQ(a.size(), b.size());
+	for (size_t i = 0; i < a.size(); ++i) {
+		EXPECT_EQ(a[i], b[i]) << "chunk " << i;
+		EXPECT_EQ(a[i].start_offset, b[i].start_offset) << "chunk " << i;
+	}
+}
+
+} // namespace
+
 TEST(Signature, generate_signature_null)
 {
 	Signature<RKFinger, BLAKE512> signatures;
@@ -45,4 +116,330 @@ TEST(Signature, generate_signature)
 	for (size_t i = 1; i < chunks.size(); ++i) {
 		ASSERT_EQ(chunks[i].start_offset, chunks[i-1].start_offset + chunks[i-1].chunk_size);
 	}
-}
\ No newline at end of file
+}
+
+TEST(Signature, block_scanner_matches_reference)
+{
+	const char* FILE_NAME = "signature_t_block_scanner";
+
+	// Larger than a single read block, mixing random data with a zero run so
+	// that both forced and content-defined cuts straddle block boundaries.
+	std::vector<uint8_t> data(9 * 1024 * 1024 + 777);
+	std::mt19937 rng(0x5151u);
+	std::uniform_int_distribution<int> dist(0, 255);
+	for (auto& b : data)
+		b = static_cast<uint8_t>(dist(rng));
+	std::fill(data.begin() + 3 * 1024 * 1024, data.begin() + 5 * 1024 * 1024, 0);
+	write_bytes(FILE_NAME, data);
+
+	Signature<RKFinger, BLAKE512> signatures;
+	signatures.generate_signatures(FILE_NAME);
+	expect_same_chunks(signatures.get_chunks(), reference_chunks(data));
+
+	std::remove(FILE_NAME);
+}
+
+TEST(Signature, block_scanner_small_files)
+{
+	const char* FILE_NAME = "signature_t_small";
+
+	// Sizes around the rolling hash window and the minimum chunk size.
+	for (size_t size : {1u, 47u, 48u, 49u, 511u, 512u, 600u, 16384u, 16433u}) {
+		std::vector<uint8_t> data(size);
+		std::mt19937 rng(static_cast<uint32_t>(size));
+		std::uniform_int_distribution<int> dist(0, 255);
+		for (auto& b : data)
+			b = static_cast<uint8_t>(dist(rng));
+		write_bytes(FILE_NAME, data);
+
+		Signature<RKFinger, BLAKE512> signatures;
+		signatures.generate_signatures(FILE_NAME);
+		expect_same_chunks(signatures.get_chunks(), reference_chunks(data));
+	}
+
+	std::remove(FILE_NAME);
+}
+
+TEST(Signature, parallel_matches_sequential)
+{
+	const char* FILE_NAME = "signature_t_parallel";
+
+	// Three 16 MiB segments; the second seam falls into a zero run where boundaries
+	// cannot resynchronize until the run ends.
+	std::vector<uint8_t> data(48 * 1024 * 1024 + 12345);
+	std::mt19937 rng(0x9A7Au);
+	std::uniform_int_distribution<int> dist(0, 255);
+	for (auto& b : data)
+		b = static_cast<uint8_t>(dist(rng));
+	const size_t seam = data.size() * 2 / 3;
+	std::fill(data.begin() + seam - 100000, data.begin() + seam + 50000, 0);
+	write_bytes(FILE_NAME, data);
+
+	Signature<RKFinger, BLAKE512> sequential;
+	sequential.generate_signatures(FILE_NAME);
+
+	Signature<RKFinger, BLAKE512> parallel;
+	parallel.set_threads(3);
+	EXPECT_EQ(parallel.get_threads(), 3u);
+	parallel.generate_signatures(FILE_NAME);
+
+	expect_same_chunks(parallel.get_chunks(), sequential.get_chunks());
+
+	std::remove(FILE_NAME);
+}
+
+TEST(Signature, parallel_matches_sequential_on_periodic_data)
+{
+	const char* FILE_NAME = "signature_t_parallel_periodic";
+
+	// Segment grids never line up with the sequential one on zero-filled data, and
+	// only rarely on short periodic patterns - seams are rescanned up to EOF.
+	for (size_t period : { size_t(0), size_t(7), size_t(4096) }) {
+		std::vector<uint8_t> data(32 * 1024 * 1024 + 777);
+		for (size_t i = 0; period != 0 && i < data.size(); i++)
+			data[i] = static_cast<uint8_t>(i % period * 37 + 1);
+		write_bytes(FILE_NAME, data);
+
+		Signature<RKFinger, BLAKE512> sequential;
+		sequential.generate_signatures(FILE_NAME);
+
+		Signature<RKFinger, BLAKE512> parallel;
+		parallel.set_threads(2);
+		parallel.generate_signatures(FILE_NAME);
+
+		ASSERT_EQ(parallel.get_chunks().size(), sequential.get_chunks().size()) << "period " << period;
+		EXPECT_EQ(parallel.get_stats().chunk_count, sequential.get_stats().chunk_count);
+		expect_same_chunks(parallel.get_chunks(), sequential.get_chunks());
+	}
+
+	std::remove(FILE_NAME);
+}
+
+TEST(Signature, pipelined_matches_sequential)
+{
+	const char* FILE_NAME = "signature_t_pipelined";
+
+	// Below the parallel segment threshold, so extra threads are used for hashing.
+	std::vector<uint8_t> data(10 * 1024 * 1024 + 4321);
+	std::mt19937 rng(0x71BEu);
+	std::uniform_int_distribution<int> dist(0, 255);
+	for (auto& b : data)
+		b = static_cast<uint8_t>(dist(rng));
+	std::fill(data.begin() + 4 * 1024 * 1024, data.begin() + 5 * 1024 * 1024, 0);
+	write_bytes(FILE_NAME, data);
+
+	Signature<RKFinger, BLAKE512> sequential;
+	sequential.generate_signatures(FILE_NAME);
+
+	Signature<RKFinger, BLAKE512> pipelined;
+	pipelined.set_threads(4);
+	pipelined.generate_signatures(FILE_NAME);
+	expect_same_chunks(pipelined.get_chunks(), sequential.get_chunks());
+
+	FileIO file;
+	ASSERT_TRUE(file.open(FILE_NAME, FileMode::IN));
+	Signature<RKFinger, BLAKE512> from_file;
+	from_file.set_threads(2);
+	from_file.generate_signatures(file);
+	expect_same_chunks(from_file.get_chunks(), sequential.get_chunks());
+	file.close();
+
+	std::remove(FILE_NAME);
+}
+
+TEST(Signature, static_rkfinger_matches_runtime)
+{
+	// Compile-time parameterized fingerprint must give the same signatures.
+	Signature<RKFinger, BLAKE512> runtime;
+	runtime.generate_signatures("../tests/testfile");
+
+	Signature<StaticRKFinger<>, BLAKE512> fixed;
+	fixed.generate_signatures("../tests/testfile");
+
+	ASSERT_GT(runtime.get_chunks().size(), 1u);
+	expect_same_chunks(fixed.get_chunks(), runtime.get_chunks());
+}
+
+TEST(Signature, regenerate_replaces_chunks)
+{
+	Signature<RKFinger, BLAKE512> once;
+	once.generate_signatures("../tests/testfile");
+
+	Signature<RKFinger, BLAKE512> twice;
+	twice.generate_signatures("../tests/testfile");
+	twice.generate_signatures("../tests/testfile");
+	expect_same_chunks(twice.get_chunks(), once.get_chunks());
+
+	FileIO file;
+	ASSERT_TRUE(file.open("../tests/testfile", FileMode::IN));
+	twice.generate_signatures(file);
+	expect_same_chunks(twice.get_chunks(), once.get_chunks());
+	EXPECT_EQ(twice.get_stats().chunk_count, once.get_chunks().size());
+}
+
+TEST(Signature, file_digest_in_same_pass)
+{
+	const char* FILE_NAME = "signature_t_file_digest";
+
+	std::mt19937 rng(0xD16Eu);
+	std::vector<uint8_t> data(3 * 1024 * 1024 + 12345);
+	for (auto& b : data)
+		b = static_cast<uint8_t>(rng());
+	write_bytes(FILE_NAME, data);
+
+	BLAKE512 blake;
+	std::array<uint8_t, BLAKE512::HASH_SIZE> expected;
+	blake.hash(expected, data);
+
+	Signature<RKFinger, BLAKE512> plain;
+	plain.generate_signatures(FILE_NAME);
+	EXPECT_FALSE(plain.get_file_digest().has_value());
+
+	for (unsigned int threads : { 1u, 4u }) {
+		Signature<RKFinger, BLAKE512> signatures;
+		signatures.set_threads(threads);
+		signatures.set_file_digest(true);
+		signatures.generate_signatures(FILE_NAME);
+		ASSERT_TRUE(signatures.get_file_digest().has_value()) << threads;
+		EXPECT_EQ(*signatures.get_file_digest(), expected) << threads;
+		expect_same_chunks(signatures.get_chunks(), plain.get_chunks());
+
+		FileIO file;
+		ASSERT_TRUE(file.open(FILE_NAME, FileMode::IN));
+		signatures.generate_signatures(file);
+		ASSERT_TRUE(signatures.get_file_digest().has_value()) << threads;
+		EXPECT_EQ(*signatures.get_file_digest(), expected) << threads;
+	}
+
+	std::remove(FILE_NAME);
+}
+
+TEST(Signature, visitor_streams_chunks)
+{
+	const char* FILE_NAME = "signature_t_visitor";
+
+	std::vector<uint8_t> data(9 * 1024 * 1024 + 123);
+	std::mt19937 rng(0x5EEDu);
+	std::uniform_int_distribution<int> dist(0, 255);
+	for (auto& b : data)
+		b = static_cast<uint8_t>(dist(rng));
+	write_bytes(FILE_NAME, data);
+
+	Signature<RKFinger, BLAKE512> collected;
+	collected.generate_signatures(FILE_NAME);
+
+	for (unsigned int threads : { 1u, 3u }) {
+		Signature<RKFinger, BLAKE512> streaming;
+		streaming.set_threads(threads);
+
+		Table visited;
+		bool data_matches = true;
+		ASSERT_TRUE(streaming.visit_chunks(FILE_NAME,
+			[&](const Table::Ref& chunk, std::span<const uint8_t> chunk_data) {
+				data_matches = data_matches && chunk_data.size() == chunk.chunk_size &&
+					std::equal(chunk_data.begin(), chunk_data.end(), data.begin() + chunk.start_offset);
+				visited.push_back(chunk);
+			}));
+
+		EXPECT_TRUE(data_matches) << "threads " << threads;
+		EXPECT_TRUE(streaming.get_chunks().empty());
+		expect_same_chunks(visited, collected.get_chunks());
+	}
+
+	Signature<RKFinger, BLAKE512> missing;
+	EXPECT_FALSE(missing.visit_chunks("signature_t_visitor_missing",
+		[](const Table::Ref&, std::span<const uint8_t>) {}));
+
+	std::remove(FILE_NAME);
+}
+
+TEST(Signature, stats_describe_chunks)
+{
+	const char* FILE_NAME = "signature_t_stats";
+
+	// Random data followed by a run without content-defined boundaries.
+	std::vector<uint8_t> data(1024 * 1024);
+	std::mt19937 rng(0x57A7u);
+	std::uniform_int_distribution<int> dist(0, 255);
+	for (auto& b : data)
+		b = static_cast<uint8_t>(dist(rng));
+	data.insert(data.end(), 200000, 0xFF);
+	write_bytes(FILE_NAME, data);
+
+	Signature<RKFinger, BLAKE512> signatures;
+	signatures.generate_signatures(FILE_NAME);
+	const auto& chunks = signatures.get_chunks();
+	const auto& stats = signatures.get_stats();
+
+	size_t forced = 0, min_size = SIZE_MAX, max_size = 0;
+	std::array<size_t, ChunkStats::HISTOGRAM_BUCKETS> histogram{};
+	for (size_t i = 0; i < chunks.size(); ++i) {
+		forced += chunks[i].chunk_size == DefaultChunkingPolicy::MAX_CHUNK_SIZE;
+		min_size = std::min(min_size, chunks[i].chunk_size);
+		max_size = std::max(max_size, chunks[i].chunk_size);
+		histogram[ChunkStats::bucket_of(chunks[i].chunk_size)]++;
+	}
+
+	EXPECT_EQ(stats.chunk_count, chunks.size());
+	EXPECT_EQ(stats.total_bytes, data.size());
+	EXPECT_EQ(stats.min_chunk_size, min_size);
+	EXPECT_EQ(stats.max_chunk_size, max_size);
+	EXPECT_EQ(stats.forced_cuts, forced);
+	EXPECT_GE(stats.forced_cuts, 200000 / DefaultChunkingPolicy::MAX_CHUNK_SIZE);
+	EXPECT_EQ(stats.histogram, histogram);
+	EXPECT_GT(stats.elapsed_ms, 0.0);
+
+	// Visitor reports the same statistics without storing chunks.
+	Signature<RKFinger, BLAKE512> streaming;
+	ASSERT_TRUE(streaming.visit_chunks(FILE_NAME, [](const Table::Ref&, std::span<const uint8_t>) {}));
+	EXPECT_EQ(streaming.get_stats().chunk_count, stats.chunk_count);
+	EXPECT_EQ(streaming.get_stats().forced_cuts, stats.forced_cuts);
+	EXPECT_EQ(streaming.get_stats().histogram, stats.histogram);
+
+	std::remove(FILE_NAME);
+}
+
+TEST(Signature, super_chunks_group_chunk_runs)
+{
+	const char* OLD = "signature_t_super_old";
+	const char* NEW = "signature_t_super_new";
+
+	std::vector<uint8_t> data(4 * 1024 * 1024);
+	std::mt19937 rng(0x5B9Eu);
+	std::uniform_int_distribution<int> dist(0, 255);
+	for (auto& b : data)
+		b = static_cast<uint8_t>(dist(rng));
+	write_bytes(OLD, data);
+	data.insert(data.begin() + 1500000, 3000, 0x77);
+	write_bytes(NEW, data);
+
+	Signature<RKFinger, BLAKE512> old_sig, new_sig;
+	old_sig.generate_signatures(OLD);
+	new_sig.generate_signatures(NEW);
+
+	const auto& chunks = old_sig.get_chunks();
+	const auto supers = old_sig.build_super_chunks();
+	ASSERT_GT(supers.size(), 1u);
+	EXPECT_LT(supers.size(), chunks.size() / 16);
+
+	// Super-chunks tile the chunk list.
+	size_t chunk_index = 0;
+	for (size_t k = 0; k < supers.size(); ++k) {
+		ASSERT_LT(chunk_index, chunks.size());
+		EXPECT_EQ(supers[k].start_offset, chunks[chunk_index].start_offset) << "super-chunk " << k;
+		chunk_index += supers[k].signature;
+		EXPECT_EQ(supers[k].start_offset + supers[k].chunk_size, chunks[chunk_index - 1].start_offset + chunks[chunk_index - 1].chunk_size);
+	}
+	EXPECT_EQ(chunk_index, chunks.size());
+
+	// Boundaries resynchronize after the insertion - all but a few super-chunks are shared.
+	const auto new_supers = new_sig.build_super_chunks();
+	size_t shared = 0;
+	for (size_t k = 0; k < new_supers.size(); ++k)
+		for (size_t m = 0; m < supers.size(); ++m)
+			shared += new_supers[k] == supers[m];
+	EXPECT_GE(shared + 3, supers.size());
+
+	std::remove(OLD);
+	std::remove(NEW);
+}
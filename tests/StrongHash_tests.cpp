@@ -0,0 +1,197 @@
+#include "gtest/gtest.h"
+
+#include "Apply.hpp"
+#include "Delta.hpp"
+#include "DeltaHeader.hpp"
+#include "RK_finger.hpp"
+#include "Signature.hpp"
+#include "StrongHash.hpp"
+#include "TestFiles.hpp"
+
+#include <array>
+#include <cstdio>
+#include <random>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+struct Vector {
+	size_t size;
+	const char* blake3;
+	const char* xxh3;
+};
+
+// Reference hashes of bytes i % 251 (from the reference implementations).
+const Vector VECTORS[] = {
+	{ 0, "af1349b9f5f9a1a6a0404dea36dcc9499bcb25c9adc112b7cc9a93cae41f3262", "99aa06d3014798d86001c324468d497f" },
+	{ 1, "2d3adedff11b61f14c886e35afa036736dcd87a74d27b5c1510225d0f592e213", "a6cd5e9392000f6ac44bdff4074eecdb" },
+	{ 64, "4eed7141ea4a5cd4b788606bd23f46e212af9cacebacdc7d1f4c6dc7f2511b98", "9c6e140a465545e590c1971ddb04ce74" },
+	{ 65, "de1e5fa0be70df6d2be8fffd0e99ceaa8eb6e8c93a63f2d8d1c30ecb6b263dee", "ebedf05eeadc28f11aee64a1615de88f" },
+	{ 1024, "42214739f095a406f3fc83deb889744ac00df831c10daa55189b5d121c855af7", "d0ac1f7b93bf57b9e5d78bafa45b2aa5" },
+	{ 1025, "d00278ae47eb27b34faecf67b4fe263f82d5412916c1ffd97c8cb7fb814b8444", "2882ebca04ec915ce95c42288f28186e" },
+	{ 2048, "e776b6028c7cd22a4d0ba182a8bf62205d2ef576467e838ed6f2529b85fba24a", "a5141efedfefc1af25339063db861586" },
+	{ 3073, "7124b49501012f81cc7f11ca069ec9226cecb8a2c850cfe644e327d22d3e1cd3", "5d57462ac5e1e28c6b63998099a1db88" },
+	{ 8193, "bab6c09cb8ce8cf459261398d2e7aef35700bf488116ceb94a36d0f5f1b7bc3b", "eaa446aa30f78391d6735a2b792cf505" },
+	{ 100000, "d93c23eedaf165a7e0be908ba86f1a7a520d568d2d13cde787c8580c5c72cc54", "54182c58bbb1337c42c23aeead96750d" },
+};
+
+std::vector<uint8_t> pattern(size_t size)
+{
+	std::vector<uint8_t> data(size);
+	for (size_t i = 0; i < size; i++)
+		data[i] = static_cast<uint8_t>(i % 251);
+	return data;
+}
+
+template <class H>
+std::string hex_hash(std::span<const uint8_t> data)
+{
+	H hash;
+	std::array<uint8_t, H::HASH_SIZE> out;
+	hash.hash(out, data);
+
+	std::string text;
+	for (uint8_t b : out) {
+		text += "0123456789abcdef"[b >> 4];
+		text += "0123456789abcdef"[b & 15];
+	}
+	return text;
+}
+
+// Incremental hashing with pieces of varying size must give the one-shot hash.
+template <class H>
+void check_incremental()
+{
+	std::mt19937 rng(0x5EEDu);
+	std::vector<uint8_t> data(20000);
+	for (auto& b : data)
+		b = static_cast<uint8_t>(rng());
+
+	H hash;
+	std::array<uint8_t, H::HASH_SIZE> expected, result;
+	for (size_t size : { 0, 1, 16, 17, 128, 129, 240, 241, 255, 256, 257, 1023, 1024, 1025, 4096, 20000 }) {
+		const std::span<const uint8_t> input(data.data(), size);
+		hash.hash(expected, input);
+		for (size_t piece : { size_t(1), size_t(63), size_t(64), size_t(300), size_t(1024), size_t(5000) }) {
+			hash.init();
+			for (size_t offset = 0; offset < size; offset += piece)
+				hash.update(input.subspan(offset, std::min(piece, size - offset)));
+			hash.final(result);
+			ASSERT_EQ(result, expected) << "size " << size << " piece " << piece;
+		}
+	}
+}
+
+} // namespace
+
+TEST(blake3, get_hash_size)
+{
+	BLAKE3 hash;
+	ASSERT_EQ(32, hash.get_hash_size());
+}
+
+TEST(blake3, known_vectors)
+{
+	for (const auto& v : VECTORS)
+		EXPECT_EQ(hex_hash<BLAKE3>(pattern(v.size)), v.blake3) << "size " << v.size;
+}
+
+TEST(blake3, incremental_matches_one_shot)
+{
+	check_incremental<BLAKE3>();
+}
+
+TEST(xxh3, get_hash_size)
+{
+	XXH3_128 hash;
+	ASSERT_EQ(16, hash.get_hash_size());
+}
+
+TEST(xxh3, known_vectors)
+{
+	for (const auto& v : VECTORS)
+		EXPECT_EQ(hex_hash<XXH3_128>(pattern(v.size)), v.xxh3) << "size " << v.size;
+}
+
+TEST(xxh3, incremental_matches_one_shot)
+{
+	check_incremental<XXH3_128>();
+}
+
+TEST(StrongHash, names)
+{
+	uint8_t id = 0;
+	EXPECT_TRUE(strong_hash_from_name("blake512", id));
+	EXPECT_EQ(id, BLAKE512::ID);
+	EXPECT_TRUE(strong_hash_from_name("blake3", id));
+	EXPECT_EQ(id, BLAKE3::ID);
+	EXPECT_STREQ(strong_hash_name(id), "blake3");
+	EXPECT_TRUE(strong_hash_from_name("xxh3", id));
+	EXPECT_EQ(id, XXH3_128::ID);
+	EXPECT_STREQ(strong_hash_name(id), "xxh3-128");
+	EXPECT_FALSE(strong_hash_from_name("md5", id));
+	EXPECT_STREQ(strong_hash_name(0), "unknown");
+
+	EXPECT_TRUE(strong_hash_from_size(16, id));
+	EXPECT_EQ(id, XXH3_128::ID);
+	EXPECT_FALSE(strong_hash_from_size(20, id));
+}
+
+TEST(StrongHash, version1_header_uses_blake512)
+{
+	std::array<uint8_t, DELTA_HEADER_SIZE> data = { 'R', 'H', 'D', 'T', 1, DefaultChunkingPolicy::ID, 0, 0 };
+	DeltaHeader header;
+	ASSERT_TRUE(decode_delta_header(data, header));
+	EXPECT_EQ(header.version, 1);
+	EXPECT_EQ(header.strong_hash, BLAKE512::ID);
+	EXPECT_EQ(header.hash_size, BLAKE512::HASH_SIZE);
+}
+
+template <class U>
+class StrongHashRoundTrip : public ::testing::Test {};
+
+using StrongHashTypes = ::testing::Types<BLAKE512, BLAKE3, XXH3_128>;
+TYPED_TEST_SUITE(StrongHashRoundTrip, StrongHashTypes);
+
+TYPED_TEST(StrongHashRoundTrip, delta)
+{
+	using U = TypeParam;
+	const std::string prefix = std::string("stronghash_t_") + U::NAME;
+	const std::string OLD = prefix + "_old", NEW = prefix + "_new", DELTA = prefix + "_delta", OUT = prefix + "_out";
+
+	auto data = random_bytes(200000, 0x33u);
+	write_bytes(OLD, data);
+	data[70000] ^= 0x5A;
+	data.insert(data.begin() + 120000, 100, 0x42);
+	write_bytes(NEW, data);
+
+	Signature<RKFinger, U> os, ns;
+	os.generate_signatures(OLD.c_str());
+	ns.generate_signatures(NEW.c_str());
+	Delta<RKFinger, U> d;
+	ASSERT_TRUE(d.generate_delta(os, ns, OLD.c_str(), NEW.c_str(), DELTA.c_str()).success);
+
+	DeltaHeader header;
+	ASSERT_TRUE(read_delta_header(DELTA, header));
+	EXPECT_EQ(header.version, DELTA_FORMAT_VERSION);
+	EXPECT_EQ(header.strong_hash, U::ID);
+	EXPECT_EQ(header.hash_size, U::HASH_SIZE);
+
+	Apply<RKFinger, U> apply;
+	auto ar = apply.apply_delta(OLD.c_str(), DELTA.c_str(), OUT.c_str());
+	ASSERT_TRUE(ar.success) << ar.error_message;
+	EXPECT_EQ(read_all(NEW), read_all(OUT));
+
+	// Old chunks hashed with another strong hash would never match the delta.
+	using Other = std::conditional_t<std::is_same_v<U, BLAKE512>, BLAKE3, BLAKE512>;
+	Apply<RKFinger, Other> wrong;
+	auto wrong_result = wrong.apply_delta(OLD.c_str(), DELTA.c_str(), OUT.c_str());
+	EXPECT_FALSE(wrong_result.success);
+	EXPECT_EQ(wrong_result.error_message, std::string("Delta uses different strong hash: ") + U::NAME);
+
+	for (const auto& p : { OLD, NEW, DELTA, OUT })
+		std::remove(p.c_str());
+}
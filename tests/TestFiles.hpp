@@ -0,0 +1,56 @@
+#ifndef TESTFILES_HPP
+#define TESTFILES_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+* Generate reproducible random data.
+* @param[in] size number of bytes
+* @param[in] seed generator seed
+* @return Random bytes.
+*/
+inline std::vector<uint8_t> random_bytes(size_t size, uint32_t seed)
+{
+	std::vector<uint8_t> data(size);
+	std::mt19937 rng(seed);
+	std::uniform_int_distribution<int> dist(0, 255);
+	for (auto& b : data)
+		b = static_cast<uint8_t>(dist(rng));
+	return data;
+}
+
+/**
+* Replace contents of the file with the given bytes.
+* @param[in] path file path
+* @param[in] bytes new contents
+*/
+inline void write_bytes(const std::string& path, const std::vector<uint8_t>& bytes)
+{
+	std::ofstream f(path, std::ios::binary);
+	if (!bytes.empty())
+		f.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+}
+
+/**
+* Read the whole file.
+* @param[in] path file path
+* @return File contents, empty if the file cannot be opened.
+*/
+inline std::vector<uint8_t> read_all(const std::string& path)
+{
+	std::ifstream f(path, std::ios::binary | std::ios::ate);
+	if (!f) return {};
+	auto size = f.tellg();
+	f.seekg(0);
+	std::vector<uint8_t> buf(static_cast<size_t>(size));
+	if (size > 0)
+		f.read(reinterpret_cast<char*>(buf.data()), buf.size());
+	return buf;
+}
+
+#endif